@@ -142,6 +142,10 @@ int SSI2001 = 0;				/* (C) sound option */
 int voodoo_enabled = 0;			/* (C) video option */
 uint32_t mem_size = 0;				/* (C) memory size */
 int	cpu_use_dynarec = 0;			/* (C) cpu uses/needs Dyna */
+int	dynarec_cache_size = 0;			/* (C) Dyna code cache size in MB */
+int	mmu_tlb_size = 0;			/* (C) soft TLB entries */
+int	mmu_tlb_ways = 0;			/* (C) soft TLB associativity */
+int	cpu_decode_cache = 0;			/* (C) interpreter EA decode cache */
 int cpu = 0;				/* (C) cpu type */
 int fpu_type = 0;				/* (C) fpu type */
 int	time_sync = 0;				/* (C) enable time sync */
@@ -0,0 +1,348 @@
+/*
+ * 86Box	A hypervisor and IBM PC system emulator that specializes in
+ *		running old operating systems and software designed for IBM
+ *		PC systems and compatibles from 1981 through fairly recent
+ *		system designs based on the PCI bus.
+ *
+ *		This file is part of the 86Box distribution.
+ *
+ *		Page lookup table benchmark.
+ *
+ *		Sets up readlookup2-style tables the way a machine with
+ *		the given amount of RAM uses them, in three layouts: flat
+ *		and left as demand-zero memory with LOOKUP_INV 0 as now, a
+ *		two-level table with lazily allocated leaves, and flat and
+ *		filled with -1 on reset as before. For each it reports the
+ *		host memory the three tables take once mapped (counted with
+ *		mincore(), so only on Linux), and the time of a
+ *		readmemb()-style access, both for a DOS workload within the
+ *		first megabyte and for accesses spread over all of RAM.
+ *
+ *		Usage: mem_bench [RAM in KB] [passes]
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <wchar.h>
+#ifdef __linux__
+# include <sys/mman.h>
+#endif
+#include <86box/86box.h>
+#include "cpu.h"
+
+
+#define TABLE_ENTRIES	(1 << 20)
+#define TABLE_SIZE	(TABLE_ENTRIES * sizeof(uintptr_t))
+#define LEAF_SHIFT	10
+#define LEAF_ENTRIES	(1 << LEAF_SHIFT)
+#define NUM_ADDRS	(1 << 16)
+
+/* What LOOKUP_INV was before the tables were left sparse. */
+#define OLD_LOOKUP_INV	((uintptr_t) -1)
+
+
+/* The memset layout goes last: once its tables are freed, glibc serves the
+   next large calloc() from the heap and has to clear it, which would make
+   the tables of the layouts after it resident. */
+enum {
+    LAYOUT_FLAT_CALLOC = 0,
+    LAYOUT_TWO_LEVEL,
+    LAYOUT_FLAT_MEMSET,
+    LAYOUT_MAX
+};
+
+static const char	*layout_names[LAYOUT_MAX] = {
+    "flat, calloc, LOOKUP_INV 0",
+    "two-level, lazy leaves",
+    "flat, memset to -1"
+};
+
+
+/* The three tables of one layout: readlookup2, writelookup2 and page_lookup
+   for the flat ones, and their directories for the two-level one. */
+static uintptr_t	*tables[3];
+static uintptr_t	*leaf_inv;
+static uint8_t		*ram;
+static uint32_t		ram_size;
+static uint32_t		addrs_dos[NUM_ADDRS], addrs_all[NUM_ADDRS];
+static volatile uint32_t slow_count;
+
+
+/* Returns how many KB of the len bytes at p are resident in host memory. */
+static long
+bench_resident(void *p, size_t len)
+{
+#ifdef __linux__
+    uintptr_t start = (uintptr_t) p & ~((uintptr_t) 4095);
+    size_t pages = (((uintptr_t) p + len) - start + 4095) >> 12, c;
+    unsigned char *vec = (unsigned char *) malloc(pages);
+    long resident = 0;
+
+    if (mincore((void *) start, pages << 12, vec) == 0) {
+	for (c = 0; c < pages; c++)
+		resident += (vec[c] & 1) ? 4 : 0;
+    }
+    free(vec);
+
+    return resident;
+#else
+    return -1;
+#endif
+}
+
+
+static void
+table_set(int layout, uintptr_t *table, uint32_t page, uintptr_t val)
+{
+    uintptr_t *leaf;
+
+    if (layout != LAYOUT_TWO_LEVEL) {
+	table[page] = val;
+	return;
+    }
+
+    leaf = (uintptr_t *) table[page >> LEAF_SHIFT];
+    if (leaf == leaf_inv) {
+	leaf = (uintptr_t *) malloc(LEAF_ENTRIES * sizeof(uintptr_t));
+	memcpy(leaf, leaf_inv, LEAF_ENTRIES * sizeof(uintptr_t));
+	table[page >> LEAF_SHIFT] = (uintptr_t) leaf;
+    }
+    leaf[page & (LEAF_ENTRIES - 1)] = val;
+}
+
+
+/* Allocates the tables as a hard reset leaves them, then maps what a machine
+   with ram_size bytes of RAM maps: all of RAM, and the BIOS alias below 4 GB. */
+static void
+bench_setup(int layout)
+{
+    uint32_t page;
+    int c;
+
+    for (c = 0; c < 3; c++) {
+	switch (layout) {
+		case LAYOUT_FLAT_CALLOC:
+			tables[c] = (uintptr_t *) calloc(TABLE_ENTRIES, sizeof(uintptr_t));
+			break;
+		case LAYOUT_TWO_LEVEL:
+			tables[c] = (uintptr_t *) malloc((TABLE_ENTRIES / LEAF_ENTRIES) * sizeof(uintptr_t));
+			for (page = 0; page < (TABLE_ENTRIES / LEAF_ENTRIES); page++)
+				tables[c][page] = (uintptr_t) leaf_inv;
+			break;
+		case LAYOUT_FLAT_MEMSET:
+			tables[c] = (uintptr_t *) malloc(TABLE_SIZE);
+			memset(tables[c], 0xff, TABLE_SIZE);
+			break;
+	}
+    }
+
+    for (page = 0; page < (ram_size >> 12); page++) {
+	for (c = 0; c < 3; c++)
+		table_set(layout, tables[c], page, (uintptr_t) ram);
+    }
+    for (page = 0xfffe0; page < 0x100000; page++) {
+	for (c = 0; c < 3; c++)
+		table_set(layout, tables[c], page, (uintptr_t) ram + 0xe0000 - (uintptr_t) 0xfffe0000);
+    }
+}
+
+
+static void
+bench_free(int layout)
+{
+    uint32_t c, page;
+
+    for (c = 0; c < 3; c++) {
+	if (layout == LAYOUT_TWO_LEVEL) {
+		for (page = 0; page < (TABLE_ENTRIES / LEAF_ENTRIES); page++) {
+			if (tables[c][page] != (uintptr_t) leaf_inv)
+				free((void *) tables[c][page]);
+		}
+	}
+	free(tables[c]);
+    }
+}
+
+
+static long
+bench_tables_resident(int layout)
+{
+    uint32_t page;
+    long resident = 0;
+    int c;
+
+    for (c = 0; c < 3; c++) {
+	if (layout != LAYOUT_TWO_LEVEL) {
+		resident += bench_resident(tables[c], TABLE_SIZE);
+		continue;
+	}
+
+	resident += bench_resident(tables[c], (TABLE_ENTRIES / LEAF_ENTRIES) * sizeof(uintptr_t));
+	for (page = 0; page < (TABLE_ENTRIES / LEAF_ENTRIES); page++) {
+		if (tables[c][page] != (uintptr_t) leaf_inv)
+			resident += bench_resident((void *) tables[c][page], LEAF_ENTRIES * sizeof(uintptr_t));
+	}
+    }
+
+    return resident;
+}
+
+
+static uint8_t
+slow_readb(uint32_t addr)
+{
+    slow_count++;
+    return 0xff;
+}
+
+
+/* readmemb() as each layout would do it. */
+static uint32_t
+bench_flat_calloc(const uint32_t *addrs)
+{
+    uintptr_t *readlookup2 = tables[0];
+    uint32_t sum = 0, addr;
+    int c;
+
+    for (c = 0; c < NUM_ADDRS; c++) {
+	addr = addrs[c];
+	if (readlookup2[addr >> 12] == LOOKUP_INV)
+		sum += slow_readb(addr);
+	else
+		sum += *(uint8_t *) (readlookup2[addr >> 12] + (uintptr_t) addr);
+    }
+
+    return sum;
+}
+
+
+static uint32_t
+bench_two_level(const uint32_t *addrs)
+{
+    uintptr_t *readlookup2 = tables[0];
+    uintptr_t lookup;
+    uint32_t sum = 0, addr;
+    int c;
+
+    for (c = 0; c < NUM_ADDRS; c++) {
+	addr = addrs[c];
+	lookup = ((uintptr_t *) readlookup2[addr >> (12 + LEAF_SHIFT)])[(addr >> 12) & (LEAF_ENTRIES - 1)];
+	if (lookup == LOOKUP_INV)
+		sum += slow_readb(addr);
+	else
+		sum += *(uint8_t *) (lookup + (uintptr_t) addr);
+    }
+
+    return sum;
+}
+
+
+static uint32_t
+bench_flat_memset(const uint32_t *addrs)
+{
+    uintptr_t *readlookup2 = tables[0];
+    uint32_t sum = 0, addr;
+    int c;
+
+    for (c = 0; c < NUM_ADDRS; c++) {
+	addr = addrs[c];
+	if (readlookup2[addr >> 12] == OLD_LOOKUP_INV)
+		sum += slow_readb(addr);
+	else
+		sum += *(uint8_t *) (readlookup2[addr >> 12] + (uintptr_t) addr);
+    }
+
+    return sum;
+}
+
+
+static double
+bench_run(int layout, const uint32_t *addrs, int passes, uint32_t *sum)
+{
+    clock_t start, end;
+    int c;
+
+    *sum = 0;
+    start = clock();
+    for (c = 0; c < passes; c++) {
+	switch (layout) {
+		case LAYOUT_FLAT_CALLOC:
+			*sum += bench_flat_calloc(addrs);
+			break;
+		case LAYOUT_TWO_LEVEL:
+			*sum += bench_two_level(addrs);
+			break;
+		case LAYOUT_FLAT_MEMSET:
+			*sum += bench_flat_memset(addrs);
+			break;
+	}
+    }
+    end = clock();
+
+    if (end == start)
+	end++;
+
+    return ((double) (end - start) * 1000000000.0) / ((double) CLOCKS_PER_SEC * NUM_ADDRS * passes);
+}
+
+
+int
+main(int argc, char *argv[])
+{
+    int passes = 2000, layout, c;
+    uint32_t sums[LAYOUT_MAX][2];
+    double dos, all;
+    long resident;
+
+    ram_size = 640 << 10;
+    if (argc > 1)
+	ram_size = atoi(argv[1]) << 10;
+    if (argc > 2)
+	passes = atoi(argv[2]);
+    if (ram_size < (1 << 20))
+	ram_size = 1 << 20;
+
+    ram = (uint8_t *) malloc(ram_size);
+    srand(1);
+    for (c = 0; c < (int) ram_size; c++)
+	ram[c] = rand();
+
+    /* DOS code and data within the first megabyte, with the odd access to
+       unmapped memory above RAM. */
+    for (c = 0; c < NUM_ADDRS; c++) {
+	addrs_dos[c] = (rand() % (640 << 10));
+	if (!(c & 255))
+		addrs_dos[c] = 0x4000000 + (rand() & 0xfffff);
+	addrs_all[c] = (((uint32_t) rand() << 16) ^ rand()) % ram_size;
+    }
+
+    leaf_inv = (uintptr_t *) malloc(LEAF_ENTRIES * sizeof(uintptr_t));
+    for (c = 0; c < LEAF_ENTRIES; c++)
+	leaf_inv[c] = LOOKUP_INV;
+
+    printf("%u KB of RAM, %d passes\n\n", ram_size >> 10, passes);
+    printf("layout                        tables KB   ns/access DOS   ns/access all\n");
+
+    for (layout = 0; layout < LAYOUT_MAX; layout++) {
+	bench_setup(layout);
+	resident = bench_tables_resident(layout);
+
+	dos = bench_run(layout, addrs_dos, passes, &sums[layout][0]);
+	all = bench_run(layout, addrs_all, passes, &sums[layout][1]);
+
+	bench_free(layout);
+
+	printf("%-28s %10ld %15.2f %15.2f\n", layout_names[layout], resident, dos, all);
+    }
+
+    for (layout = 1; layout < LAYOUT_MAX; layout++) {
+	if ((sums[layout][0] != sums[0][0]) || (sums[layout][1] != sums[0][1])) {
+		printf("\n%s read different data\n", layout_names[layout]);
+		return 1;
+	}
+    }
+
+    return 0;
+}
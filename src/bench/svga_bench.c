@@ -0,0 +1,244 @@
+/*
+ * 86Box	A hypervisor and IBM PC system emulator that specializes in
+ *		running old operating systems and software designed for IBM
+ *		PC systems and compatibles from 1981 through fairly recent
+ *		system designs based on the PCI bus.
+ *
+ *		This file is part of the 86Box distribution.
+ *
+ *		SVGA scanline renderer benchmark.
+ *
+ *		Renders a synthetic 1024x768 frame through each packed pixel
+ *		renderer in vid_svga_render.c and reports pixels per second.
+ *		Every line is rendered twice: once from the start of VRAM,
+ *		where the renderers use their whole-line kernels, and once
+ *		from just before the end of VRAM, where the line wraps and
+ *		they fall back to the per-pixel loops. The two outputs are
+ *		compared first, so the benchmark also checks the kernels
+ *		against the loops.
+ *
+ *		Usage: svga_bench [frames]
+ */
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <wchar.h>
+#include <86box/86box.h>
+#include <86box/device.h>
+#include <86box/mem.h>
+#include <86box/timer.h>
+#include <86box/video.h>
+#include <86box/vid_svga.h>
+#include <86box/vid_svga_render.h>
+
+
+#define VRAM_SIZE	(4 << 20)
+#define FRAME_W		1024
+#define FRAME_H		768
+#define LINE_W		2304
+#define FRAME_SIZE	((FRAME_W * 4 * FRAME_H) + 64)
+/* Close enough to the end that every line rendered from there wraps, and a
+   whole number of pixels at every depth, as the per-pixel 24bpp loops do not
+   wrap a pixel that straddles the end. */
+#define WRAP_BASE	(VRAM_SIZE - 48)
+
+
+/* What the renderers take from the rest of the emulator. */
+bitmap_t	*buffer32;
+uint8_t		edatlookup[4][4];
+dbcs_font_t	*fontdatksc5601, *fontdatksc5601_user;
+int		overscan_x;
+uint32_t	*video_15to32, *video_16to32;
+
+
+typedef struct {
+    const char	*name;
+    void	(*render)(svga_t *svga);
+    int		bpp;
+} bench_mode_t;
+
+static const bench_mode_t modes[] = {
+    { "8bpp lowres",		svga_render_8bpp_lowres,	8  },
+    { "8bpp highres",		svga_render_8bpp_highres,	8  },
+    { "15bpp lowres",		svga_render_15bpp_lowres,	16 },
+    { "15bpp highres",		svga_render_15bpp_highres,	16 },
+    { "16bpp lowres",		svga_render_16bpp_lowres,	16 },
+    { "16bpp highres",		svga_render_16bpp_highres,	16 },
+    { "24bpp lowres",		svga_render_24bpp_lowres,	24 },
+    { "24bpp highres",		svga_render_24bpp_highres,	24 },
+    { "32bpp lowres",		svga_render_32bpp_lowres,	32 },
+    { "32bpp highres",		svga_render_32bpp_highres,	32 },
+    { "ABGR8888 highres",	svga_render_ABGR8888_highres,	32 },
+    { "RGBA8888 highres",	svga_render_RGBA8888_highres,	32 }
+};
+
+
+static svga_t	svga;
+static uint8_t	*frame;
+static uint32_t	*out[1];
+
+
+/* Same conversions as video_init(). */
+static uint32_t
+calc_15to32(int c)
+{
+    int b = (int) ((((double) (c & 31)) / 31.0) * 255.0);
+    int g = (int) ((((double) ((c >> 5) & 31)) / 31.0) * 255.0);
+    int r = (int) ((((double) ((c >> 10) & 31)) / 31.0) * 255.0);
+
+    return b | (g << 8) | (r << 16);
+}
+
+
+static uint32_t
+calc_16to32(int c)
+{
+    int b = (int) ((((double) (c & 31)) / 31.0) * 255.0);
+    int g = (int) ((((double) ((c >> 5) & 63)) / 63.0) * 255.0);
+    int r = (int) ((((double) ((c >> 11) & 31)) / 31.0) * 255.0);
+
+    return b | (g << 8) | (r << 16);
+}
+
+
+static void
+bench_init(void)
+{
+    int c;
+
+    buffer32 = calloc(1, sizeof(bitmap_t));
+    buffer32->w = LINE_W;
+    buffer32->h = FRAME_H;
+    buffer32->dat = calloc(LINE_W * FRAME_H, sizeof(uint32_t));
+    for (c = 0; c < FRAME_H; c++)
+	buffer32->line[c] = &buffer32->dat[c * LINE_W];
+
+    video_15to32 = malloc(65536 * sizeof(uint32_t));
+    video_16to32 = malloc(65536 * sizeof(uint32_t));
+    for (c = 0; c < 65536; c++) {
+	video_15to32[c] = calc_15to32(c & 0x7fff);
+	video_16to32[c] = calc_16to32(c);
+    }
+
+    svga.vram = malloc(VRAM_SIZE);
+    svga.vram_mask = svga.vram_display_mask = VRAM_SIZE - 1;
+    svga.changedvram = calloc((VRAM_SIZE >> 12) + 3, 1);
+    svga.crtc[0x17] = 0x80;
+    svga.hdisp = FRAME_W;
+    svga.map8 = svga.pallook;
+    for (c = 0; c < 256; c++)
+	svga.pallook[c] = (c * 0x010203) & 0xffffff;
+
+    frame = malloc(FRAME_SIZE);
+    srand(1);
+    for (c = 0; c < FRAME_SIZE; c++)
+	frame[c] = rand();
+
+    out[0] = malloc(LINE_W * sizeof(uint32_t));
+}
+
+
+/* Renders one line of the frame from VRAM at base into buffer32 line y. */
+static void
+bench_line(const bench_mode_t *mode, uint32_t base, int y)
+{
+    svga.ma = base & svga.vram_display_mask;
+    svga.displine = y;
+    svga.fullchange = 1;
+    mode->render(&svga);
+}
+
+
+/* Puts len bytes of the frame at offset in VRAM starting at base, wrapping at
+   the end. */
+static void
+bench_load(uint32_t base, uint32_t offset, uint32_t len)
+{
+    uint32_t c;
+
+    for (c = 0; c < len; c++)
+	svga.vram[(base + c) & svga.vram_mask] = frame[offset + c];
+}
+
+
+/* Renders every line of the frame both ways, returns whether they match. */
+static int
+bench_check(const bench_mode_t *mode)
+{
+    uint32_t pitch = (FRAME_W * mode->bpp) >> 3;
+    int y;
+
+    for (y = 0; y < FRAME_H; y++) {
+	bench_load(WRAP_BASE, y * pitch, pitch + 64);
+	bench_line(mode, WRAP_BASE, y);
+	memcpy(out[0], buffer32->line[y], LINE_W * sizeof(uint32_t));
+
+	bench_load(0, y * pitch, pitch + 64);
+	bench_line(mode, 0, y);
+
+	if (memcmp(out[0], buffer32->line[y], LINE_W * sizeof(uint32_t)))
+		return 0;
+    }
+
+    return 1;
+}
+
+
+/* Renders lines of the frame from VRAM at base for the given number of
+   frames, returns source pixels per second. Every line comes from the same
+   place, so that the wrapped case wraps on every line. */
+static double
+bench_run(const bench_mode_t *mode, uint32_t base, int frames)
+{
+    uint32_t pitch = (FRAME_W * mode->bpp) >> 3;
+    clock_t start, end;
+    int c, y;
+
+    bench_load(base, 0, pitch + 64);
+
+    start = clock();
+    for (c = 0; c < frames; c++) {
+	for (y = 0; y < FRAME_H; y++)
+		bench_line(mode, base, y);
+    }
+    end = clock();
+
+    if (end == start)
+	end++;
+
+    return ((double) FRAME_W * FRAME_H * frames * CLOCKS_PER_SEC) / (double) (end - start);
+}
+
+
+int
+main(int argc, char *argv[])
+{
+    int frames = 200, c, ret = 0;
+    double wrapped, linear;
+    const char *same;
+
+    if (argc > 1)
+	frames = atoi(argv[1]);
+
+    bench_init();
+
+    printf("mode                wrapped Mpix/s   linear Mpix/s   output\n");
+
+    for (c = 0; c < (int) (sizeof(modes) / sizeof(modes[0])); c++) {
+	same = "same";
+	if (!bench_check(&modes[c])) {
+		same = "DIFFERENT";
+		ret = 1;
+	}
+
+	wrapped = bench_run(&modes[c], WRAP_BASE, frames);
+	linear = bench_run(&modes[c], 0, frames);
+
+	printf("%-18s %15.0f %15.0f   %s\n", modes[c].name, wrapped / 1000000.0, linear / 1000000.0, same);
+    }
+
+    return ret;
+}
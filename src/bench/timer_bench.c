@@ -0,0 +1,168 @@
+/*
+ * 86Box	A hypervisor and IBM PC system emulator that specializes in
+ *		running old operating systems and software designed for IBM
+ *		PC systems and compatibles from 1981 through fairly recent
+ *		system designs based on the PCI bus.
+ *
+ *		This file is part of the 86Box distribution.
+ *
+ *		Timer scheduler microbenchmark.
+ *
+ *		Arms N self-rearming timers with different periods and
+ *		measures how many events per second timer_process() can
+ *		dispatch, once with the timers kept in the sorted list and
+ *		once with them kept in the heap. This is what TIMER_HEAP_MIN
+ *		is picked from.
+ *
+ *		Usage: timer_bench [ticks]
+ */
+#include <limits.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <wchar.h>
+#include <86box/86box.h>
+#include <86box/timer.h>
+
+
+#define MAX_TIMERS	256
+
+
+uint64_t	tsc;
+
+static pc_timer_t	timers[MAX_TIMERS], idle_timer;
+static uint64_t		periods[MAX_TIMERS];
+static uint64_t		events;
+static int		order[3], order_pos;
+
+
+void
+fatal(const char *fmt, ...)
+{
+    va_list ap;
+
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    va_end(ap);
+
+    exit(1);
+}
+
+
+static void
+bench_callback(void *p)
+{
+    pc_timer_t *timer = (pc_timer_t *) p;
+
+    events++;
+    timer_advance_u64(timer, periods[timer - timers]);
+}
+
+
+static void
+order_callback(void *p)
+{
+    if (order_pos < 3)
+	order[order_pos++] = (int) ((pc_timer_t *) p - timers);
+}
+
+
+/* timer_process() expects at least one timer to be enabled, like a real
+   machine always has. */
+static void
+bench_start(int heap_min)
+{
+    timer_close();
+    timer_init();
+    timer_heap_min = heap_min;
+
+    timer_add(&idle_timer, NULL, NULL, 0);
+    timer_set_delay_u64(&idle_timer, 0xffffffffULL << 31);
+}
+
+
+/* Runs n timers for the given number of TSC ticks, returns events per second. */
+static double
+bench_run(int n, int heap_min, uint32_t ticks)
+{
+    clock_t start, end;
+    int c;
+
+    bench_start(heap_min);
+    events = 0;
+
+    /* Periods of 1 to 97 us with a fractional part, so that few timers
+       expire on the same tick. */
+    for (c = 0; c < n; c++) {
+	periods[c] = ((uint64_t) (1 + (c % 97)) << 32) + ((uint64_t) c * 104729);
+	timer_add(&timers[c], bench_callback, &timers[c], 0);
+	timer_set_delay_u64(&timers[c], periods[c]);
+    }
+
+    start = clock();
+    for (tsc = 0; tsc < ticks; tsc++) {
+	if (TIMER_VAL_LESS_THAN_VAL(timer_target, (uint32_t) tsc))
+		timer_process();
+    }
+    end = clock();
+
+    if (end == start)
+	end++;
+
+    return ((double) events * CLOCKS_PER_SEC) / (double) (end - start);
+}
+
+
+/* Timers with equal timestamps must fire newest first in both modes. */
+static int
+order_check(int heap_min)
+{
+    int c;
+
+    bench_start(heap_min);
+    order_pos = 0;
+
+    for (c = 0; c < 3; c++) {
+	timer_add(&timers[c], order_callback, &timers[c], 0);
+	timer_set_delay_u64(&timers[c], 10ULL << 32);
+    }
+
+    for (tsc = 0; tsc < 20; tsc++) {
+	if (TIMER_VAL_LESS_THAN_VAL(timer_target, (uint32_t) tsc))
+		timer_process();
+    }
+
+    return (order_pos == 3) && (order[0] == 2) && (order[1] == 1) && (order[2] == 0);
+}
+
+
+int
+main(int argc, char *argv[])
+{
+    static const int counts[] = { 8, 16, 32, 64, 96, 128, 192, 256 };
+    uint32_t ticks = 2000000;
+    double list, heap;
+    int c;
+
+    if (argc > 1)
+	ticks = strtoul(argv[1], NULL, 0);
+
+    if (!order_check(INT_MAX) || !order_check(0)) {
+	printf("equal timestamps fired out of order\n");
+	return 1;
+    }
+
+    printf("TIMER_HEAP_MIN is %i\n\n", TIMER_HEAP_MIN);
+    printf("timers   list Mevents/s   heap Mevents/s\n");
+
+    for (c = 0; c < (int) (sizeof(counts) / sizeof(counts[0])); c++) {
+	list = bench_run(counts[c], INT_MAX, ticks);
+	heap = bench_run(counts[c], 0, ticks);
+	printf("%6i   %15.2f   %15.2f\n", counts[c], list / 1000000.0, heap / 1000000.0);
+    }
+
+    return 0;
+}
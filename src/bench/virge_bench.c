@@ -0,0 +1,307 @@
+/*
+ * 86Box	A hypervisor and IBM PC system emulator that specializes in
+ *		running old operating systems and software designed for IBM
+ *		PC systems and compatibles from 1981 through fairly recent
+ *		system designs based on the PCI bus.
+ *
+ *		This file is part of the 86Box distribution.
+ *
+ *		S3 ViRGE 3D triangle benchmark.
+ *
+ *		Records a fixed set of triangles for each of a number of
+ *		colour, texture format, filter and blend modes, then replays
+ *		them through s3_virge_triangle() the way the render thread
+ *		does and reports pixels per second. The triangles and the
+ *		texture are generated from a fixed seed, and a hash of the
+ *		frame and Z buffers is printed for each mode, so runs
+ *		against different versions of vid_s3_virge.c can be checked
+ *		for identical output.
+ *
+ *		Usage: virge_bench [passes]
+ */
+#include "../video/vid_s3_virge.c"
+#include <time.h>
+
+
+#define VRAM_SIZE	(4 << 20)
+#define SCREEN_W	640
+#define SCREEN_H	480
+#define DEST_BASE	0
+#define Z_BASE		(1 << 20)
+#define TEX_BASE	(2 << 20)
+#define NUM_TRIS	512
+
+/* 16bpp destination, 256x256 texture, Z buffer with >= compare and update. */
+#define CMD_BASE	((1 << 2) | (8 << 8) | (3 << 20) | CMD_SET_ZUP | CMD_SET_TWE)
+#define CMD_GOURAUD	(0 << 27)
+#define CMD_LIT		(1 << 27)
+#define CMD_UNLIT	(2 << 27)
+#define CMD_PERSP	(1 << 29)
+#define TEX_8888	(0 << 5)
+#define TEX_4444	(1 << 5)
+#define TEX_1555	(2 << 5)
+#define FILT_MIPMAP	(0 << 12)
+#define FILT_MIPMAP_BI	(2 << 12)
+#define FILT_POINT	(4 << 12)
+#define FILT_BILINEAR	(6 << 12)
+#define BLEND_REFLECT	(0 << 15)
+#define BLEND_MODULATE	(1 << 15)
+#define BLEND_DECAL	(2 << 15)
+
+
+/* What the driver takes from the rest of the emulator. None of these are
+   used by the triangle path. */
+bitmap_t	*buffer32;
+int		changeframecount = 2;
+double		cpuclock = 100000000.0;
+uint32_t	*video_15to32, *video_16to32;
+
+void	*ddc_init(void *i2c) { return NULL; }
+void	ddc_close(void *eeprom) { }
+int	device_get_config_int(const char *name) { return 0; }
+void	*i2c_gpio_init(char *bus_name) { return NULL; }
+void	i2c_gpio_close(void *dev_handle) { }
+void	*i2c_gpio_get_bus() { return NULL; }
+void	i2c_gpio_set(void *dev_handle, uint8_t scl, uint8_t sda) { }
+uint8_t	i2c_gpio_get_scl(void *dev_handle) { return 1; }
+uint8_t	i2c_gpio_get_sda(void *dev_handle) { return 1; }
+void	io_sethandler(uint16_t base, int size,
+		      uint8_t (*inb)(uint16_t addr, void *priv),
+		      uint16_t (*inw)(uint16_t addr, void *priv),
+		      uint32_t (*inl)(uint16_t addr, void *priv),
+		      void (*outb)(uint16_t addr, uint8_t val, void *priv),
+		      void (*outw)(uint16_t addr, uint16_t val, void *priv),
+		      void (*outl)(uint16_t addr, uint32_t val, void *priv),
+		      void *priv) { }
+void	io_removehandler(uint16_t base, int size,
+			 uint8_t (*inb)(uint16_t addr, void *priv),
+			 uint16_t (*inw)(uint16_t addr, void *priv),
+			 uint32_t (*inl)(uint16_t addr, void *priv),
+			 void (*outb)(uint16_t addr, uint8_t val, void *priv),
+			 void (*outw)(uint16_t addr, uint16_t val, void *priv),
+			 void (*outl)(uint16_t addr, uint32_t val, void *priv),
+			 void *priv) { }
+void	mem_mapping_add(mem_mapping_t *mapping, uint32_t base, uint32_t size,
+			uint8_t  (*read_b)(uint32_t addr, void *p),
+			uint16_t (*read_w)(uint32_t addr, void *p),
+			uint32_t (*read_l)(uint32_t addr, void *p),
+			void (*write_b)(uint32_t addr, uint8_t  val, void *p),
+			void (*write_w)(uint32_t addr, uint16_t val, void *p),
+			void (*write_l)(uint32_t addr, uint32_t val, void *p),
+			uint8_t *exec, uint32_t flags, void *p) { }
+void	mem_mapping_set_addr(mem_mapping_t *mapping, uint32_t base, uint32_t size) { }
+void	mem_mapping_disable(mem_mapping_t *mapping) { }
+uint8_t	pci_add_card(uint8_t add_type, uint8_t (*read)(int func, int addr, void *priv),
+		     void (*write)(int func, int addr, uint8_t val, void *priv), void *priv) { return 0; }
+void	pci_set_irq(uint8_t card, uint8_t pci_int) { }
+void	pci_clear_irq(uint8_t card, uint8_t pci_int) { }
+uint64_t plat_timer_read(void) { return 0; }
+int	rom_init(rom_t *rom, wchar_t *fn, uint32_t address, int size,
+		 int mask, int file_offset, uint32_t flags) { return -1; }
+int	rom_present(wchar_t *fn) { return 0; }
+int	svga_init(const device_t *info, svga_t *svga, void *p, int memsize,
+		  void (*recalctimings_ex)(struct svga_t *svga),
+		  uint8_t (*video_in) (uint16_t addr, void *p),
+		  void    (*video_out)(uint16_t addr, uint8_t val, void *p),
+		  void (*hwcursor_draw)(struct svga_t *svga, int displine),
+		  void (*overlay_draw)(struct svga_t *svga, int displine)) { return 0; }
+void	svga_close(svga_t *svga) { }
+void	svga_recalctimings(svga_t *svga) { }
+uint8_t	svga_in(uint16_t addr, void *p) { return 0xff; }
+void	svga_out(uint16_t addr, uint8_t val, void *p) { }
+uint8_t	svga_read_linear(uint32_t addr, void *p) { return 0xff; }
+uint16_t svga_readw_linear(uint32_t addr, void *p) { return 0xffff; }
+uint32_t svga_readl_linear(uint32_t addr, void *p) { return 0xffffffff; }
+void	svga_write_linear(uint32_t addr, uint8_t val, void *p) { }
+void	svga_writew_linear(uint32_t addr, uint16_t val, void *p) { }
+void	svga_writel_linear(uint32_t addr, uint32_t val, void *p) { }
+void	svga_render_8bpp_highres(svga_t *svga) { }
+void	svga_render_15bpp_highres(svga_t *svga) { }
+void	svga_render_16bpp_highres(svga_t *svga) { }
+void	svga_render_24bpp_highres(svga_t *svga) { }
+void	svga_render_32bpp_highres(svga_t *svga) { }
+thread_t *thread_create(void (*thread_func)(void *param), void *param) { return NULL; }
+void	thread_kill(thread_t *arg) { }
+event_t	*thread_create_event(void) { return NULL; }
+void	thread_set_event(event_t *arg) { }
+void	thread_reset_event(event_t *arg) { }
+int	thread_wait_event(event_t *arg, int timeout) { return 0; }
+void	thread_destroy_event(event_t *arg) { }
+void	video_inform(int type, const video_timings_t *ptr) { }
+
+
+typedef struct {
+    const char	*name;
+    uint32_t	cmd_set;
+    int		chip;
+} bench_mode_t;
+
+static const bench_mode_t modes[] = {
+    { "gouraud",			CMD_GOURAUD,						S3_VIRGE   },
+    { "unlit 1555 point",		CMD_UNLIT | TEX_1555 | FILT_POINT,			S3_VIRGE   },
+    { "unlit 1555 bilinear",		CMD_UNLIT | TEX_1555 | FILT_BILINEAR,			S3_VIRGE   },
+    { "modulate 4444 bilinear",		CMD_LIT | BLEND_MODULATE | TEX_4444 | FILT_BILINEAR,	S3_VIRGE   },
+    { "modulate 8888 mipmap bi",	CMD_LIT | BLEND_MODULATE | TEX_8888 | FILT_MIPMAP_BI,	S3_VIRGE   },
+    { "decal 1555 persp bi",		CMD_LIT | CMD_PERSP | BLEND_DECAL | TEX_1555 | FILT_BILINEAR, S3_VIRGE },
+    { "reflect 8888 persp mip",		CMD_LIT | CMD_PERSP | BLEND_REFLECT | TEX_8888 | FILT_MIPMAP, S3_VIRGEDX },
+    { "unlit 4444 persp bi alpha",	CMD_UNLIT | CMD_PERSP | TEX_4444 | FILT_BILINEAR | CMD_SET_ABC_ENABLE, S3_VIRGEDX }
+};
+
+
+static virge_t	virge;
+static s3d_t	tris[NUM_TRIS];
+
+
+static int
+bench_rand(int min, int max)
+{
+    return min + (rand() % (max - min + 1));
+}
+
+
+/* Records NUM_TRIS right-angled triangles with the left edge vertical and
+   random size, position and gradients, as queue_triangle() would see them. */
+static void
+bench_record(uint32_t cmd_set)
+{
+    s3d_t *s3d_tri;
+    int c, w, h, x, y;
+
+    srand(1);
+
+    for (c = 0; c < NUM_TRIS; c++) {
+	s3d_tri = &tris[c];
+	memset(s3d_tri, 0, sizeof(s3d_t));
+
+	w = bench_rand(16, 96);
+	h = bench_rand(16, 96);
+	x = bench_rand(0, SCREEN_W - w - 1);
+	y = bench_rand(h, SCREEN_H - 1);
+
+	s3d_tri->cmd_set = cmd_set;
+	s3d_tri->dest_base = DEST_BASE;
+	s3d_tri->dest_str = SCREEN_W * 2;
+	s3d_tri->z_base = Z_BASE;
+	s3d_tri->z_str = SCREEN_W * 2;
+	s3d_tri->tex_base = TEX_BASE;
+
+	s3d_tri->tys = y;
+	s3d_tri->txs = x << 20;
+	s3d_tri->txend01 = (x + w) << 20;
+	s3d_tri->TdXdY02 = 0;
+	s3d_tri->TdXdY01 = -((w << 20) / h);
+	s3d_tri->ty01 = h;
+	s3d_tri->ty12 = 0;
+	s3d_tri->tlr = 1;
+
+	/* One texel is 1 << 19 at level 8. */
+	s3d_tri->tus = bench_rand(0, 255) << 19;
+	s3d_tri->tvs = bench_rand(0, 255) << 19;
+	s3d_tri->TdUdX = bench_rand(1 << 17, 1 << 20);
+	s3d_tri->TdVdX = bench_rand(-(1 << 17), 1 << 17);
+	s3d_tri->TdUdY = bench_rand(-(1 << 17), 1 << 17);
+	s3d_tri->TdVdY = -bench_rand(1 << 17, 1 << 20);
+
+	/* Perspective divides by w, 1 << 26 leaves u and v as they are. */
+	s3d_tri->tws = (1 << 26) + bench_rand(0, 1 << 22);
+	s3d_tri->TdWdX = bench_rand(-(1 << 14), 1 << 14);
+	s3d_tri->TdWdY = bench_rand(-(1 << 14), 1 << 14);
+
+	s3d_tri->tds = bench_rand(0, 2 << 27);
+	s3d_tri->TdDdX = bench_rand(-(1 << 20), 1 << 20);
+	s3d_tri->TdDdY = bench_rand(-(1 << 20), 1 << 20);
+
+	s3d_tri->tzs = bench_rand(0, 0x7fff) << 15;
+	s3d_tri->TdZdX = bench_rand(-(1 << 12), 1 << 12);
+	s3d_tri->TdZdY = bench_rand(-(1 << 12), 1 << 12);
+
+	s3d_tri->trs = bench_rand(32, 224) << 7;
+	s3d_tri->tgs = bench_rand(32, 224) << 7;
+	s3d_tri->tbs = bench_rand(32, 224) << 7;
+	s3d_tri->tas = bench_rand(32, 224) << 7;
+	s3d_tri->TdRdX = bench_rand(-64, 64);
+	s3d_tri->TdGdX = bench_rand(-64, 64);
+	s3d_tri->TdBdX = bench_rand(-64, 64);
+	s3d_tri->TdAdX = bench_rand(-64, 64);
+	s3d_tri->TdRdY = bench_rand(-64, 64);
+	s3d_tri->TdGdY = bench_rand(-64, 64);
+	s3d_tri->TdBdY = bench_rand(-64, 64);
+	s3d_tri->TdAdY = bench_rand(-64, 64);
+    }
+}
+
+
+static void
+bench_replay(void)
+{
+    int c;
+
+    for (c = 0; c < NUM_TRIS; c++)
+	s3_virge_triangle(&virge, &tris[c]);
+}
+
+
+/* FNV-1a of the frame and Z buffers. */
+static uint32_t
+bench_hash(void)
+{
+    uint32_t hash = 0x811c9dc5;
+    int c;
+
+    for (c = 0; c < (SCREEN_W * SCREEN_H * 2); c++)
+	hash = (hash ^ virge.svga.vram[DEST_BASE + c]) * 0x01000193;
+    for (c = 0; c < (SCREEN_W * SCREEN_H * 2); c++)
+	hash = (hash ^ virge.svga.vram[Z_BASE + c]) * 0x01000193;
+
+    return hash;
+}
+
+
+int
+main(int argc, char *argv[])
+{
+    int passes = 20, c, p;
+    uint64_t pixels;
+    uint32_t hash;
+    clock_t start, end;
+
+    if (argc > 1)
+	passes = atoi(argv[1]);
+
+    virge.svga.vram = malloc(VRAM_SIZE);
+    virge.svga.vram_mask = VRAM_SIZE - 1;
+    virge.svga.changedvram = calloc((VRAM_SIZE >> 12) + 1, 1);
+    virge.bilinear_enabled = 1;
+
+    printf("mode                         Mpix/s   hash\n");
+
+    for (c = 0; c < (int) (sizeof(modes) / sizeof(modes[0])); c++) {
+	virge.chip = modes[c].chip;
+	bench_record(CMD_BASE | modes[c].cmd_set);
+
+	srand(2);
+	for (p = 0; p < VRAM_SIZE; p++)
+		virge.svga.vram[p] = rand();
+	memset(&virge.svga.vram[Z_BASE], 0, SCREEN_W * SCREEN_H * 2);
+
+	/* The first pass starts from a known buffer, so its output can be
+	   compared between builds. */
+	bench_replay();
+	hash = bench_hash();
+
+	virge.pixel_count = 0;
+	start = clock();
+	for (p = 0; p < passes; p++)
+		bench_replay();
+	end = clock();
+	pixels = virge.pixel_count;
+
+	if (end == start)
+		end++;
+
+	printf("%-26s %8.1f   %08x\n", modes[c].name,
+	       ((double) pixels * CLOCKS_PER_SEC) / ((double) (end - start) * 1000000.0), hash);
+    }
+
+    return 0;
+}
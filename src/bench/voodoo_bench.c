@@ -0,0 +1,165 @@
+/*
+ * 86Box	A hypervisor and IBM PC system emulator that specializes in
+ *		running old operating systems and software designed for IBM
+ *		PC systems and compatibles from 1981 through fairly recent
+ *		system designs based on the PCI bus.
+ *
+ *		This file is part of the 86Box distribution.
+ *
+ *		Voodoo interpreter bilinear filter benchmark.
+ *
+ *		Filters a span of random texels with voodoo_bilinear() and
+ *		with the per-channel sums it replaced, checks that the two
+ *		agree for every pixel and every possible weight, and
+ *		reports the time per pixel of each.
+ *
+ *		Usage: voodoo_bench [passes]
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <time.h>
+#include <wchar.h>
+#include <86box/86box.h>
+#include "cpu.h"
+#include <86box/machine.h>
+#include <86box/device.h>
+#include <86box/mem.h>
+#include <86box/timer.h>
+#include <86box/plat.h>
+#include <86box/video.h>
+#include <86box/vid_svga.h>
+#include <86box/vid_voodoo_common.h>
+#include <86box/vid_voodoo_regs.h>
+#include <86box/vid_voodoo_render.h>
+
+
+#define SPAN_LEN	4096
+
+
+static rgba_u	texels[SPAN_LEN + 1][2];
+static int	weights[256][4];
+static uint32_t	out[SPAN_LEN];
+
+
+/* The filter as the interpreter did it before voodoo_bilinear(). */
+static uint32_t
+bilinear_ref(const rgba_u *dat, const int *d)
+{
+    int r, g, b, a;
+
+    r = (dat[0].rgba.r * d[0] + dat[1].rgba.r * d[1] + dat[2].rgba.r * d[2] + dat[3].rgba.r * d[3]) >> 8;
+    g = (dat[0].rgba.g * d[0] + dat[1].rgba.g * d[1] + dat[2].rgba.g * d[2] + dat[3].rgba.g * d[3]) >> 8;
+    b = (dat[0].rgba.b * d[0] + dat[1].rgba.b * d[1] + dat[2].rgba.b * d[2] + dat[3].rgba.b * d[3]) >> 8;
+    a = (dat[0].rgba.a * d[0] + dat[1].rgba.a * d[1] + dat[2].rgba.a * d[2] + dat[3].rgba.a * d[3]) >> 8;
+
+    return b | (g << 8) | (r << 16) | ((uint32_t) a << 24);
+}
+
+
+static uint32_t
+bilinear_new(const rgba_u *dat, const int *d)
+{
+    uint64_t sum = voodoo_bilinear(dat, d);
+
+    return ((sum >> 8) & 0xff) | ((sum >> 16) & 0xff00) |
+	   ((sum >> 24) & 0xff0000) | ((uint32_t) (sum >> 32) & 0xff000000);
+}
+
+
+/* Filters one span the way tex_read_4() walks it, two texel rows at a time.
+   The filter is called through a volatile pointer so that the compiler can't
+   vectorise it across pixels, which the interpreter can't do either. */
+static uint32_t (*volatile filter)(const rgba_u *dat, const int *d);
+
+
+static void
+span(void)
+{
+    rgba_u dat[4];
+    int x;
+
+    for (x = 0; x < SPAN_LEN; x++) {
+	dat[0] = texels[x][0];
+	dat[1] = texels[x + 1][0];
+	dat[2] = texels[x][1];
+	dat[3] = texels[x + 1][1];
+	out[x] = filter(dat, weights[(x * 7) & 0xff]);
+    }
+}
+
+
+static double
+time_span(uint32_t (*func)(const rgba_u *dat, const int *d), int passes)
+{
+    clock_t start, end;
+    int c;
+
+    filter = func;
+
+    start = clock();
+    for (c = 0; c < passes; c++)
+	span();
+    end = clock();
+
+    if (end == start)
+	end++;
+
+    return ((double) (end - start) * 1000000000.0) / ((double) CLOCKS_PER_SEC * passes * SPAN_LEN);
+}
+
+
+int
+main(int argc, char *argv[])
+{
+    rgba_u dat[4];
+    int passes = 20000;
+    int c, x, s, t;
+
+    if (argc > 1)
+	passes = atoi(argv[1]);
+
+    srand(1);
+    for (x = 0; x <= SPAN_LEN; x++) {
+	for (c = 0; c < 2; c++)
+		texels[x][c].u = ((uint32_t) rand() << 16) ^ (uint32_t) rand();
+    }
+
+    for (c = 0; c < 256; c++) {
+	s = c & 0xf;
+	t = c >> 4;
+	weights[c][0] = (16 - s) * (16 - t);
+	weights[c][1] = s * (16 - t);
+	weights[c][2] = (16 - s) * t;
+	weights[c][3] = s * t;
+    }
+
+    /* Every weight against every texel in the span, plus all-0xff texels,
+       which are the largest sums. */
+    for (c = 0; c < 256; c++) {
+	for (x = 0; x < SPAN_LEN; x++) {
+		dat[0] = texels[x][0];
+		dat[1] = texels[x + 1][0];
+		dat[2] = texels[x][1];
+		dat[3] = texels[x + 1][1];
+		if (bilinear_ref(dat, weights[c]) != bilinear_new(dat, weights[c])) {
+			printf("mismatch at x=%i, weights %i\n", x, c);
+			return 1;
+		}
+	}
+
+	dat[0].u = dat[1].u = dat[2].u = dat[3].u = 0xffffffff;
+	if (bilinear_new(dat, weights[c]) != 0xffffffff) {
+		printf("mismatch for white texels, weights %i\n", c);
+		return 1;
+	}
+    }
+
+    printf("output matches the per-channel filter\n\n");
+    printf("per-channel   %6.2f ns/pixel\n", time_span(bilinear_ref, passes));
+    printf("packed        %6.2f ns/pixel\n", time_span(bilinear_new, passes));
+
+    return 0;
+}
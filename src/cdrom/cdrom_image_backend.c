@@ -72,30 +72,122 @@ cdrom_image_backend_log(const char *fmt, ...)
 
 /* Binary file functions. */
 static int
-bin_read(void *p, uint8_t *buffer, uint64_t seek, size_t count)
+bin_read_block(track_file_t *tf, uint64_t block)
 {
-    track_file_t *tf = (track_file_t *) p;
+    uint32_t i, slot = 0, age, oldest = 0;
+    size_t len;
 
-    cdrom_image_backend_log("CDROM: binary_read(%08lx, pos=%" PRIu64 " count=%lu\n",
-		     tf->file, seek, count);
+    for (i = 0; i < CDI_CACHE_BLOCKS; i++) {
+	if (tf->cache_block[i] == (block + 1))
+		return i;
+    }
 
-    if (tf->file == NULL)
-	return 0;
+    /* Use an empty slot if there is one, otherwise the least recently used. */
+    for (i = 0; i < CDI_CACHE_BLOCKS; i++) {
+	if (!tf->cache_block[i]) {
+		slot = i;
+		break;
+	}
+
+	age = tf->cache_clock - tf->cache_used[i];
+	if (age >= oldest) {
+		oldest = age;
+		slot = i;
+	}
+    }
 
-    if (fseeko64(tf->file, seek, SEEK_SET) == -1) {
+    if (fseeko64(tf->file, block * CDI_CACHE_BLOCK_SIZE, SEEK_SET) == -1) {
 #ifdef ENABLE_CDROM_IMAGE_BACKEND_LOG
 	cdrom_image_backend_log("CDROM: binary_read failed during seek!\n");
 #endif
-	return 0;
+	return -1;
     }
 
-    if (fread(buffer, count, 1, tf->file) != 1) {
+    tf->cache_block[slot] = 0;
+    len = fread(&tf->cache[slot * CDI_CACHE_BLOCK_SIZE], 1, CDI_CACHE_BLOCK_SIZE, tf->file);
+    if (len == 0) {
 #ifdef ENABLE_CDROM_IMAGE_BACKEND_LOG
 	cdrom_image_backend_log("CDROM: binary_read failed during read!\n");
 #endif
+	return -1;
+    }
+
+    /* At most CDI_CACHE_BLOCK_SIZE, so it fits. */
+    tf->cache_len[slot] = (uint32_t) len;
+    tf->cache_block[slot] = block + 1;
+    tf->cache_used[slot] = tf->cache_clock;
+
+    return slot;
+}
+
+
+static int
+bin_read(void *p, uint8_t *buffer, uint64_t seek, size_t count)
+{
+    track_file_t *tf = (track_file_t *) p;
+    uint64_t block;
+    uint32_t offset, len, i;
+    int slot, hit = 1;
+
+    cdrom_image_backend_log("CDROM: binary_read(%08lx, pos=%" PRIu64 " count=%lu\n",
+		     tf->file, seek, count);
+
+    if (tf->file == NULL)
 	return 0;
+
+    tf->cache_clock++;
+
+    while (count > 0) {
+	block = seek / CDI_CACHE_BLOCK_SIZE;
+	offset = seek % CDI_CACHE_BLOCK_SIZE;
+
+	for (i = 0; i < CDI_CACHE_BLOCKS; i++) {
+		if (tf->cache_block[i] == (block + 1))
+			break;
+	}
+
+	if (i < CDI_CACHE_BLOCKS)
+		slot = i;
+	else {
+		hit = 0;
+		slot = bin_read_block(tf, block);
+		if (slot == -1)
+			return 0;
+
+		/* Reading on from where the last miss left off, load the next few
+		   blocks too, rather than going back to the host every 64k. */
+		if (block == tf->cache_next) {
+			for (i = 1; i < CDI_CACHE_READAHEAD; i++) {
+				if (bin_read_block(tf, block + i) == -1)
+					break;
+			}
+			tf->cache_next = block + i;
+		} else
+			tf->cache_next = block + 1;
+	}
+	tf->cache_used[slot] = tf->cache_clock;
+
+	len = CDI_CACHE_BLOCK_SIZE - offset;
+	if (len > count)
+		len = count;
+	if ((offset + len) > tf->cache_len[slot]) {
+#ifdef ENABLE_CDROM_IMAGE_BACKEND_LOG
+		cdrom_image_backend_log("CDROM: binary_read failed during read!\n");
+#endif
+		return 0;
+	}
+
+	memcpy(buffer, &tf->cache[(slot * CDI_CACHE_BLOCK_SIZE) + offset], len);
+	buffer += len;
+	seek += len;
+	count -= len;
     }
 
+    if (hit)
+	tf->cache_hits++;
+    else
+	tf->cache_misses++;
+
     return 1;
 }
 
@@ -132,6 +224,11 @@ bin_close(void *p)
 	tf->file = NULL;
     }
 
+    if (tf->cache != NULL) {
+	free(tf->cache);
+	tf->cache = NULL;
+    }
+
     memset(tf->fn, 0x00, sizeof(tf->fn));
 
     free(p);
@@ -158,8 +255,22 @@ bin_init(const wchar_t *filename, int *error)
 
     *error = (tf->file == NULL);
 
+    if (!*error) {
+	tf->cache = (uint8_t *) malloc(CDI_CACHE_BLOCKS * CDI_CACHE_BLOCK_SIZE);
+	if (tf->cache == NULL) {
+		fclose(tf->file);
+		*error = 1;
+	}
+    }
+
     /* Set the function pointers. */
     if (!*error) {
+	memset(tf->cache_block, 0x00, sizeof(tf->cache_block));
+	memset(tf->cache_used, 0x00, sizeof(tf->cache_used));
+	tf->cache_clock = 0;
+	tf->cache_next = 0;
+	tf->cache_hits = tf->cache_misses = 0;
+
 	tf->read = bin_read;
 	tf->get_length = bin_get_length;
 	tf->close = bin_close;
@@ -226,17 +337,44 @@ cdi_clear_tracks(cd_img_t *cdi)
 
     /* Mark that there's no tracks. */
     cdi->tracks_num = 0;
+    cdi->last_track = 0;
 }
 
 
 void
 cdi_close(cd_img_t *cdi)
 {
+#ifdef ENABLE_CDROM_IMAGE_BACKEND_LOG
+    uint64_t hits, misses;
+
+    cdi_get_cache_stats(cdi, &hits, &misses);
+    cdrom_image_backend_log("CDROM: read cache: %" PRIu64 " hits, %" PRIu64 " misses\n", hits, misses);
+#endif
+
     cdi_clear_tracks(cdi);
     free(cdi);
 }
 
 
+void
+cdi_get_cache_stats(cd_img_t *cdi, uint64_t *hits, uint64_t *misses)
+{
+    track_file_t *last = NULL;
+    int i;
+
+    *hits = *misses = 0;
+
+    for (i = 0; i < cdi->tracks_num; i++) {
+	if ((cdi->tracks[i].file == NULL) || (cdi->tracks[i].file == last))
+		continue;
+	last = cdi->tracks[i].file;
+
+	*hits += last->cache_hits;
+	*misses += last->cache_misses;
+    }
+}
+
+
 int
 cdi_set_device(cd_img_t *cdi, const wchar_t *path)
 {
@@ -322,13 +460,23 @@ cdi_get_track(cd_img_t *cdi, uint32_t sector)
     if (cdi->tracks_num < 2)
 	return -1;
 
+    /* Consecutive lookups are nearly always in the same track. */
+    if (cdi->last_track < (cdi->tracks_num - 1)) {
+	cur = &cdi->tracks[cdi->last_track];
+	next = &cdi->tracks[cdi->last_track + 1];
+	if ((cur->start <= sector) && (sector < next->start))
+		return cur->number;
+    }
+
     /* This has a problem - the code skips the last track, which is
        lead out - is that correct? */
     for (i = 0; i < (cdi->tracks_num - 1); i++) {
 	cur = &cdi->tracks[i];
 	next = &cdi->tracks[i + 1];
-	if ((cur->start <= sector) && (sector < next->start))
+	if ((cur->start <= sector) && (sector < next->start)) {
+		cdi->last_track = i;
 		return cur->number;
+	}
     }
 
     return -1;
@@ -359,22 +507,16 @@ cdi_get_audio_sub(cd_img_t *cdi, uint32_t sector, uint8_t *attr, uint8_t *track,
 }
 
 
-int
-cdi_read_sector(cd_img_t *cdi, uint8_t *buffer, int raw, uint32_t sector)
+static int
+cdi_read_track_sector(track_t *trk, uint8_t *buffer, int raw, uint32_t sector)
 {
     size_t length;
-    int track = cdi_get_track(cdi, sector) - 1;
     uint64_t sect = (uint64_t) sector, seek;
-    track_t *trk;
     int track_is_raw, ret;
     int raw_size, cooked_size;
     uint64_t offset = 0ULL;
     int m = 0, s = 0, f = 0;
 
-    if (track < 0)
-	return 0;
-
-    trk = &cdi->tracks[track];
     track_is_raw = ((trk->sector_size == RAW_SECTOR_SIZE) || (trk->sector_size == 2448));
 
     seek = trk->skip + ((sect - trk->start) * trk->sector_size);
@@ -421,30 +563,42 @@ cdi_read_sector(cd_img_t *cdi, uint8_t *buffer, int raw, uint32_t sector)
 }
 
 
+int
+cdi_read_sector(cd_img_t *cdi, uint8_t *buffer, int raw, uint32_t sector)
+{
+    int track = cdi_get_track(cdi, sector) - 1;
+
+    if (track < 0)
+	return 0;
+
+    return cdi_read_track_sector(&cdi->tracks[track], buffer, raw, sector);
+}
+
+
 int
 cdi_read_sectors(cd_img_t *cdi, uint8_t *buffer, int raw, uint32_t sector, uint32_t num)
 {
-    int sector_size, success = 1;
-    uint8_t *buf;
-    uint32_t buf_len, i;
+    int sector_size, track = -1;
+    uint32_t i, track_end = 0;
 
     /* TODO: This fails to account for Mode 2. Shouldn't we have a function 
 	     to get sector size? */
     sector_size = raw ? RAW_SECTOR_SIZE : COOKED_SECTOR_SIZE;
-    buf_len = num * sector_size;
-    buf = (uint8_t *) malloc(buf_len * sizeof(uint8_t));
 
     for (i = 0; i < num; i++) {
-	success = cdi_read_sector(cdi, &buf[i * sector_size], raw, sector + i);
-	if (!success)
-		break;
-    }
+	/* Only look the track up again once the range crosses into the next one. */
+	if ((track < 0) || ((sector + i) >= track_end)) {
+		track = cdi_get_track(cdi, sector + i) - 1;
+		if (track < 0)
+			return 0;
+		track_end = (uint32_t) cdi->tracks[track + 1].start;
+	}
 
-    memcpy((void *) buffer, buf, buf_len);
-    free(buf);
-    buf = NULL;
+	if (!cdi_read_track_sector(&cdi->tracks[track], &buffer[i * sector_size], raw, sector + i))
+		return 0;
+    }
 
-    return success;
+    return 1;
 }
 
 
@@ -1035,9 +1035,9 @@ static inline void MEM_LOAD_ADDR_EA_B(x86seg *seg)
 		addbyte(0x34);
 		addbyte(0xf2);
 	}
-        addbyte(0x83); /*CMP ESI, -1*/
-        addbyte(0xf8 | REG_ESI);
-        addbyte(-1);
+        addbyte(0x48); /*TEST RSI, RSI*/
+        addbyte(0x85);
+        addbyte(0xc0 | REG_ESI | (REG_ESI << 3));
         addbyte(0x74); /*JE slowpath*/
         addbyte(3+2);
         addbyte(0x8b); /*MOV AL,[RDI+RSI]*/
@@ -1114,9 +1114,9 @@ static inline void MEM_LOAD_ADDR_EA_W(x86seg *seg)
 	}
         addbyte(0x75); /*JNE slowpath*/
         addbyte(3+2+4+2);
-        addbyte(0x83); /*CMP ESI, -1*/
-        addbyte(0xf8 | REG_ESI);
-        addbyte(-1);
+        addbyte(0x48); /*TEST RSI, RSI*/
+        addbyte(0x85);
+        addbyte(0xc0 | REG_ESI | (REG_ESI << 3));
         addbyte(0x74); /*JE slowpath*/
         addbyte(4+2);
         addbyte(0x66); /*MOV AX,[RDI+RSI]*/
@@ -1201,9 +1201,9 @@ static inline void MEM_LOAD_ADDR_EA_L(x86seg *seg)
 	}
         addbyte(0x75); /*JNE slowpath*/
         addbyte(3+2+3+2);
-        addbyte(0x83); /*CMP ESI, -1*/
-        addbyte(0xf8 | REG_ESI);
-        addbyte(-1);
+        addbyte(0x48); /*TEST RSI, RSI*/
+        addbyte(0x85);
+        addbyte(0xc0 | REG_ESI | (REG_ESI << 3));
         addbyte(0x74); /*JE slowpath*/
         addbyte(3+2);
         addbyte(0x8b); /*MOV EAX,[RDI+RSI]*/
@@ -1280,9 +1280,9 @@ static inline void MEM_LOAD_ADDR_EA_Q(x86seg *seg)
 	}
         addbyte(0x75); /*JNE slowpath*/
         addbyte(3+2+4+2);
-        addbyte(0x83); /*CMP ESI, -1*/
-        addbyte(0xf8 | REG_ESI);
-        addbyte(-1);
+        addbyte(0x48); /*TEST RSI, RSI*/
+        addbyte(0x85);
+        addbyte(0xc0 | REG_ESI | (REG_ESI << 3));
         addbyte(0x74); /*JE slowpath*/
         addbyte(4+2);
         addbyte(0x48); /*MOV RAX,[RDI+RSI]*/
@@ -1397,9 +1397,9 @@ static inline void MEM_STORE_ADDR_EA_B(x86seg *seg, int host_reg)
 		addbyte(0x34);
 		addbyte(0xf2);
 	}
-        addbyte(0x83); /*CMP ESI, -1*/
-        addbyte(0xf8 | REG_ESI);
-        addbyte(-1);
+        addbyte(0x48); /*TEST RSI, RSI*/
+        addbyte(0x85);
+        addbyte(0xc0 | REG_ESI | (REG_ESI << 3));
         addbyte(0x74); /*JE slowpath*/
         addbyte(((host_reg & 8) ? 4:3)+2);
         if (host_reg & 8)
@@ -1491,9 +1491,9 @@ static inline void MEM_STORE_ADDR_EA_W(x86seg *seg, int host_reg)
 	}
         addbyte(0x75); /*JNE slowpath*/
         addbyte(3+2+((host_reg & 8) ? 5:4)+2);
-        addbyte(0x83); /*CMP ESI, -1*/
-        addbyte(0xf8 | REG_ESI);
-        addbyte(-1);
+        addbyte(0x48); /*TEST RSI, RSI*/
+        addbyte(0x85);
+        addbyte(0xc0 | REG_ESI | (REG_ESI << 3));
         addbyte(0x74); /*JE slowpath*/
         addbyte(((host_reg & 8) ? 5:4)+2);
         if (host_reg & 8)
@@ -1587,9 +1587,9 @@ static inline void MEM_STORE_ADDR_EA_L(x86seg *seg, int host_reg)
 	}
         addbyte(0x75); /*JNE slowpath*/
         addbyte(3+2+((host_reg & 8) ? 4:3)+2);
-        addbyte(0x83); /*CMP ESI, -1*/
-        addbyte(0xf8 | REG_ESI);
-        addbyte(-1);
+        addbyte(0x48); /*TEST RSI, RSI*/
+        addbyte(0x85);
+        addbyte(0xc0 | REG_ESI | (REG_ESI << 3));
         addbyte(0x74); /*JE slowpath*/
         addbyte(((host_reg & 8) ? 4:3)+2);
         if (host_reg & 8)
@@ -1681,9 +1681,9 @@ static inline void MEM_STORE_ADDR_EA_Q(x86seg *seg, int host_reg, int host_reg2)
 	}
         addbyte(0x75); /*JNE slowpath*/
         addbyte(3+2+4+2);
-        addbyte(0x83); /*CMP ESI, -1*/
-        addbyte(0xf8 | REG_ESI);
-        addbyte(-1);
+        addbyte(0x48); /*TEST RSI, RSI*/
+        addbyte(0x85);
+        addbyte(0xc0 | REG_ESI | (REG_ESI << 3));
         addbyte(0x74); /*JE slowpath*/
         addbyte(4+2);
         if (host_reg & 8)
@@ -5398,21 +5398,23 @@ static inline void MEM_CHECK_WRITE(x86seg *seg)
         }
 	if (IS_32_ADDR(writelookup2))
 	{
-	        addbyte(0x83); /*CMP writelookup2[RDI*8],-1*/
+	        addbyte(0x48); /*CMP QWORD writelookup2[RDI*8], LOOKUP_INV*/
+	        addbyte(0x83);
         	addbyte(0x3c);
 	        addbyte(0xfd);
 	        addlong((uint32_t)(uintptr_t)writelookup2);
-	        addbyte(-1);
+	        addbyte(LOOKUP_INV);
 	}
 	else
 	{
 		addbyte(0x48); /*MOV RCX, writelookup2*/
 		addbyte(0xb9);
 		addquad((uint64_t)writelookup2);
-		addbyte(0x83); /*CMP [RCX+RDI*8], -1*/
+		addbyte(0x48); /*CMP QWORD [RCX+RDI*8], LOOKUP_INV*/
+		addbyte(0x83);
 		addbyte(0x3c);
 		addbyte(0xf9);
-		addbyte(-1);
+		addbyte(LOOKUP_INV);
 	}
         addbyte(0x75); /*JNE +*/
         jump2 = &codeblock[block_current].data[block_pos];
@@ -5524,39 +5526,43 @@ static inline void MEM_CHECK_WRITE_W(x86seg *seg)
         addbyte(12);
 	if (IS_32_ADDR(writelookup2))
 	{
-	        addbyte(0x83); /*CMP writelookup2[RDI*8],-1*/
+	        addbyte(0x48); /*CMP QWORD writelookup2[RDI*8], LOOKUP_INV*/
+	        addbyte(0x83);
         	addbyte(0x3c);
 	        addbyte(0xfd);
 	        addlong((uint32_t)(uintptr_t)writelookup2);
-	        addbyte(-1);
+	        addbyte(LOOKUP_INV);
 	}
 	else
 	{
 		addbyte(0x48); /*MOV RAX, writelookup2*/
 		addbyte(0xb8);
 		addquad((uint64_t)writelookup2);
-		addbyte(0x83); /*CMP [RAX+RDI*8], -1*/
+		addbyte(0x48); /*CMP QWORD [RAX+RDI*8], LOOKUP_INV*/
+		addbyte(0x83);
 		addbyte(0x3c);
 		addbyte(0xf8);
-		addbyte(-1);
+		addbyte(LOOKUP_INV);
 	}
         addbyte(0x74); /*JE +*/
         jump2 = &codeblock[block_current].data[block_pos];
         addbyte(0);
 	if (IS_32_ADDR(writelookup2))
 	{
-	        addbyte(0x83); /*CMP writelookup2[RSI*8],-1*/
+	        addbyte(0x48); /*CMP QWORD writelookup2[RSI*8], LOOKUP_INV*/
+	        addbyte(0x83);
         	addbyte(0x3c);
 	        addbyte(0xf5);
 	        addlong((uint32_t)(uintptr_t)writelookup2);
-	        addbyte(-1);
+	        addbyte(LOOKUP_INV);
 	}
 	else
 	{
-		addbyte(0x83); /*CMP [RAX+RSI*8], -1*/
+		addbyte(0x48); /*CMP QWORD [RAX+RSI*8], LOOKUP_INV*/
+		addbyte(0x83);
 		addbyte(0x3c);
 		addbyte(0xf0);
-		addbyte(-1);
+		addbyte(LOOKUP_INV);
 	}
         addbyte(0x75); /*JNE +*/
         jump3 = &codeblock[block_current].data[block_pos];
@@ -5673,39 +5679,43 @@ static inline void MEM_CHECK_WRITE_L(x86seg *seg)
         addbyte(12);
 	if (IS_32_ADDR(writelookup2))
 	{
-	        addbyte(0x83); /*CMP writelookup2[RDI*8],-1*/
+	        addbyte(0x48); /*CMP QWORD writelookup2[RDI*8], LOOKUP_INV*/
+	        addbyte(0x83);
         	addbyte(0x3c);
 	        addbyte(0xfd);
 	        addlong((uint32_t)(uintptr_t)writelookup2);
-	        addbyte(-1);
+	        addbyte(LOOKUP_INV);
 	}
 	else
 	{
 		addbyte(0x48); /*MOV RAX, writelookup2*/
 		addbyte(0xb8);
 		addquad((uint64_t)writelookup2);
-		addbyte(0x83); /*CMP [RAX+RDI*8], -1*/
+		addbyte(0x48); /*CMP QWORD [RAX+RDI*8], LOOKUP_INV*/
+		addbyte(0x83);
 		addbyte(0x3c);
 		addbyte(0xf8);
-		addbyte(-1);
+		addbyte(LOOKUP_INV);
 	}
         addbyte(0x74); /*JE slowpath*/
         jump2 = &codeblock[block_current].data[block_pos];
         addbyte(0);
 	if (IS_32_ADDR(writelookup2))
 	{
-	        addbyte(0x83); /*CMP writelookup2[RSI*8],-1*/
+	        addbyte(0x48); /*CMP QWORD writelookup2[RSI*8], LOOKUP_INV*/
+	        addbyte(0x83);
         	addbyte(0x3c);
 	        addbyte(0xf5);
 	        addlong((uint32_t)(uintptr_t)writelookup2);
-	        addbyte(-1);
+	        addbyte(LOOKUP_INV);
 	}
 	else
 	{
-		addbyte(0x83); /*CMP [RAX+RSI*8], -1*/
+		addbyte(0x48); /*CMP QWORD [RAX+RSI*8], LOOKUP_INV*/
+		addbyte(0x83);
 		addbyte(0x3c);
 		addbyte(0xf0);
-		addbyte(-1);
+		addbyte(LOOKUP_INV);
 	}
         addbyte(0x75); /*JNE +*/
         jump3 = &codeblock[block_current].data[block_pos];
@@ -5792,9 +5802,9 @@ static inline int MEM_LOAD_ADDR_EA_B_NO_ABRT(x86seg *seg)
 		addbyte(0x34);
 		addbyte(0xf2);
 	}
-        addbyte(0x83); /*CMP ESI, -1*/
-        addbyte(0xf8 | REG_ESI);
-        addbyte(-1);
+        addbyte(0x48); /*TEST RSI, RSI*/
+        addbyte(0x85);
+        addbyte(0xc0 | REG_ESI | (REG_ESI << 3));
         addbyte(0x74); /*JE slowpath*/
         addbyte(3+2);
         addbyte(0x8b); /*MOV AL,[RDI+RSI]*/
@@ -5870,9 +5880,9 @@ static inline int MEM_LOAD_ADDR_EA_W_NO_ABRT(x86seg *seg)
 	}
         addbyte(0x75); /*JNE slowpath*/
         addbyte(3+2+4+2);
-        addbyte(0x83); /*CMP ESI, -1*/
-        addbyte(0xf8 | REG_ESI);
-        addbyte(-1);
+        addbyte(0x48); /*TEST RSI, RSI*/
+        addbyte(0x85);
+        addbyte(0xc0 | REG_ESI | (REG_ESI << 3));
         addbyte(0x74); /*JE slowpath*/
         addbyte(4+2);
         addbyte(0x66); /*MOV AX,[RDI+RSI]*/
@@ -5949,9 +5959,9 @@ static inline int MEM_LOAD_ADDR_EA_L_NO_ABRT(x86seg *seg)
 	}
         addbyte(0x75); /*JNE slowpath*/
         addbyte(3+2+3+2);
-        addbyte(0x83); /*CMP ESI, -1*/
-        addbyte(0xf8 | REG_ESI);
-        addbyte(-1);
+        addbyte(0x48); /*TEST RSI, RSI*/
+        addbyte(0x85);
+        addbyte(0xc0 | REG_ESI | (REG_ESI << 3));
         addbyte(0x74); /*JE slowpath*/
         addbyte(3+2);
         addbyte(0x8b); /*MOV EAX,[RDI+RSI]*/
@@ -6045,9 +6055,9 @@ static inline void MEM_STORE_ADDR_EA_B_NO_ABRT(x86seg *seg, int host_reg)
 		addbyte(0x34);
 		addbyte(0xf2);
 	}
-        addbyte(0x83); /*CMP ESI, -1*/
-        addbyte(0xf8 | REG_ESI);
-        addbyte(-1);
+        addbyte(0x48); /*TEST RSI, RSI*/
+        addbyte(0x85);
+        addbyte(0xc0 | REG_ESI | (REG_ESI << 3));
         addbyte(0x74); /*JE slowpath*/
         addbyte(((host_reg & 8) ? 4:3)+2);
         if (host_reg & 8)
@@ -6132,9 +6142,9 @@ static inline void MEM_STORE_ADDR_EA_W_NO_ABRT(x86seg *seg, int host_reg)
 	}
         addbyte(0x75); /*JNE slowpath*/
         addbyte(3+2+((host_reg & 8) ? 5:4)+2);
-        addbyte(0x83); /*CMP ESI, -1*/
-        addbyte(0xf8 | REG_ESI);
-        addbyte(-1);
+        addbyte(0x48); /*TEST RSI, RSI*/
+        addbyte(0x85);
+        addbyte(0xc0 | REG_ESI | (REG_ESI << 3));
         addbyte(0x74); /*JE slowpath*/
         addbyte(((host_reg & 8) ? 5:4)+2);
         if (host_reg & 8)
@@ -6221,9 +6231,9 @@ static inline void MEM_STORE_ADDR_EA_L_NO_ABRT(x86seg *seg, int host_reg)
 	}
         addbyte(0x75); /*JNE slowpath*/
         addbyte(3+2+((host_reg & 8) ? 4:3)+2);
-        addbyte(0x83); /*CMP ESI, -1*/
-        addbyte(0xf8 | REG_ESI);
-        addbyte(-1);
+        addbyte(0x48); /*TEST RSI, RSI*/
+        addbyte(0x85);
+        addbyte(0xc0 | REG_ESI | (REG_ESI << 3));
         addbyte(0x74); /*JE slowpath*/
         addbyte(((host_reg & 8) ? 4:3)+2);
         if (host_reg & 8)
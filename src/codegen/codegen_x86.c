@@ -137,9 +137,9 @@ static uint32_t gen_MEM_LOAD_ADDR_EA_B()
         addbyte(0x14);
         addbyte(0x95);
         addlong((uint32_t)readlookup2);
-        addbyte(0x83); /*CMP EDX, -1*/
+        addbyte(0x83); /*CMP EDX, LOOKUP_INV*/
         addbyte(0xfa);
-        addbyte(-1);
+        addbyte(LOOKUP_INV);
         addbyte(0x74); /*JE slowpath*/
         addbyte(4+1);
         addbyte(0x0f); /*MOVZX EAX, B[EDX+EDI]*/
@@ -193,9 +193,9 @@ static uint32_t gen_MEM_LOAD_ADDR_EA_W()
         addlong((uint32_t)readlookup2);
         addbyte(0x75); /*JNE slowpath*/
         addbyte(3+2+4+1);
-        addbyte(0x83); /*CMP EDX, -1*/
+        addbyte(0x83); /*CMP EDX, LOOKUP_INV*/
         addbyte(0xfa);
-        addbyte(-1);
+        addbyte(LOOKUP_INV);
         addbyte(0x74); /*JE slowpath*/
         addbyte(4+1);
         addbyte(0x0f); /*MOVZX EAX, [EDX+EDI]W*/
@@ -249,9 +249,9 @@ static uint32_t gen_MEM_LOAD_ADDR_EA_L()
         addlong((uint32_t)readlookup2);
         addbyte(0x75); /*JNE slowpath*/
         addbyte(3+2+3+1);
-        addbyte(0x83); /*CMP EDX, -1*/
+        addbyte(0x83); /*CMP EDX, LOOKUP_INV*/
         addbyte(0xfa);
-        addbyte(-1);
+        addbyte(LOOKUP_INV);
         addbyte(0x74); /*JE slowpath*/
         addbyte(3+1);
         addbyte(0x8b); /*MOV EAX, [EDX+EDI]*/
@@ -301,9 +301,9 @@ static uint32_t gen_MEM_LOAD_ADDR_EA_Q()
         addlong((uint32_t)readlookup2);
         addbyte(0x75); /*JNE slowpath*/
         addbyte(3+2+3+4+1);
-        addbyte(0x83); /*CMP EDX, -1*/
+        addbyte(0x83); /*CMP EDX, LOOKUP_INV*/
         addbyte(0xfa);
-        addbyte(-1);
+        addbyte(LOOKUP_INV);
         addbyte(0x74); /*JE slowpath*/
         addbyte(3+4+1);
         addbyte(0x8b); /*MOV EAX, [EDX+EDI]*/
@@ -353,9 +353,9 @@ static uint32_t gen_MEM_STORE_ADDR_EA_B()
         addbyte(0x04 | (REG_ESI << 3));
         addbyte(0x85 | (REG_ESI << 3));
         addlong((uint32_t)writelookup2);
-        addbyte(0x83); /*CMP ESI, -1*/
+        addbyte(0x83); /*CMP ESI, LOOKUP_INV*/
         addbyte(0xf8 | REG_ESI);
-        addbyte(-1);
+        addbyte(LOOKUP_INV);
         addbyte(0x74); /*JE slowpath*/
         addbyte(3+1);
         addbyte(0x88); /*MOV [EDI+ESI],CL*/
@@ -407,9 +407,9 @@ static uint32_t gen_MEM_STORE_ADDR_EA_W()
         addlong((uint32_t)writelookup2);
         addbyte(0x75); /*JNE slowpath*/
         addbyte(3+2+4+1);
-        addbyte(0x83); /*CMP ESI, -1*/
+        addbyte(0x83); /*CMP ESI, LOOKUP_INV*/
         addbyte(0xf8 | REG_ESI);
-        addbyte(-1);
+        addbyte(LOOKUP_INV);
         addbyte(0x74); /*JE slowpath*/
         addbyte(4+1);
         addbyte(0x66); /*MOV [EDI+ESI],CX*/
@@ -462,9 +462,9 @@ static uint32_t gen_MEM_STORE_ADDR_EA_L()
         addlong((uint32_t)writelookup2);
         addbyte(0x75); /*JNE slowpath*/
         addbyte(3+2+3+1);
-        addbyte(0x83); /*CMP ESI, -1*/
+        addbyte(0x83); /*CMP ESI, LOOKUP_INV*/
         addbyte(0xf8 | REG_ESI);
-        addbyte(-1);
+        addbyte(LOOKUP_INV);
         addbyte(0x74); /*JE slowpath*/
         addbyte(3+1);
         addbyte(0x89); /*MOV [EDI+ESI],ECX*/
@@ -516,9 +516,9 @@ static uint32_t gen_MEM_STORE_ADDR_EA_Q()
         addlong((uint32_t)writelookup2);
         addbyte(0x75); /*JNE slowpath*/
         addbyte(3+2+3+4+1);
-        addbyte(0x83); /*CMP ESI, -1*/
+        addbyte(0x83); /*CMP ESI, LOOKUP_INV*/
         addbyte(0xf8 | REG_ESI);
-        addbyte(-1);
+        addbyte(LOOKUP_INV);
         addbyte(0x74); /*JE slowpath*/
         addbyte(3+4+1);
         addbyte(0x89); /*MOV [EDI+ESI],EBX*/
@@ -572,9 +572,9 @@ static uint32_t gen_MEM_LOAD_ADDR_EA_B_NO_ABRT()
         addbyte(0x14);
         addbyte(0x95);
         addlong((uint32_t)readlookup2);
-        addbyte(0x83); /*CMP EDX, -1*/
+        addbyte(0x83); /*CMP EDX, LOOKUP_INV*/
         addbyte(0xfa);
-        addbyte(-1);
+        addbyte(LOOKUP_INV);
         addbyte(0x74); /*JE slowpath*/
         addbyte(4+1);
         addbyte(0x0f); /*MOVZX ECX, B[EDX+EDI]*/
@@ -642,9 +642,9 @@ static uint32_t gen_MEM_LOAD_ADDR_EA_W_NO_ABRT()
         addlong((uint32_t)readlookup2);
         addbyte(0x75); /*JNE slowpath*/
         addbyte(3+2+4+1);
-        addbyte(0x83); /*CMP EDX, -1*/
+        addbyte(0x83); /*CMP EDX, LOOKUP_INV*/
         addbyte(0xfa);
-        addbyte(-1);
+        addbyte(LOOKUP_INV);
         addbyte(0x74); /*JE slowpath*/
         addbyte(4+1);
         addbyte(0x0f); /*MOVZX ECX, [EDX+EDI]W*/
@@ -712,9 +712,9 @@ static uint32_t gen_MEM_LOAD_ADDR_EA_L_NO_ABRT()
         addlong((uint32_t)readlookup2);
         addbyte(0x75); /*JE slowpath*/
         addbyte(3+2+3+1);
-        addbyte(0x83); /*CMP EDX, -1*/
+        addbyte(0x83); /*CMP EDX, LOOKUP_INV*/
         addbyte(0xfa);
-        addbyte(-1);
+        addbyte(LOOKUP_INV);
         addbyte(0x74); /*JE slowpath*/
         addbyte(3+1);
         addbyte(0x8b); /*MOV ECX, [EDX+EDI]*/
@@ -777,9 +777,9 @@ static uint32_t gen_MEM_STORE_ADDR_EA_B_NO_ABRT()
         addbyte(0x04 | (REG_ESI << 3));
         addbyte(0x85 | (REG_ESI << 3));
         addlong((uint32_t)writelookup2);
-        addbyte(0x83); /*CMP ESI, -1*/
+        addbyte(0x83); /*CMP ESI, LOOKUP_INV*/
         addbyte(0xf8 | REG_ESI);
-        addbyte(-1);
+        addbyte(LOOKUP_INV);
         addbyte(0x74); /*JE slowpath*/
         addbyte(3+1);
         addbyte(0x88); /*MOV [EDI+ESI],CL*/
@@ -843,9 +843,9 @@ static uint32_t gen_MEM_STORE_ADDR_EA_W_NO_ABRT()
         addlong((uint32_t)writelookup2);
         addbyte(0x75); /*JNE slowpath*/
         addbyte(3+2+4+1);
-        addbyte(0x83); /*CMP ESI, -1*/
+        addbyte(0x83); /*CMP ESI, LOOKUP_INV*/
         addbyte(0xf8 | REG_ESI);
-        addbyte(-1);
+        addbyte(LOOKUP_INV);
         addbyte(0x74); /*JE slowpath*/
         addbyte(4+1);
         addbyte(0x66); /*MOV [EDI+ESI],CX*/
@@ -910,9 +910,9 @@ static uint32_t gen_MEM_STORE_ADDR_EA_L_NO_ABRT()
         addlong((uint32_t)writelookup2);
         addbyte(0x75); /*JNE slowpath*/
         addbyte(3+2+3+1);
-        addbyte(0x83); /*CMP ESI, -1*/
+        addbyte(0x83); /*CMP ESI, LOOKUP_INV*/
         addbyte(0xf8 | REG_ESI);
-        addbyte(-1);
+        addbyte(LOOKUP_INV);
         addbyte(0x74); /*JE slowpath*/
         addbyte(3+1);
         addbyte(0x89); /*MOV [EDI+ESI],ECX*/
@@ -974,11 +974,11 @@ static uint32_t gen_MEM_CHECK_WRITE()
         addbyte(-1);
         addbyte(0x74); /*JE slowpath*/
         addbyte(11);
-        addbyte(0x83); /*CMP writelookup2[EDI*4],-1*/
+        addbyte(0x83); /*CMP writelookup2[EDI*4], LOOKUP_INV*/
         addbyte(0x3c);
         addbyte(0xbd);
         addlong((uint32_t)writelookup2);
-        addbyte(-1);
+        addbyte(LOOKUP_INV);
         addbyte(0x74); /*JE +*/
         addbyte(1);
         addbyte(0xc3); /*RET*/
@@ -1039,18 +1039,18 @@ static uint32_t gen_MEM_CHECK_WRITE_W()
         addbyte(0xc1); /*SHR ESI, 12*/
         addbyte(0xee);
         addbyte(12);
-        addbyte(0x83); /*CMP writelookup2[EDI*4],-1*/
+        addbyte(0x83); /*CMP writelookup2[EDI*4], LOOKUP_INV*/
         addbyte(0x3c);
         addbyte(0xbd);
         addlong((uint32_t)writelookup2);
-        addbyte(-1);
+        addbyte(LOOKUP_INV);
         addbyte(0x74); /*JE +*/
         addbyte(11);
-        addbyte(0x83); /*CMP writelookup2[ESI*4],-1*/
+        addbyte(0x83); /*CMP writelookup2[ESI*4], LOOKUP_INV*/
         addbyte(0x3c);
         addbyte(0xb5);
         addlong((uint32_t)writelookup2);
-        addbyte(-1);
+        addbyte(LOOKUP_INV);
         addbyte(0x74); /*JE +*/
         addbyte(1);
         addbyte(0xc3); /*RET*/
@@ -1121,18 +1121,18 @@ static uint32_t gen_MEM_CHECK_WRITE_L()
         addbyte(0xc1); /*SHR ESI, 12*/
         addbyte(0xee);
         addbyte(12);
-        addbyte(0x83); /*CMP writelookup2[EDI*4],-1*/
+        addbyte(0x83); /*CMP writelookup2[EDI*4], LOOKUP_INV*/
         addbyte(0x3c);
         addbyte(0xbd);
         addlong((uint32_t)writelookup2);
-        addbyte(-1);
+        addbyte(LOOKUP_INV);
         addbyte(0x74); /*JE +*/
         addbyte(11);
-        addbyte(0x83); /*CMP writelookup2[ESI*4],-1*/
+        addbyte(0x83); /*CMP writelookup2[ESI*4], LOOKUP_INV*/
         addbyte(0x3c);
         addbyte(0xb5);
         addlong((uint32_t)writelookup2);
-        addbyte(-1);
+        addbyte(LOOKUP_INV);
         addbyte(0x74); /*JE +*/
         addbyte(1);
         addbyte(0xc3); /*RET*/
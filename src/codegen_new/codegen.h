@@ -40,9 +40,9 @@ typedef struct codeblock_t
         uint8_t ins;
         uint8_t TOP;
 
-        /*Pointers for codeblock tree, used to search for blocks when hash lookup
-          fails.*/
-        uint16_t parent, left, right;
+        /*Previous and next pointers for the codeblock lookup table chain, used
+          to search for blocks when hash lookup fails.*/
+        uint16_t lookup_prev, lookup_next;
 
         uint8_t *data;
         
@@ -82,6 +82,8 @@ extern uint8_t *block_write_data;
 #define CODEBLOCK_IN_DIRTY_LIST 0x40
 /*Code block is not inlining immediate parameters, parameters must be fetched from memory*/
 #define CODEBLOCK_NO_IMMEDIATES 0x80
+/*Code block has been dispatched since the eviction sweep last passed it*/
+#define CODEBLOCK_REFERENCED 0x100
 
 #define BLOCK_PC_INVALID 0xffffffff
 
@@ -92,198 +94,71 @@ static inline int get_block_nr(codeblock_t *block)
         return ((uintptr_t)block - (uintptr_t)codeblock) / sizeof(codeblock_t);
 }
 
-static inline codeblock_t *codeblock_tree_find(uint32_t phys, uint32_t _cs)
-{
-        codeblock_t *block;
-        uint64_t a = _cs | ((uint64_t)phys << 32);
-        
-        if (!pages[phys >> 12].head)
-                return NULL;
-                
-        block = &codeblock[pages[phys >> 12].head];
-        while (block)
-        {
-                uint64_t block_cmp = block->_cs | ((uint64_t)block->phys << 32);
-                if (a == block_cmp)
-                {
-                        if (!((block->status ^ cpu_cur_status) & CPU_STATUS_FLAGS) &&
-                             ((block->status & cpu_cur_status & CPU_STATUS_MASK) == (cpu_cur_status & CPU_STATUS_MASK)))
-                                break;
-                }
-                if (a < block_cmp)
-                        block = block->left ? &codeblock[block->left] : NULL;
-                else
-                        block = block->right ? &codeblock[block->right] : NULL;
-        }
-        
-        return block;
-}
+/*Blocks that miss in codeblock_hash are looked up in a chained hash table keyed
+  on (phys, _cs). The chains are threaded through the codeblock array via
+  lookup_prev/lookup_next, so the table itself is just an array of block
+  numbers. With CODEBLOCK_LOOKUP_SIZE well above BLOCK_SIZE, chains are almost
+  always a single block long, regardless of how many CS values a page is run
+  with.*/
+#define CODEBLOCK_LOOKUP_SIZE 0x10000
+#define CODEBLOCK_LOOKUP_MASK (CODEBLOCK_LOOKUP_SIZE-1)
 
-static inline void codeblock_tree_add(codeblock_t *new_block)
-{
-        codeblock_t *block = &codeblock[pages[new_block->phys >> 12].head];
-        uint64_t a = new_block->_cs | ((uint64_t)new_block->phys << 32);
+extern uint16_t codeblock_lookup[CODEBLOCK_LOOKUP_SIZE];
 
-        if (!pages[new_block->phys >> 12].head)
-        {
-                pages[new_block->phys >> 12].head = get_block_nr(new_block);
-                new_block->parent = new_block->left = new_block->right = BLOCK_INVALID;
-        }
-        else
-        {
-                codeblock_t *old_block = NULL;
-                uint64_t old_block_cmp = 0;
-                
-                while (block)
-                {
-                        old_block = block;
-                        old_block_cmp = old_block->_cs | ((uint64_t)old_block->phys << 32);
-                        
-                        if (a < old_block_cmp)
-                                block = block->left ? &codeblock[block->left] : NULL;
-                        else
-                                block = block->right ? &codeblock[block->right] : NULL;
-                }
-                
-                if (a < old_block_cmp)
-                        old_block->left = get_block_nr(new_block);
-                else
-                        old_block->right = get_block_nr(new_block);
-                
-                new_block->parent = get_block_nr(old_block);
-                new_block->left = new_block->right = BLOCK_INVALID;
-        }
-}
+extern uint64_t codeblock_lookup_count, codeblock_lookup_found, codeblock_lookup_depth;
+extern uint64_t codeblock_hash_count, codeblock_hash_hits;
 
-static inline void codeblock_tree_delete(codeblock_t *block)
+static inline uint32_t codeblock_lookup_hash(uint32_t phys, uint32_t _cs)
 {
-        uint16_t parent_nr = block->parent;
-        codeblock_t *parent;
+        return (((phys * 0x9e3779b1) ^ (_cs * 0x85ebca6b)) >> 16) & CODEBLOCK_LOOKUP_MASK;
+}
 
-        if (block->parent)
-                parent = &codeblock[block->parent];
-        else
-                parent = NULL;
+static inline codeblock_t *codeblock_lookup_find(uint32_t phys, uint32_t _cs)
+{
+        uint16_t block_nr = codeblock_lookup[codeblock_lookup_hash(phys, _cs)];
 
-        if (!block->left && !block->right)
-        {
-                /*Easy case - remove from parent*/
-                if (!parent)
-                        pages[block->phys >> 12].head = BLOCK_INVALID;
-                else
-                {
-                        uint16_t block_nr = get_block_nr(block);
-                        
-                        if (parent->left == block_nr)
-                                parent->left = BLOCK_INVALID;
-                        if (parent->right == block_nr)
-                                parent->right = BLOCK_INVALID;
-                }
-                return;
-        }
-        else if (!block->left)
+        codeblock_lookup_count++;
+        while (block_nr)
         {
-                /*Only right node*/
-                if (!parent_nr)
+                codeblock_t *block = &codeblock[block_nr];
+                codeblock_lookup_depth++;
+                if (block->phys == phys && block->_cs == _cs &&
+                    !((block->status ^ cpu_cur_status) & CPU_STATUS_FLAGS) &&
+                    ((block->status & cpu_cur_status & CPU_STATUS_MASK) == (cpu_cur_status & CPU_STATUS_MASK)))
                 {
-                        pages[block->phys >> 12].head = block->right;
-                        codeblock[pages[block->phys >> 12].head].parent = BLOCK_INVALID;
+                        codeblock_lookup_found++;
+                        return block;
                 }
-                else
-                {
-                        uint16_t block_nr = get_block_nr(block);
-
-                        if (parent->left == block_nr)
-                        {
-                                parent->left = block->right;
-                                codeblock[parent->left].parent = parent_nr;
-                        }
-                        if (parent->right == block_nr)
-                        {
-                                parent->right = block->right;
-                                codeblock[parent->right].parent = parent_nr;
-                        }
-                }
-                return;
+                block_nr = block->lookup_next;
         }
-        else if (!block->right)
-        {
-                /*Only left node*/
-                if (!parent_nr)
-                {
-                        pages[block->phys >> 12].head = block->left;
-                        codeblock[pages[block->phys >> 12].head].parent = BLOCK_INVALID;
-                }
-                else
-                {
-                        uint16_t block_nr = get_block_nr(block);
-
-                        if (parent->left == block_nr)
-                        {
-                                parent->left = block->left;
-                                codeblock[parent->left].parent = parent_nr;
-                        }
-                        if (parent->right == block_nr)
-                        {
-                                parent->right = block->left;
-                                codeblock[parent->right].parent = parent_nr;
-                        }
-                }
-                return;
-        }
-        else
-        {
-                /*Difficult case - node has two children. Walk right child to find lowest node*/
-                codeblock_t *lowest = &codeblock[block->right], *highest;
-                codeblock_t *old_parent;
-                uint16_t lowest_nr;
-                        
-                while (lowest->left)
-                        lowest = &codeblock[lowest->left];
-                lowest_nr = get_block_nr(lowest);
-                
-                old_parent = &codeblock[lowest->parent];
-
-                /*Replace deleted node with lowest node*/
-                if (!parent_nr)
-                        pages[block->phys >> 12].head = lowest_nr;
-                else
-                {
-                        uint16_t block_nr = get_block_nr(block);
 
-                        if (parent->left == block_nr)
-                                parent->left = lowest_nr;
-                        if (parent->right == block_nr)
-                                parent->right = lowest_nr;
-                }
+        return NULL;
+}
 
-                lowest->parent = parent_nr;
-                lowest->left = block->left;
-                if (lowest->left)
-                        codeblock[lowest->left].parent = lowest_nr;
+static inline void codeblock_lookup_add(codeblock_t *new_block)
+{
+        uint32_t hash = codeblock_lookup_hash(new_block->phys, new_block->_cs);
+        uint16_t block_nr = get_block_nr(new_block);
+
+        new_block->lookup_prev = BLOCK_INVALID;
+        new_block->lookup_next = codeblock_lookup[hash];
+        if (new_block->lookup_next)
+                codeblock[new_block->lookup_next].lookup_prev = block_nr;
+        codeblock_lookup[hash] = block_nr;
+}
 
-                old_parent->left = BLOCK_INVALID;
-                                
-                highest = &codeblock[lowest->right];
-                if (!lowest->right)
-                {
-                        if (lowest_nr != block->right)
-                        {
-                                lowest->right = block->right;
-                                codeblock[block->right].parent = lowest_nr;
-                        }
-                        return;
-                }
+static inline void codeblock_lookup_delete(codeblock_t *block)
+{
+        uint32_t hash = codeblock_lookup_hash(block->phys, block->_cs);
 
-                while (highest->right)
-                        highest = &codeblock[highest->right];
+        if (block->lookup_prev)
+                codeblock[block->lookup_prev].lookup_next = block->lookup_next;
+        else if (codeblock_lookup[hash] == get_block_nr(block))
+                codeblock_lookup[hash] = block->lookup_next;
+        if (block->lookup_next)
+                codeblock[block->lookup_next].lookup_prev = block->lookup_prev;
 
-                if (block->right && block->right != lowest_nr)
-                {
-                        highest->right = block->right;
-                        codeblock[block->right].parent = get_block_nr(highest);
-                }
-        }
+        block->lookup_prev = block->lookup_next = BLOCK_INVALID;
 }
 
 #define PAGE_MASK_MASK 63
@@ -334,9 +209,17 @@ void codegen_check_seg_read(codeblock_t *block, struct ir_data_t *ir, x86seg *se
 void codegen_check_seg_write(codeblock_t *block, struct ir_data_t *ir, x86seg *seg);
 
 int codegen_purge_purgable_list();
-/*Delete a random code block to free memory. This is obviously quite expensive, and
-  will only be called when the allocator is out of memory*/
-void codegen_delete_random_block(int required_mem_block);
+/*Evict a batch of code blocks to free memory, using a clock (second chance)
+  sweep over the code block array. Blocks dispatched since the sweep last passed
+  them are spared once. This is expensive, and will only be called when the
+  allocator or the block free list is exhausted. If required_mem_block is set,
+  only blocks holding generated code are considered. exclude_block is never
+  evicted*/
+void codegen_evict_blocks(int required_mem_block, int exclude_block);
+
+/*Number of blocks evicted, and number of blocks compiled again after having been
+  evicted*/
+extern uint64_t codegen_evict_count, codegen_evict_recompiles;
 
 extern int cpu_block_end;
 extern uint32_t codegen_endpc;
@@ -21,34 +21,138 @@ typedef struct mem_block_t
         uint32_t offset; /*Offset into mem_block_alloc*/
         uint32_t next;
         uint16_t code_block;
+        uint16_t writable; /*Block currently holds its pages writable*/
 } mem_block_t;
 
-static mem_block_t mem_blocks[MEM_BLOCK_NR];
+static mem_block_t *mem_blocks = NULL;
 static uint32_t mem_block_free_list;
 static uint8_t *mem_block_alloc = NULL;
+/*Number of mem blocks reserved, and number currently committed*/
+static int mem_block_nr, mem_block_committed;
+/*Number of mem blocks being written to, per host page. Pages are writable while
+  this is non-zero, and executable otherwise*/
+static uint8_t *mem_page_writers = NULL;
+static uint32_t mem_page_size;
 
 int codegen_allocator_usage = 0;
 
-void codegen_allocator_init()
+static void codegen_allocator_protect(uint32_t page, int writable)
 {
-        int c;
+#if defined WIN32 || defined _WIN32 || defined _WIN32
+        DWORD old_protect;
+
+        VirtualProtect(&mem_block_alloc[page * mem_page_size], mem_page_size, writable ? PAGE_READWRITE : PAGE_EXECUTE_READ, &old_protect);
+#else
+        mprotect(&mem_block_alloc[page * mem_page_size], mem_page_size, writable ? (PROT_READ|PROT_WRITE) : (PROT_READ|PROT_EXEC));
+#endif
+}
+
+static void codegen_allocator_set_writable(mem_block_t *block, int writable)
+{
+        uint32_t page, start_page, end_page;
+
+        if (!block->writable == !writable)
+                return;
+        block->writable = writable;
+
+        start_page = block->offset / mem_page_size;
+        end_page = (block->offset + MEM_BLOCK_SIZE - 1) / mem_page_size;
+
+        for (page = start_page; page <= end_page; page++)
+        {
+                if (writable)
+                {
+                        if (!mem_page_writers[page]++)
+                                codegen_allocator_protect(page, 1);
+                }
+                else
+                {
+                        if (!--mem_page_writers[page])
+                                codegen_allocator_protect(page, 0);
+                }
+        }
+}
+
+/*Commit another chunk of the reserved arena and add it to the free list. Returns
+  0 if the arena is already at its maximum size*/
+static int codegen_allocator_grow()
+{
+        int c, first = mem_block_committed;
+        int nr = MEM_BLOCK_CHUNK;
+        size_t size;
+
+        if (first >= mem_block_nr)
+                return 0;
+        if ((first + nr) > mem_block_nr)
+                nr = mem_block_nr - first;
+        size = (size_t)nr * MEM_BLOCK_SIZE;
 
 #if defined WIN32 || defined _WIN32 || defined _WIN32
-        mem_block_alloc = VirtualAlloc(NULL, MEM_BLOCK_NR * MEM_BLOCK_SIZE, MEM_COMMIT, PAGE_EXECUTE_READWRITE);
+        if (!VirtualAlloc(&mem_block_alloc[first * MEM_BLOCK_SIZE], size, MEM_COMMIT, PAGE_EXECUTE_READ))
+                return 0;
 #else
-        mem_block_alloc = mmap(0, MEM_BLOCK_NR * MEM_BLOCK_SIZE, PROT_READ|PROT_WRITE|PROT_EXEC, MAP_ANON|MAP_PRIVATE, 0, 0);
+        if (mprotect(&mem_block_alloc[first * MEM_BLOCK_SIZE], size, PROT_READ|PROT_EXEC))
+                return 0;
 #endif
 
-        for (c = 0; c < MEM_BLOCK_NR; c++)
+        for (c = first; c < first + nr; c++)
         {
                 mem_blocks[c].offset = c * MEM_BLOCK_SIZE;
                 mem_blocks[c].code_block = BLOCK_INVALID;
-                if (c < MEM_BLOCK_NR-1)
+                mem_blocks[c].writable = 0;
+                if (c < (first + nr) - 1)
                         mem_blocks[c].next = c+2;
                 else
-                        mem_blocks[c].next = 0;
+                        mem_blocks[c].next = mem_block_free_list;
+        }
+        mem_block_free_list = first + 1;
+        mem_block_committed += nr;
+
+        return 1;
+}
+
+void codegen_allocator_init()
+{
+        size_t size;
+
+        /*dynarec_cache_size is in MB, 0 means use the largest arena the jump range
+          allows. Only what is actually needed gets committed either way*/
+        mem_block_nr = MEM_BLOCK_NR;
+        if (dynarec_cache_size > 0)
+        {
+                uint64_t nr = (((uint64_t)dynarec_cache_size << 20) / MEM_BLOCK_SIZE + MEM_BLOCK_CHUNK - 1) & ~(uint64_t)(MEM_BLOCK_CHUNK - 1);
+
+                if (nr < MEM_BLOCK_CHUNK)
+                        nr = MEM_BLOCK_CHUNK;
+                if (nr < MEM_BLOCK_NR)
+                        mem_block_nr = (int)nr;
+        }
+        size = (size_t)mem_block_nr * MEM_BLOCK_SIZE;
+
+#if defined WIN32 || defined _WIN32 || defined _WIN32
+        {
+                SYSTEM_INFO si;
+
+                GetSystemInfo(&si);
+                mem_page_size = si.dwPageSize;
         }
-        mem_block_free_list = 1;
+        mem_block_alloc = VirtualAlloc(NULL, size, MEM_RESERVE, PAGE_NOACCESS);
+#else
+        mem_page_size = sysconf(_SC_PAGESIZE);
+        mem_block_alloc = mmap(0, size, PROT_NONE, MAP_ANON|MAP_PRIVATE, -1, 0);
+        if (mem_block_alloc == MAP_FAILED)
+                mem_block_alloc = NULL;
+#endif
+        if (!mem_block_alloc)
+                fatal("codegen_allocator_init - could not reserve %llu bytes\n", (unsigned long long) size);
+
+        mem_blocks = malloc(mem_block_nr * sizeof(mem_block_t));
+        mem_page_writers = calloc((size + mem_page_size - 1) / mem_page_size, 1);
+
+        mem_block_committed = 0;
+        mem_block_free_list = 0;
+        if (!codegen_allocator_grow())
+                fatal("codegen_allocator_init - could not commit code memory\n");
 }
 
 mem_block_t *codegen_allocator_allocate(mem_block_t *parent, int code_block)
@@ -58,12 +162,10 @@ mem_block_t *codegen_allocator_allocate(mem_block_t *parent, int code_block)
         
         while (!mem_block_free_list)
         {
-                /*Pick a random memory block and free the owning code block*/
-                block_nr = rand() & MEM_BLOCK_MASK;
-                block = &mem_blocks[block_nr];
-                
-                if (block->code_block && block->code_block != code_block)
-                        codegen_delete_block(&codeblock[block->code_block]);
+                /*Grow the arena while we can, then start freeing batches of cold
+                  code blocks, along with their memory*/
+                if (!codegen_allocator_grow())
+                        codegen_evict_blocks(1, code_block);
         }
 
         /*Remove from free list*/
@@ -81,6 +183,9 @@ mem_block_t *codegen_allocator_allocate(mem_block_t *parent, int code_block)
         else
                 block->next = 0;
 
+        /*The caller is about to emit code into the block*/
+        codegen_allocator_set_writable(block, 1);
+
         codegen_allocator_usage++;
         return block;
 }
@@ -93,6 +198,7 @@ void codegen_allocator_free(mem_block_t *block)
                 int next_block_nr = block->next;
                 codegen_allocator_usage--;
                 
+                codegen_allocator_set_writable(block, 0);
                 block->next = mem_block_free_list;
                 block->code_block = BLOCK_INVALID;
                 mem_block_free_list = block_nr;
@@ -112,18 +218,19 @@ uint8_t *codeblock_allocator_get_ptr(mem_block_t *block)
 
 void codegen_allocator_clean_blocks(struct mem_block_t *block)
 {
-#if defined __ARM_EABI__ || defined _ARM_ || defined __aarch64__ || defined _M_ARM || defined _M_ARM64
         while (1)
         {
+                codegen_allocator_set_writable(block, 0);
+#if defined __ARM_EABI__ || defined _ARM_ || defined __aarch64__ || defined _M_ARM || defined _M_ARM64
 #ifndef _MSC_VER
 		__clear_cache(&mem_block_alloc[block->offset], &mem_block_alloc[block->offset + MEM_BLOCK_SIZE]);
 #else
 		FlushInstructionCache(GetCurrentProcess(), &mem_block_alloc[block->offset], MEM_BLOCK_SIZE);
+#endif
 #endif
 		if (block->next)
 			block = &mem_blocks[block->next - 1];
 		else
 			break;
         }
-#endif
 }
@@ -12,7 +12,16 @@
   
   Due to the chaining, the total memory size is limited by the range of a jump
   instruction. ARMv7 is restricted to +/- 32 MB, ARMv8 to +/- 128 MB, x86 to
-  +/- 2GB. As a result, total memory size is limited to 32 MB on ARMv7*/
+  +/- 2GB. As a result, total memory size is limited to 32 MB on ARMv7.
+  
+  The whole arena is reserved as one contiguous range at startup, so that the
+  jump range is respected, but it is only committed MEM_BLOCK_CHUNK blocks at a
+  time as code is generated. Its size can be lowered from the MEM_BLOCK_NR maximum
+  with the dynarec_cache_size configuration option.
+  
+  Memory is mapped W^X - blocks are writable from allocation until
+  codegen_allocator_clean_blocks() or codegen_allocator_free() is called on them,
+  and executable otherwise.*/
 #if defined __ARM_EABI__ || defined _ARM_ || defined _M_ARM
 #define MEM_BLOCK_NR 32768
 #else
@@ -21,6 +30,9 @@
 
 #define MEM_BLOCK_MASK (MEM_BLOCK_NR-1)
 #define MEM_BLOCK_SIZE 0x3c0
+/*Number of blocks committed at a time, 7.5 MB. This is a multiple of all likely
+  host page sizes*/
+#define MEM_BLOCK_CHUNK 8192
 
 void codegen_allocator_init();
 /*Allocate a mem_block_t, and the associated backing memory.
@@ -31,7 +43,7 @@ struct mem_block_t *codegen_allocator_allocate(struct mem_block_t *parent, int c
 void codegen_allocator_free(struct mem_block_t *block);
 /*Get a pointer to the backing memory associated with block*/
 uint8_t *codeblock_allocator_get_ptr(struct mem_block_t *block);
-/*Cache clean memory block list*/
+/*Cache clean memory block list, and make it executable once code has been emitted*/
 void codegen_allocator_clean_blocks(struct mem_block_t *block);
 
 extern int codegen_allocator_usage;
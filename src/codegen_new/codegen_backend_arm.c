@@ -75,7 +75,7 @@ static void build_load_routine(codeblock_t *block, int size, int is_float)
 	/*MOV R1, R0, LSR #12
 	  MOV R2, #readlookup2
 	  LDR R1, [R2, R1, LSL #2]
-	  CMP R1, #-1
+	  CMP R1, #LOOKUP_INV
 	  BNE +
 	  LDRB R0, [R1, R0]
 	  MOV R1, #0
@@ -94,7 +94,7 @@ static void build_load_routine(codeblock_t *block, int size, int is_float)
 		host_arm_TST_IMM(block, REG_R0, size-1);
 		misaligned_offset = host_arm_BNE_(block);
 	}
-	host_arm_CMP_IMM(block, REG_R1, -1);
+	host_arm_CMP_IMM(block, REG_R1, LOOKUP_INV);
 	branch_offset = host_arm_BEQ_(block);
 	if (size == 1 && !is_float)
 		host_arm_LDRB_REG(block, REG_R0, REG_R1, REG_R0);
@@ -147,7 +147,7 @@ static void build_store_routine(codeblock_t *block, int size, int is_float)
 	/*MOV R1, R0, LSR #12
 	  MOV R2, #readlookup2
 	  LDR R1, [R2, R1, LSL #2]
-	  CMP R1, #-1
+	  CMP R1, #LOOKUP_INV
 	  BNE +
 	  LDRB R0, [R1, R0]
 	  MOV R1, #0
@@ -166,7 +166,7 @@ static void build_store_routine(codeblock_t *block, int size, int is_float)
 		host_arm_TST_IMM(block, REG_R0, size-1);
 		misaligned_offset = host_arm_BNE_(block);
 	}
-	host_arm_CMP_IMM(block, REG_R2, -1);
+	host_arm_CMP_IMM(block, REG_R2, LOOKUP_INV);
 	branch_offset = host_arm_BEQ_(block);
 	if (size == 1 && !is_float)
 		host_arm_STRB_REG(block, REG_R1, REG_R2, REG_R0);
@@ -326,6 +326,8 @@ printf("block_pos=%i\n", block_pos);
 	host_arm_LDMIA_WB(block, REG_HOST_SP, REG_MASK_LOCAL | REG_MASK_PC);
 
         block_write_data = NULL;
+
+        codegen_allocator_clean_blocks(block->head_mem_block);
 //fatal("block_pos=%i\n", block_pos);
 #if !defined _MSC_VER || defined __clang__
 	asm("vmrs %0, fpscr\n"
@@ -80,7 +80,7 @@ static void build_load_routine(codeblock_t *block, int size, int is_float)
 	/*MOV W1, W0, LSR #12
 	  MOV X2, #readlookup2
 	  LDR X1, [X2, X1, LSL #3]
-	  CMP X1, #-1
+	  CMP X1, #LOOKUP_INV
 	  BEQ +
 	  LDRB W0, [X1, X0]
 	  MOV W1, #0
@@ -100,7 +100,7 @@ static void build_load_routine(codeblock_t *block, int size, int is_float)
 		host_arm64_TST_IMM(block, REG_W0, size-1);
 		misaligned_offset = host_arm64_BNE_(block);
 	}
-	host_arm64_CMPX_IMM(block, REG_X1, -1);
+	host_arm64_CMPX_IMM(block, REG_X1, LOOKUP_INV);
 	branch_offset = host_arm64_BEQ_(block);
 	if (size == 1 && !is_float)
 		host_arm64_LDRB_REG(block, REG_W0, REG_W1, REG_W0);
@@ -149,7 +149,7 @@ static void build_store_routine(codeblock_t *block, int size, int is_float)
 	/*MOV W2, W0, LSR #12
 	  MOV X3, #writelookup2
 	  LDR X2, [X3, X2, LSL #3]
-	  CMP X2, #-1
+	  CMP X2, #LOOKUP_INV
 	  BEQ +
 	  STRB W1, [X2, X0]
 	  MOV W1, #0
@@ -169,7 +169,7 @@ static void build_store_routine(codeblock_t *block, int size, int is_float)
 		host_arm64_TST_IMM(block, REG_W0, size-1);
 		misaligned_offset = host_arm64_BNE_(block);
 	}
-	host_arm64_CMPX_IMM(block, REG_X2, -1);
+	host_arm64_CMPX_IMM(block, REG_X2, LOOKUP_INV);
 	branch_offset = host_arm64_BEQ_(block);
 	if (size == 1 && !is_float)
 		host_arm64_STRB_REG(block, REG_X1, REG_X2, REG_X0);
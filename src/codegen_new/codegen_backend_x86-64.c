@@ -79,7 +79,7 @@ static void build_load_routine(codeblock_t *block, int size, int is_float)
         /*MOV ECX, ESI
           SHR ESI, 12
           MOV RSI, [readlookup2+ESI*4]
-          CMP ESI, -1
+          CMP ESI, LOOKUP_INV
           JNZ +
           MOVZX ECX, B[RSI+RCX]
           XOR ESI,ESI
@@ -103,7 +103,7 @@ static void build_load_routine(codeblock_t *block, int size, int is_float)
                 host_x86_TEST32_REG_IMM(block, REG_ECX, size-1);
                 misaligned_offset = host_x86_JNZ_short(block);
         }
-        host_x86_CMP64_REG_IMM(block, REG_RSI, (uint32_t)-1);
+        host_x86_CMP64_REG_IMM(block, REG_RSI, (uint32_t)LOOKUP_INV);
         branch_offset = host_x86_JZ_short(block);
         if (size == 1 && !is_float)
                 host_x86_MOVZX_BASE_INDEX_32_8(block, REG_ECX, REG_RSI, REG_RCX);
@@ -177,7 +177,7 @@ static void build_store_routine(codeblock_t *block, int size, int is_float)
         /*MOV EDI, ESI
           SHR ESI, 12
           MOV ESI, [writelookup2+ESI*4]
-          CMP ESI, -1
+          CMP ESI, LOOKUP_INV
           JNZ +
           MOV [RSI+RDI], ECX
           XOR ESI,ESI
@@ -201,7 +201,7 @@ static void build_store_routine(codeblock_t *block, int size, int is_float)
                 host_x86_TEST32_REG_IMM(block, REG_EDI, size-1);
                 misaligned_offset = host_x86_JNZ_short(block);
         }
-        host_x86_CMP64_REG_IMM(block, REG_RSI, (uint32_t)-1);
+        host_x86_CMP64_REG_IMM(block, REG_RSI, (uint32_t)LOOKUP_INV);
         branch_offset = host_x86_JZ_short(block);
         if (size == 1 && !is_float)
                 host_x86_MOV8_BASE_INDEX_REG(block, REG_RSI, REG_RDI, REG_ECX);
@@ -342,6 +342,8 @@ void codegen_backend_init()
 
         block_write_data = NULL;
 
+        codegen_allocator_clean_blocks(block->head_mem_block);
+
         cpu_state.trunc_fp_control = _mm_getcsr() | 0x6000;
 }
 
@@ -385,5 +387,7 @@ void codegen_backend_epilogue(codeblock_t *block)
         host_x86_POP(block, REG_RBP);
         host_x86_POP(block, REG_RDX);
         host_x86_RET(block);
+
+        codegen_allocator_clean_blocks(block->head_mem_block);
 }
 #endif
@@ -71,7 +71,7 @@ static void build_load_routine(codeblock_t *block, int size, int is_float)
         /*MOV ECX, ESI
           SHR ESI, 12
           MOV ESI, [readlookup2+ESI*4]
-          CMP ESI, -1
+          CMP ESI, LOOKUP_INV
           JNZ +
           MOVZX ECX, B[ESI+ECX]
           XOR ESI,ESI
@@ -94,7 +94,7 @@ static void build_load_routine(codeblock_t *block, int size, int is_float)
                 host_x86_TEST32_REG_IMM(block, REG_ECX, size-1);
                 misaligned_offset = host_x86_JNZ_short(block);
         }
-        host_x86_CMP32_REG_IMM(block, REG_ESI, (uint32_t)-1);
+        host_x86_CMP32_REG_IMM(block, REG_ESI, (uint32_t)LOOKUP_INV);
         branch_offset = host_x86_JZ_short(block);
         if (size == 1 && !is_float)
                 host_x86_MOVZX_BASE_INDEX_32_8(block, REG_ECX, REG_ESI, REG_ECX);
@@ -161,7 +161,7 @@ static void build_store_routine(codeblock_t *block, int size, int is_float)
         /*MOV EDI, ESI
           SHR ESI, 12
           MOV ESI, [writelookup2+ESI*4]
-          CMP ESI, -1
+          CMP ESI, LOOKUP_INV
           JNZ +
           MOV [ESI+EDI], ECX
           XOR ESI,ESI
@@ -184,7 +184,7 @@ static void build_store_routine(codeblock_t *block, int size, int is_float)
                 host_x86_TEST32_REG_IMM(block, REG_EDI, size-1);
                 misaligned_offset = host_x86_JNZ_short(block);
         }
-        host_x86_CMP32_REG_IMM(block, REG_ESI, (uint32_t)-1);
+        host_x86_CMP32_REG_IMM(block, REG_ESI, (uint32_t)LOOKUP_INV);
         branch_offset = host_x86_JZ_short(block);
         if (size == 1 && !is_float)
                 host_x86_MOV8_BASE_INDEX_REG(block, REG_ESI, REG_EDI, REG_ECX);
@@ -303,6 +303,8 @@ void codegen_backend_init()
         host_x86_RET(block);
         block_write_data = NULL;
 
+        codegen_allocator_clean_blocks(block->head_mem_block);
+
         cpu_state.old_fp_control = 0;
 #ifndef _MSC_VER
         asm(
@@ -354,6 +356,8 @@ void codegen_backend_epilogue(codeblock_t *block)
         host_x86_POP(block, REG_EBP);
         host_x86_POP(block, REG_EDX);
         host_x86_RET(block);
+
+        codegen_allocator_clean_blocks(block->head_mem_block);
 }
 
 #endif
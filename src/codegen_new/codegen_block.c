@@ -51,6 +51,10 @@ static int last_ssegs;
 uint32_t instr_counts[256*256];
 #endif
 
+uint16_t codeblock_lookup[CODEBLOCK_LOOKUP_SIZE];
+uint64_t codeblock_lookup_count, codeblock_lookup_found, codeblock_lookup_depth;
+uint64_t codeblock_hash_count, codeblock_hash_hits;
+
 static uint16_t block_free_list;
 static void delete_block(codeblock_t *block);
 static void delete_dirty_block(codeblock_t *block);
@@ -65,6 +69,16 @@ static uint16_t block_dirty_list_head, block_dirty_list_tail;
 static int dirty_list_size = 0;
 #define DIRTY_LIST_MAX_SIZE 64
 
+/*Eviction state. evict_hand is the current position of the clock sweep.
+  evict_ghost remembers the keys of recently evicted blocks, so that blocks
+  compiled again because they were evicted can be counted.*/
+#define EVICT_BATCH_SIZE 8
+#define EVICT_GHOST_SIZE 0x1000
+#define EVICT_GHOST_MASK (EVICT_GHOST_SIZE-1)
+static int evict_hand = 1;
+static uint32_t evict_ghost[EVICT_GHOST_SIZE];
+uint64_t codegen_evict_count, codegen_evict_recompiles;
+
 static void block_free_list_add(codeblock_t *block)
 {
 #ifndef RELEASE_BUILD
@@ -198,9 +212,9 @@ static codeblock_t *block_free_list_get()
                         block_free_list = get_block_nr(block);
                         break;
                 }
-                /*Free list is empty - free up a block*/
+                /*Free list is empty - free up some blocks*/
                 if (!codegen_purge_purgable_list())
-                        codegen_delete_random_block(0);
+                        codegen_evict_blocks(0, BLOCK_INVALID);
         }
 
         block = &codeblock[block_free_list];
@@ -222,6 +236,12 @@ void codegen_init()
                 block_free_list_add(&codeblock[c]);
         block_dirty_list_head = block_dirty_list_tail = 0;
         dirty_list_size = 0;
+        memset(codeblock_lookup, 0, sizeof(codeblock_lookup));
+        memset(evict_ghost, 0, sizeof(evict_ghost));
+        evict_hand = 1;
+        codegen_evict_count = codegen_evict_recompiles = 0;
+        codeblock_lookup_count = codeblock_lookup_found = codeblock_lookup_depth = 0;
+        codeblock_hash_count = codeblock_hash_hits = 0;
 #ifdef DEBUG_EXTRA
         memset(instr_counts, 0, sizeof(instr_counts));
 #endif
@@ -254,6 +274,14 @@ void codegen_close()
                         pclog("    %02x = %u\n", highest_idx & 0xff, highest_num);
         }
 #endif
+        pclog("Block lookups :\n");
+        pclog(" hash: %llu lookups, %llu hits (%.2f%%)\n", codeblock_hash_count, codeblock_hash_hits,
+              codeblock_hash_count ? ((double)codeblock_hash_hits * 100.0) / (double)codeblock_hash_count : 0.0);
+        pclog(" table: %llu lookups, %llu found, %llu misses, average depth %.2f\n",
+              codeblock_lookup_count, codeblock_lookup_found, codeblock_lookup_count - codeblock_lookup_found,
+              codeblock_lookup_count ? (double)codeblock_lookup_depth / (double)codeblock_lookup_count : 0.0);
+        pclog("Code cache: %llu blocks evicted, %llu recompiled after eviction\n",
+              codegen_evict_count, codegen_evict_recompiles);
 }
 
 void codegen_reset()
@@ -274,6 +302,7 @@ void codegen_reset()
 
         memset(codeblock, 0, BLOCK_SIZE * sizeof(codeblock_t));
         memset(codeblock_hash, 0, HASH_SIZE * sizeof(uint16_t));
+        memset(codeblock_lookup, 0, sizeof(codeblock_lookup));
         mem_reset_page_blocks();
 
         block_free_list = 0;
@@ -431,7 +460,7 @@ static void delete_block(codeblock_t *block)
 #endif
         block->pc = BLOCK_PC_INVALID;
 
-        codeblock_tree_delete(block);
+        codeblock_lookup_delete(block);
         if (block->flags & CODEBLOCK_IN_DIRTY_LIST)
                 block_dirty_list_remove(block);
         else
@@ -453,7 +482,7 @@ static void delete_dirty_block(codeblock_t *block)
 #endif
         block->pc = BLOCK_PC_INVALID;
 
-        codeblock_tree_delete(block);
+        codeblock_lookup_delete(block);
         block_free_list_add(block);
 }
 
@@ -463,23 +492,39 @@ void codegen_delete_block(codeblock_t *block)
                 delete_block(block);
 }
 
-void codegen_delete_random_block(int required_mem_block)
+static uint32_t evict_ghost_key(codeblock_t *block)
 {
-        int block_nr = rand() & BLOCK_MASK;
-        
-        while (1)
+        return block->phys ^ (block->_cs * 0x9e3779b1);
+}
+
+void codegen_evict_blocks(int required_mem_block, int exclude_block)
+{
+        int evicted = 0, scanned = 0;
+
+        while (evicted < EVICT_BATCH_SIZE && scanned < (BLOCK_SIZE * 2))
         {
-                if (block_nr && block_nr != block_current)
-                {
-                        codeblock_t *block = &codeblock[block_nr];
+                int block_nr = evict_hand;
+                codeblock_t *block = &codeblock[block_nr];
 
-                        if (block->pc != BLOCK_PC_INVALID && (!required_mem_block || block->head_mem_block))
-                        {
-                                delete_block(block);
-                                return;
-                        }
+                evict_hand = (evict_hand + 1) & BLOCK_MASK;
+                scanned++;
+
+                if (!block_nr || block_nr == block_current || block_nr == exclude_block)
+                        continue;
+                if (block->pc == BLOCK_PC_INVALID || (required_mem_block && !block->head_mem_block))
+                        continue;
+
+                if (block->flags & CODEBLOCK_REFERENCED)
+                {
+                        /*Second chance*/
+                        block->flags &= ~CODEBLOCK_REFERENCED;
+                        continue;
                 }
-                block_nr = (block_nr + 1) & BLOCK_MASK;
+
+                evict_ghost[codeblock_lookup_hash(block->phys, block->_cs) & EVICT_GHOST_MASK] = evict_ghost_key(block);
+                delete_block(block);
+                codegen_evict_count++;
+                evicted++;
         }
 }
 
@@ -565,11 +610,17 @@ void codegen_block_init(uint32_t phys_addr)
         block->next = block->prev = BLOCK_INVALID;
         block->next_2 = block->prev_2 = BLOCK_INVALID;
         block->page_mask = block->page_mask2 = 0;
-        block->flags = CODEBLOCK_STATIC_TOP;
+        block->flags = CODEBLOCK_STATIC_TOP | CODEBLOCK_REFERENCED;
         block->status = cpu_cur_status;
         
         recomp_page = block->phys & ~0xfff;
-        codeblock_tree_add(block);
+        codeblock_lookup_add(block);
+
+        if (evict_ghost[codeblock_lookup_hash(block->phys, block->_cs) & EVICT_GHOST_MASK] == evict_ghost_key(block))
+        {
+                evict_ghost[codeblock_lookup_hash(block->phys, block->_cs) & EVICT_GHOST_MASK] = 0;
+                codegen_evict_recompiles++;
+        }
 }
 
 static ir_data_t *ir_data;
@@ -680,6 +680,16 @@ load_machine(void)
 	mem_size = 2097152;
 
     cpu_use_dynarec = !!config_get_int(cat, "cpu_use_dynarec", 0);
+    dynarec_cache_size = config_get_int(cat, "dynarec_cache_size", 0);
+    if (dynarec_cache_size < 0)
+	dynarec_cache_size = 0;
+    mmu_tlb_size = config_get_int(cat, "mmu_tlb_size", 0);
+    if (mmu_tlb_size < 0)
+	mmu_tlb_size = 0;
+    mmu_tlb_ways = config_get_int(cat, "mmu_tlb_ways", 0);
+    if (mmu_tlb_ways < 0)
+	mmu_tlb_ways = 0;
+    cpu_decode_cache = !!config_get_int(cat, "cpu_decode_cache", 0);
 
     p = config_get_string(cat, "time_sync", NULL);
     if (p != NULL) {        
@@ -1120,6 +1130,21 @@ load_hard_disks(void)
 		wcsncat(hdd[c].fn, wp, sizeof_w(hdd[c].fn)-wcslen(usr_path));
 	}
 
+	sprintf(temp, "hdd_%02i_mmap", c+1);
+	hdd[c].mmap = !!config_get_int(cat, temp, 0);
+
+	memset(hdd[c].overlay_fn, 0x00, sizeof(hdd[c].overlay_fn));
+	sprintf(temp, "hdd_%02i_overlay_fn", c+1);
+	wp = config_get_wstring(cat, temp, L"");
+	if (wp[0] != 0) {
+		if (plat_path_abs(wp)) {
+			wcsncpy(hdd[c].overlay_fn, wp, sizeof_w(hdd[c].overlay_fn));
+		} else {
+			wcsncpy(hdd[c].overlay_fn, usr_path, sizeof_w(hdd[c].overlay_fn));
+			wcsncat(hdd[c].overlay_fn, wp, sizeof_w(hdd[c].overlay_fn)-wcslen(usr_path));
+		}
+	}
+
 	/* If disk is empty or invalid, mark it for deletion. */
 	if (! hdd_is_valid(c)) {
 		sprintf(temp, "hdd_%02i_parameters", c+1);
@@ -1136,6 +1161,12 @@ load_hard_disks(void)
 
 		sprintf(temp, "hdd_%02i_fn", c+1);
 		config_delete_var(cat, temp);
+
+		sprintf(temp, "hdd_%02i_mmap", c+1);
+		config_delete_var(cat, temp);
+
+		sprintf(temp, "hdd_%02i_overlay_fn", c+1);
+		config_delete_var(cat, temp);
 	}
 
 	sprintf(temp, "hdd_%02i_mfm_channel", c+1);
@@ -1983,6 +2014,26 @@ save_machine(void)
 
     config_set_int(cat, "cpu_use_dynarec", cpu_use_dynarec);
 
+    if (dynarec_cache_size == 0)
+	config_delete_var(cat, "dynarec_cache_size");
+      else
+	config_set_int(cat, "dynarec_cache_size", dynarec_cache_size);
+
+    if (mmu_tlb_size == 0)
+	config_delete_var(cat, "mmu_tlb_size");
+      else
+	config_set_int(cat, "mmu_tlb_size", mmu_tlb_size);
+
+    if (mmu_tlb_ways == 0)
+	config_delete_var(cat, "mmu_tlb_ways");
+      else
+	config_set_int(cat, "mmu_tlb_ways", mmu_tlb_ways);
+
+    if (!cpu_decode_cache)
+	config_delete_var(cat, "cpu_decode_cache");
+      else
+	config_set_int(cat, "cpu_decode_cache", cpu_decode_cache);
+
     if (time_sync & TIME_SYNC_ENABLED)
 	if (time_sync & TIME_SYNC_UTC)
 		config_set_string(cat, "time_sync", "utc");
@@ -2323,6 +2374,21 @@ save_hard_disks(void)
 			config_set_wstring(cat, temp, hdd[c].fn);
 	else
 		config_delete_var(cat, temp);
+
+	sprintf(temp, "hdd_%02i_mmap", c+1);
+	if (hdd_is_valid(c) && hdd[c].mmap)
+		config_set_int(cat, temp, hdd[c].mmap);
+	else
+		config_delete_var(cat, temp);
+
+	sprintf(temp, "hdd_%02i_overlay_fn", c+1);
+	if (hdd_is_valid(c) && (wcslen(hdd[c].overlay_fn) != 0))
+		if (!wcsnicmp(hdd[c].overlay_fn, usr_path, wcslen(usr_path)))
+			config_set_wstring(cat, temp, &hdd[c].overlay_fn[wcslen(usr_path)]);
+		else
+			config_set_wstring(cat, temp, hdd[c].overlay_fn);
+	else
+		config_delete_var(cat, temp);
     }
 
     delete_section_if_empty(cat);
@@ -71,10 +71,146 @@ x386_log(const char *fmt, ...)
 #undef CPU_BLOCK_END
 #define CPU_BLOCK_END()
 
+/*Decoded effective address cache. The part of an instruction that leads up to
+  and includes its memory operand (prefixes, opcode, ModRM, SIB, displacement)
+  is kept in decoded form, keyed by the host address of the instruction, so that
+  a loop going round again doesn't have to walk the ModRM/SIB bytes and refetch
+  the displacement every time. Only the decode is cached - the address itself is
+  always recomputed from the current registers.
+
+  Each entry keeps the (at most 8) bytes it was decoded from and is checked
+  against memory before use. The interpreter writes straight through the write
+  lookups, which never touch the page dirty masks, so this is what catches
+  self-modifying code, DMA and ROM reflashing.*/
+#define DEC_SIZE        8192
+#define DEC_MASK        (DEC_SIZE - 1)
+#define DEC_HASH(h)     (((h) ^ ((h) >> 13)) & DEC_MASK)
+
+#define DEC_A32         1
+#define DEC_SS          2       /*Defaults to SS rather than DS*/
+#define DEC_DIRECT      4       /*16-bit displacement only, no base or index*/
+
+#define DEC_NO_REG      8
+
+typedef struct dec_t
+{
+        uintptr_t host;
+        uint64_t bytes;
+        uint32_t disp;
+        uint8_t modrm, len, ea_pos, ea_len;
+        uint8_t flags, base, index, shift;
+} dec_t;
+
+static dec_t dec_cache[DEC_SIZE];
+static dec_t *dec_cur;
+static uintptr_t dec_host;
+static uint64_t dec_bytes;
+static uint32_t dec_pc;
+
+static __inline void dec_begin(uint32_t addr)
+{
+        dec_host = (uintptr_t)&pccache2[addr];
+        dec_pc = cpu_state.pc;
+        memcpy(&dec_bytes, (void *)dec_host, 8);
+        dec_cur = &dec_cache[DEC_HASH(dec_host)];
+}
+
+static __inline uint32_t dec_base(dec_t *dec)
+{
+        uint32_t addr = 0;
+
+        if (dec->flags & DEC_A32)
+        {
+                if (dec->base != DEC_NO_REG)
+                        addr += cpu_state.regs[dec->base].l;
+                if (dec->index != DEC_NO_REG)
+                        addr += cpu_state.regs[dec->index].l << dec->shift;
+        }
+        else if (!(dec->flags & DEC_DIRECT))
+                addr = (*mod1add[0][cpu_rm]) + (*mod1add[1][cpu_rm]);
+
+        return addr;
+}
+
+/*Returns 1 if the memory operand of the current instruction was decoded from
+  the cache. Called with cpu_state.pc just past the ModRM byte. MOV SS and POP SS
+  run the following instruction themselves, that one is never cached.*/
+static __inline int dec_lookup(uint32_t rmdat, int a32)
+{
+        dec_t *dec = dec_cur;
+
+        dec_cur = NULL;
+        if (cpu_state.oldpc != dec_pc)
+                return 0;
+        if ((dec->host != dec_host) || ((dec->flags & DEC_A32) != a32) ||
+            (dec->modrm != (rmdat & 0xff)) || (dec->ea_pos != (uint8_t)(cpu_state.pc - cpu_state.oldpc)))
+        {
+                dec_cur = dec;
+                return 0;
+        }
+        if ((dec_bytes & (~0ULL >> (64 - (dec->len << 3)))) != dec->bytes)
+        {
+                dec_cur = dec;
+                return 0;
+        }
+
+        cpu_state.eaaddr = dec->disp + dec_base(dec);
+        if (!a32)
+                cpu_state.eaaddr &= 0xFFFF;
+        if ((dec->flags & DEC_SS) && !cpu_state.ssegs)
+        {
+                easeg = ss;
+                cpu_state.ea_seg = &cpu_state.seg_ss;
+        }
+        cpu_state.pc += dec->ea_len;
+        return 1;
+}
+
+static __inline void dec_store(uint32_t rmdat, uint32_t ea_pc, int flags, int base, int index, int shift)
+{
+        dec_t *dec = dec_cur;
+        uint32_t len = cpu_state.pc - cpu_state.oldpc;
+
+        dec_cur = NULL;
+        if (cpu_state.abrt || (cpu_state.oldpc != dec_pc) || (len > 8))
+                return;
+
+        dec->host = dec_host;
+        dec->bytes = dec_bytes & (~0ULL >> (64 - (len << 3)));
+        dec->modrm = rmdat & 0xff;
+        dec->len = len;
+        dec->ea_pos = ea_pc - cpu_state.oldpc;
+        dec->ea_len = cpu_state.pc - ea_pc;
+        dec->flags = flags;
+        dec->base = base;
+        dec->index = index;
+        dec->shift = shift;
+        dec->disp = cpu_state.eaaddr - dec_base(dec);
+}
+
+static __inline void fetch_ea_lookup(void)
+{
+        if (easeg != 0xFFFFFFFF && ((easeg + cpu_state.eaaddr) & 0xFFF) <= 0xFFC)
+        {
+		uint32_t addr = easeg + cpu_state.eaaddr;
+                if ( readlookup2[addr >> 12] != LOOKUP_INV)
+                	eal_r = (uint32_t *)(readlookup2[addr >> 12] + addr);
+                if (writelookup2[addr >> 12] != LOOKUP_INV)
+                	eal_w = (uint32_t *)(writelookup2[addr >> 12] + addr);
+        }
+}
+
 static inline void fetch_ea_32_long(uint32_t rmdat)
 {
+        uint32_t ea_pc = cpu_state.pc;
+
         eal_r = eal_w = NULL;
         easeg = cpu_state.ea_seg->base;
+        if (dec_cur && dec_lookup(rmdat, DEC_A32))
+        {
+                fetch_ea_lookup();
+                return;
+        }
         if (cpu_rm == 4)
         {
                 uint8_t sib = rmdat >> 8;
@@ -131,20 +267,35 @@ static inline void fetch_ea_32_long(uint32_t rmdat)
                         cpu_state.eaaddr = getlong();
                 }
         }
-        if (easeg != 0xFFFFFFFF && ((easeg + cpu_state.eaaddr) & 0xFFF) <= 0xFFC)
+        if (dec_cur)
         {
-		uint32_t addr = easeg + cpu_state.eaaddr;
-                if ( readlookup2[addr >> 12] != -1)
-                	eal_r = (uint32_t *)(readlookup2[addr >> 12] + addr);
-                if (writelookup2[addr >> 12] != -1)
-                	eal_w = (uint32_t *)(writelookup2[addr >> 12] + addr);
+                if (cpu_rm == 4)
+                {
+                        uint8_t sib = rmdat >> 8;
+                        int base = ((sib & 7) == 5 && !cpu_mod) ? DEC_NO_REG : (sib & 7);
+
+                        dec_store(rmdat, ea_pc, DEC_A32 | (((base & 6) == 4) ? DEC_SS : 0), base,
+                                  (((sib >> 3) & 7) != 4) ? ((sib >> 3) & 7) : DEC_NO_REG, sib >> 6);
+                }
+                else if (!cpu_mod && cpu_rm == 5)
+                        dec_store(rmdat, ea_pc, DEC_A32, DEC_NO_REG, DEC_NO_REG, 0);
+                else
+                        dec_store(rmdat, ea_pc, DEC_A32 | ((cpu_mod && cpu_rm == 5) ? DEC_SS : 0), cpu_rm, DEC_NO_REG, 0);
         }
+        fetch_ea_lookup();
 }
 
 static inline void fetch_ea_16_long(uint32_t rmdat)
 {
+        uint32_t ea_pc = cpu_state.pc;
+
         eal_r = eal_w = NULL;
         easeg = cpu_state.ea_seg->base;
+        if (dec_cur && dec_lookup(rmdat, 0))
+        {
+                fetch_ea_lookup();
+                return;
+        }
         if (!cpu_mod && cpu_rm == 6)
         { 
                 cpu_state.eaaddr = getword();
@@ -171,14 +322,14 @@ static inline void fetch_ea_16_long(uint32_t rmdat)
                 }
                 cpu_state.eaaddr &= 0xFFFF;
         }
-        if (easeg != 0xFFFFFFFF && ((easeg + cpu_state.eaaddr) & 0xFFF) <= 0xFFC)
+        if (dec_cur)
         {
-		uint32_t addr = easeg + cpu_state.eaaddr;
-                if ( readlookup2[addr >> 12] != -1)
-                	eal_r = (uint32_t *)(readlookup2[addr >> 12] + addr);
-                if (writelookup2[addr >> 12] != -1)
-                	eal_w = (uint32_t *)(writelookup2[addr >> 12] + addr);
+                if (!cpu_mod && cpu_rm == 6)
+                        dec_store(rmdat, ea_pc, DEC_DIRECT, DEC_NO_REG, DEC_NO_REG, 0);
+                else
+                        dec_store(rmdat, ea_pc, (mod1seg[cpu_rm] == &ss) ? DEC_SS : 0, DEC_NO_REG, DEC_NO_REG, 0);
         }
+        fetch_ea_lookup();
 }
 
 #define fetch_ea_16(rmdat)              cpu_state.pc++; cpu_mod=(rmdat >> 6) & 3; cpu_reg=(rmdat >> 3) & 7; cpu_rm = rmdat & 7; if (cpu_mod != 3) { fetch_ea_16_long(rmdat); if (cpu_state.abrt) return 0; } 
@@ -234,6 +385,10 @@ exec386(int cycs)
 
 		fetchdat = fastreadl(cs + cpu_state.pc);
 
+		dec_cur = NULL;
+		if (cpu_decode_cache && !cpu_state.abrt && (((cs + cpu_state.pc) & 0xfff) <= 0xff8))
+			dec_begin(cs + cpu_state.pc);
+
 		if (!cpu_state.abrt) {
 #ifdef ENABLE_386_LOG
 			if (in_smm)
@@ -121,9 +121,9 @@ static __inline void fetch_ea_32_long(uint32_t rmdat)
 	if (easeg != 0xFFFFFFFF && ((easeg + cpu_state.eaaddr) & 0xFFF) <= 0xFFC)
 	{
 		uint32_t addr = easeg + cpu_state.eaaddr;
-		if ( readlookup2[addr >> 12] != -1)
+		if ( readlookup2[addr >> 12] != LOOKUP_INV)
 		   eal_r = (uint32_t *)(readlookup2[addr >> 12] + addr);
-		if (writelookup2[addr >> 12] != -1)
+		if (writelookup2[addr >> 12] != LOOKUP_INV)
 		   eal_w = (uint32_t *)(writelookup2[addr >> 12] + addr);
 	}
 }
@@ -161,9 +161,9 @@ static __inline void fetch_ea_16_long(uint32_t rmdat)
 	if (easeg != 0xFFFFFFFF && ((easeg + cpu_state.eaaddr) & 0xFFF) <= 0xFFC)
 	{
 		uint32_t addr = easeg + cpu_state.eaaddr;
-		if ( readlookup2[addr >> 12] != -1)
+		if ( readlookup2[addr >> 12] != LOOKUP_INV)
 		   eal_r = (uint32_t *)(readlookup2[addr >> 12] + addr);
-		if (writelookup2[addr >> 12] != -1)
+		if (writelookup2[addr >> 12] != LOOKUP_INV)
 		   eal_w = (uint32_t *)(writelookup2[addr >> 12] + addr);
 	}
 }
@@ -406,6 +406,11 @@ exec386_dynarec_dyn(void)
 	valid_block = (block->pc == cs + cpu_state.pc) && (block->_cs == cs) &&
 		      (block->phys == phys_addr) && !((block->status ^ cpu_cur_status) & CPU_STATUS_FLAGS) &&
 		      ((block->status & cpu_cur_status & CPU_STATUS_MASK) == (cpu_cur_status & CPU_STATUS_MASK));
+#ifdef USE_NEW_DYNAREC
+	codeblock_hash_count++;
+	if (valid_block)
+		codeblock_hash_hits++;
+#endif
 	if (!valid_block) {
 		uint64_t mask = (uint64_t)1 << ((phys_addr >> PAGE_MASK_SHIFT) & PAGE_MASK_MASK);
 #ifdef USE_NEW_DYNAREC
@@ -418,7 +423,11 @@ exec386_dynarec_dyn(void)
 #endif
 		{
 			/* Walk page tree to see if we find the correct block */
+#ifdef USE_NEW_DYNAREC
+			codeblock_t *new_block = codeblock_lookup_find(phys_addr, cs);
+#else
 			codeblock_t *new_block = codeblock_tree_find(phys_addr, cs);
+#endif
 			if (new_block) {
 				valid_block = (new_block->pc == cs + cpu_state.pc) && (new_block->_cs == cs) &&
 					      (new_block->phys == phys_addr) && !((new_block->status ^ cpu_cur_status) & CPU_STATUS_FLAGS) &&
@@ -511,7 +520,9 @@ exec386_dynarec_dyn(void)
     {
 	void (*code)() = (void *)&block->data[BLOCK_START];
 
-#ifndef USE_NEW_DYNAREC
+#ifdef USE_NEW_DYNAREC
+	block->flags |= CODEBLOCK_REFERENCED;
+#else
 	codeblock_hash[hash] = block;
 #endif
 	inrecomp = 1;
@@ -15,6 +15,7 @@
  *		Copyright 2015-2020 Andrew Jenner.
  *		Copyright 2016-2020 Miran Grca.
  */
+#include <inttypes.h>
 #include <math.h>
 #include <stdarg.h>
 #include <stdint.h>
@@ -188,7 +189,8 @@ dumpregs(int force)
 	x808x_log("AX=%04X BX=%04X CX=%04X DX=%04X DI=%04X SI=%04X BP=%04X SP=%04X\n",
 		  AX, BX, CX, DX, DI, SI, BP, SP);
     }
-    x808x_log("Entries in readlookup : %i    writelookup : %i\n", readlnum, writelnum);
+    x808x_log("TLB misses - read : %i    write : %i\n", readlnum, writelnum);
+    x808x_log("TLB flushes : %i    kept : %" PRIu64 "    INVLPG : %i\n", mmuflush, mmu_tlb_kept, mmu_tlb_invlpg);
     x87_dumpregs();
     indump = 0;
 }
@@ -980,7 +982,7 @@ reset_common(int hard)
 	makemod1table();
 	pfq_clear();
 	cpu_set_edx();
-	mmu_perm = 4;
+	mmu_perm = MMU_PERM_USER | MMU_PERM_WRITE;
 	pfq_size = (is8086) ? 6 : 4;
     }
     x86seg_reset();
@@ -125,11 +125,9 @@ enum {
 #define CPU_ALTERNATE_XTAL   4
 #define CPU_FIXED_MULTIPLIER 8
 
-#if (defined __amd64__ || defined _M_X64)
-#define LOOKUP_INV		-1LL
-#else
-#define LOOKUP_INV		-1
-#endif
+/* Invalid readlookup2/writelookup2 entry. This is zero so that the parts of
+   the tables that are never used stay as untouched demand-zero memory. */
+#define LOOKUP_INV		0
 
 
 typedef struct {
@@ -197,6 +195,7 @@ typedef struct {
 #define CR4_PVI		(1 << 1)
 #define CR4_PSE		(1 << 4)
 #define CR4_PAE		(1 << 5)
+#define CR4_PGE		(1 << 7)
 
 #define CPL ((cpu_state.seg_cs.access>>5)&3)
 
@@ -129,7 +129,7 @@ static int opMOV_CRx_r_a16(uint32_t fetchdat)
                 if (cpu_16bitbus)
                         cr0 |= 0x10;
                 if (!(cr0 & 0x80000000))
-                        mmu_perm=4;
+                        mmu_perm = MMU_PERM_USER | MMU_PERM_WRITE;
                 if (hascache && !(cr0 & (1 << 30)))
                         cpu_cache_int_enabled = 1;
 		else
@@ -146,12 +146,12 @@ static int opMOV_CRx_r_a16(uint32_t fetchdat)
                 break;
                 case 3:
                 cr3 = cpu_state.regs[cpu_rm].l;
-                flushmmucache();
+                flushmmucache_nonglobal();
                 break;
                 case 4:
                 if (cpu_has_feature(CPU_FEATURE_CR4))
                 {
-	                if (((cpu_state.regs[cpu_rm].l ^ cr4) & cpu_CR4_mask) & CR4_PAE)
+	                if (((cpu_state.regs[cpu_rm].l ^ cr4) & cpu_CR4_mask) & (CR4_PAE | CR4_PGE))
         	                flushmmucache();
                         cr4 = cpu_state.regs[cpu_rm].l & cpu_CR4_mask;
                         break;
@@ -185,7 +185,7 @@ static int opMOV_CRx_r_a32(uint32_t fetchdat)
                 if (cpu_16bitbus)
                         cr0 |= 0x10;
                 if (!(cr0 & 0x80000000))
-                        mmu_perm=4;
+                        mmu_perm = MMU_PERM_USER | MMU_PERM_WRITE;
                 if (hascache && !(cr0 & (1 << 30)))
                         cpu_cache_int_enabled = 1;
                 else
@@ -202,12 +202,12 @@ static int opMOV_CRx_r_a32(uint32_t fetchdat)
                 break;
                 case 3:
                 cr3 = cpu_state.regs[cpu_rm].l;
-                flushmmucache();
+                flushmmucache_nonglobal();
                 break;
                 case 4:
                 if (cpu_has_feature(CPU_FEATURE_CR4))
                 {
-	                if (((cpu_state.regs[cpu_rm].l ^ cr4) & cpu_CR4_mask) & CR4_PAE)
+	                if (((cpu_state.regs[cpu_rm].l ^ cr4) & cpu_CR4_mask) & (CR4_PAE | CR4_PGE))
         	                flushmmucache();
                         cr4 = cpu_state.regs[cpu_rm].l & cpu_CR4_mask;
                         break;
@@ -1,7 +1,181 @@
+/*Bulk REP MOVS/STOS/INS/OUTS. A run of forward iterations is done straight on
+  host memory when it stays inside the segment limits and inside one page of
+  plain RAM (pages with code in them never get a write lookup). The run also
+  never goes past the point where the per-iteration loop would have given up
+  its cycle budget, so timing and interrupt latency are unchanged.*/
+#define REP_ADDR_MASK(reg) ((sizeof(reg) == 2) ? 0xffff : 0xffffffff)
+
+static __inline uint32_t rep_bulk_side(x86seg *seg, uint32_t addr, uint32_t addr_mask, int write, uint32_t count, int size, uint8_t **host)
+{
+        uint32_t lin = seg->base + addr;
+        uintptr_t lookup = write ? writelookup2[lin >> 12] : readlookup2[lin >> 12];
+        uint32_t n, top;
+
+        if (lookup == (uintptr_t) LOOKUP_INV)
+                return 0;
+        if (msw&1 && !(cpu_state.eflags&VM_FLAG) && !(seg->access & 0x80))
+                return 0;
+        if (addr < seg->limit_low)
+                return 0;
+
+        n = (0x1000 - (lin & 0xfff)) / size;
+        if (n > count)
+                n = count;
+
+        top = (seg->limit_high < addr_mask) ? seg->limit_high : addr_mask;
+        if ((addr > top) || !n)
+                return 0;
+        if ((top - addr) < ((n * size) - 1))
+                n = ((top - addr) + 1) / size;
+
+        *host = (uint8_t *)(lookup + lin);
+        return n;
+}
+
+static __inline uint32_t rep_bulk_budget(uint32_t count, int per, int cycles_end)
+{
+        uint32_t n;
+
+        if (trap || (count < 2) || (cpu_state.flags & D_FLAG) || (cycles < cycles_end))
+                return 0;
+
+        n = ((cycles - cycles_end) / per) + 1;
+        return (n < count) ? n : count;
+}
+
+static __inline void rep_bulk_fill(uint8_t *p, uint32_t val, int size, uint32_t n)
+{
+        uint32_t len = n * size, c;
+
+        if ((size == 1) || ((size == 2) && ((val & 0xff) == ((val >> 8) & 0xff))) || ((size == 4) && (val == (val & 0xff) * 0x01010101)))
+        {
+                memset(p, val & 0xff, len);
+                return;
+        }
+
+        memcpy(p, &val, size);
+        for (c = size; c < len; c <<= 1)
+                memcpy(p + c, p, MIN(c, len - c));
+}
+
+static __inline uint32_t rep_bulk_movs(uint32_t src, uint32_t dest, uint32_t addr_mask, uint32_t count, int size)
+{
+        uint8_t *hs, *hd;
+        uint32_t n;
+
+        if (!count)
+                return 0;
+
+        n = rep_bulk_side(cpu_state.ea_seg, src, addr_mask, 0, count, size, &hs);
+        if (n)
+                n = rep_bulk_side(&cpu_state.seg_es, dest, addr_mask, 1, n, size, &hd);
+        if (!n)
+                return 0;
+
+        /*An overlapping forward copy repeats the start of the source, which
+          memmove() would not do.*/
+        if ((hd > hs) && (hd < (hs + (n * size))))
+                n = (hd - hs) / size;
+
+        if (n)
+                memmove(hd, hs, n * size);
+        return n;
+}
+
+static __inline uint32_t rep_bulk_stos(uint32_t dest, uint32_t addr_mask, uint32_t count, int size, uint32_t val)
+{
+        uint8_t *hd;
+        uint32_t n;
+
+        if (!count)
+                return 0;
+
+        n = rep_bulk_side(&cpu_state.seg_es, dest, addr_mask, 1, count, size, &hd);
+        if (n)
+                rep_bulk_fill(hd, val, size, n);
+        return n;
+}
+
+/*REP INS/OUTS still go through the port handlers one at a time, but without
+  going back to the dispatcher for every iteration. A port access can change
+  the memory map, so stop as soon as the page is no longer mapped. It can also
+  raise an interrupt, so stop as soon as the dispatcher would have taken one.
+  Each iteration is charged as it completes, so handlers that look at the
+  cycle count see the same time they would have one iteration at a time.*/
+static __inline int rep_bulk_int_pending(void)
+{
+        return smi_line || (nmi && nmi_enable && nmi_mask) ||
+               ((cpu_state.flags & I_FLAG) && pic.int_pending && !cpu_end_block_after_ins);
+}
+
+static __inline uint32_t rep_bulk_ins(uint32_t dest, uint32_t addr_mask, uint32_t count, int size, int per)
+{
+        uint32_t lin = cpu_state.seg_es.base + dest;
+        uintptr_t lookup;
+        uint8_t *hd;
+        uint32_t n, c, val;
+
+        if (!count)
+                return 0;
+
+        n = rep_bulk_side(&cpu_state.seg_es, dest, addr_mask, 1, count, size, &hd);
+        lookup = writelookup2[lin >> 12];
+        for (c = 0; c < n; )
+        {
+                if (writelookup2[lin >> 12] != lookup)
+                        break;
+                if (size == 1)
+                        val = inb(DX);
+                else if (size == 2)
+                        val = inw(DX);
+                else
+                        val = inl(DX);
+                memcpy(hd + (c * size), &val, size);
+                c++;
+                cycles -= per;
+                if (rep_bulk_int_pending())
+                        break;
+        }
+        return c;
+}
+
+static __inline uint32_t rep_bulk_outs(uint32_t src, uint32_t addr_mask, uint32_t count, int size, int per)
+{
+        uint32_t lin = cpu_state.ea_seg->base + src;
+        uintptr_t lookup;
+        uint8_t *hs;
+        uint32_t n, c, val = 0;
+
+        if (!count || (msw&1 && ((CPL > IOPL) || (cpu_state.eflags&VM_FLAG))))
+                return 0;
+
+        n = rep_bulk_side(cpu_state.ea_seg, src, addr_mask, 0, count, size, &hs);
+        lookup = readlookup2[lin >> 12];
+        for (c = 0; c < n; )
+        {
+                if (readlookup2[lin >> 12] != lookup)
+                        break;
+                memcpy(&val, hs + (c * size), size);
+                if (size == 1)
+                        outb(DX, val);
+                else if (size == 2)
+                        outw(DX, val);
+                else
+                        outl(DX, val);
+                c++;
+                cycles -= per;
+                if (rep_bulk_int_pending())
+                        break;
+        }
+        return c;
+}
+
 #define REP_OPS(size, CNT_REG, SRC_REG, DEST_REG) \
 static int opREP_INSB_ ## size(uint32_t fetchdat)                               \
 {                                                                               \
         int reads = 0, writes = 0, total_cycles = 0;                            \
+        int cycles_end = cycles - ((is386 && cpu_use_dynarec) ? 1000 : 100);    \
+        uint32_t bulk;                                                          \
         uint64_t addr64 = 0x0000000000000000ULL;                                \
                                                                                 \
         if (CNT_REG > 0)                                                        \
@@ -11,16 +185,26 @@ static int opREP_INSB_ ## size(uint32_t fetchdat)
 		SEG_CHECK_WRITE(&cpu_state.seg_es);                             \
                 check_io_perm(DX);                                              \
                 CHECK_WRITE(&cpu_state.seg_es, DEST_REG, DEST_REG);             \
-                do_mmut_wb(es, DEST_REG, &addr64);                              \
-                if (cpu_state.abrt) return 1;                                   \
-                temp = inb(DX);                                                 \
-                writememb_n(es, DEST_REG, addr64, temp); if (cpu_state.abrt) return 1;    \
+                bulk = rep_bulk_ins(DEST_REG, REP_ADDR_MASK(DEST_REG), rep_bulk_budget(CNT_REG, 15, cycles_end), 1, 15); \
+                if (bulk)                                                       \
+                {                                                               \
+                        DEST_REG += bulk;                                       \
+                        CNT_REG -= bulk;                                        \
+                        reads += bulk; writes += bulk; total_cycles += bulk * 15; \
+                }                                                               \
+                else                                                            \
+                {                                                               \
+                        do_mmut_wb(es, DEST_REG, &addr64);                      \
+                        if (cpu_state.abrt) return 1;                           \
+                        temp = inb(DX);                                         \
+                        writememb_n(es, DEST_REG, addr64, temp); if (cpu_state.abrt) return 1; \
                                                                                 \
-                if (cpu_state.flags & D_FLAG) DEST_REG--;                       \
-                else                DEST_REG++;                                 \
-                CNT_REG--;                                                      \
-                cycles -= 15;                                                   \
-                reads++; writes++; total_cycles += 15;                          \
+                        if (cpu_state.flags & D_FLAG) DEST_REG--;               \
+                        else                DEST_REG++;                         \
+                        CNT_REG--;                                              \
+                        cycles -= 15;                                           \
+                        reads++; writes++; total_cycles += 15;                  \
+                }                                                               \
         }                                                                       \
         PREFETCH_RUN(total_cycles, 1, -1, reads, 0, writes, 0, 0);              \
         if (CNT_REG > 0)                                                        \
@@ -34,6 +218,8 @@ static int opREP_INSB_ ## size(uint32_t fetchdat)
 static int opREP_INSW_ ## size(uint32_t fetchdat)                               \
 {                                                                               \
         int reads = 0, writes = 0, total_cycles = 0;                            \
+        int cycles_end = cycles - ((is386 && cpu_use_dynarec) ? 1000 : 100);    \
+        uint32_t bulk;                                                          \
         uint64_t addr64[2];                                                     \
                                                                                 \
         if (CNT_REG > 0)                                                        \
@@ -44,16 +230,26 @@ static int opREP_INSW_ ## size(uint32_t fetchdat)
                 check_io_perm(DX);                                              \
                 check_io_perm(DX+1);                                            \
                 CHECK_WRITE(&cpu_state.seg_es, DEST_REG, DEST_REG + 1);         \
-                do_mmut_ww(es, DEST_REG, addr64);                               \
-                if (cpu_state.abrt) return 1;                                   \
-                temp = inw(DX);                                                 \
-                writememw_n(es, DEST_REG, addr64, temp); if (cpu_state.abrt) return 1;    \
+                bulk = rep_bulk_ins(DEST_REG, REP_ADDR_MASK(DEST_REG), rep_bulk_budget(CNT_REG, 15, cycles_end), 2, 15); \
+                if (bulk)                                                       \
+                {                                                               \
+                        DEST_REG += bulk * 2;                                   \
+                        CNT_REG -= bulk;                                        \
+                        reads += bulk; writes += bulk; total_cycles += bulk * 15; \
+                }                                                               \
+                else                                                            \
+                {                                                               \
+                        do_mmut_ww(es, DEST_REG, addr64);                       \
+                        if (cpu_state.abrt) return 1;                           \
+                        temp = inw(DX);                                         \
+                        writememw_n(es, DEST_REG, addr64, temp); if (cpu_state.abrt) return 1; \
                                                                                 \
-                if (cpu_state.flags & D_FLAG) DEST_REG -= 2;                    \
-                else                DEST_REG += 2;                              \
-                CNT_REG--;                                                      \
-                cycles -= 15;                                                   \
-                reads++; writes++; total_cycles += 15;                          \
+                        if (cpu_state.flags & D_FLAG) DEST_REG -= 2;            \
+                        else                DEST_REG += 2;                      \
+                        CNT_REG--;                                              \
+                        cycles -= 15;                                           \
+                        reads++; writes++; total_cycles += 15;                  \
+                }                                                               \
         }                                                                       \
         PREFETCH_RUN(total_cycles, 1, -1, reads, 0, writes, 0, 0);              \
         if (CNT_REG > 0)                                                        \
@@ -67,6 +263,8 @@ static int opREP_INSW_ ## size(uint32_t fetchdat)
 static int opREP_INSL_ ## size(uint32_t fetchdat)                               \
 {                                                                               \
         int reads = 0, writes = 0, total_cycles = 0;                            \
+        int cycles_end = cycles - ((is386 && cpu_use_dynarec) ? 1000 : 100);    \
+        uint32_t bulk;                                                          \
         uint64_t addr64[4];                                                     \
                                                                                 \
         if (CNT_REG > 0)                                                        \
@@ -79,16 +277,26 @@ static int opREP_INSL_ ## size(uint32_t fetchdat)
                 check_io_perm(DX+2);                                            \
                 check_io_perm(DX+3);                                            \
                 CHECK_WRITE(&cpu_state.seg_es, DEST_REG, DEST_REG + 3);         \
-                do_mmut_wl(es, DEST_REG, addr64);                               \
-                if (cpu_state.abrt) return 1;                                   \
-                temp = inl(DX);                                                 \
-                writememl_n(es, DEST_REG, addr64, temp); if (cpu_state.abrt) return 1;    \
+                bulk = rep_bulk_ins(DEST_REG, REP_ADDR_MASK(DEST_REG), rep_bulk_budget(CNT_REG, 15, cycles_end), 4, 15); \
+                if (bulk)                                                       \
+                {                                                               \
+                        DEST_REG += bulk * 4;                                   \
+                        CNT_REG -= bulk;                                        \
+                        reads += bulk; writes += bulk; total_cycles += bulk * 15; \
+                }                                                               \
+                else                                                            \
+                {                                                               \
+                        do_mmut_wl(es, DEST_REG, addr64);                       \
+                        if (cpu_state.abrt) return 1;                           \
+                        temp = inl(DX);                                         \
+                        writememl_n(es, DEST_REG, addr64, temp); if (cpu_state.abrt) return 1; \
                                                                                 \
-                if (cpu_state.flags & D_FLAG) DEST_REG -= 4;                    \
-                else                DEST_REG += 4;                              \
-                CNT_REG--;                                                      \
-                cycles -= 15;                                                   \
-                reads++; writes++; total_cycles += 15;                          \
+                        if (cpu_state.flags & D_FLAG) DEST_REG -= 4;            \
+                        else                DEST_REG += 4;                      \
+                        CNT_REG--;                                              \
+                        cycles -= 15;                                           \
+                        reads++; writes++; total_cycles += 15;                  \
+                }                                                               \
         }                                                                       \
         PREFETCH_RUN(total_cycles, 1, -1, 0, reads, 0, writes, 0);              \
         if (CNT_REG > 0)                                                        \
@@ -103,20 +311,32 @@ static int opREP_INSL_ ## size(uint32_t fetchdat)
 static int opREP_OUTSB_ ## size(uint32_t fetchdat)                              \
 {                                                                               \
         int reads = 0, writes = 0, total_cycles = 0;                            \
+        int cycles_end = cycles - ((is386 && cpu_use_dynarec) ? 1000 : 100);    \
+        uint32_t bulk;                                                          \
                                                                                 \
         if (CNT_REG > 0)                                                        \
         {                                                                       \
                 uint8_t temp;                                                   \
                 SEG_CHECK_READ(cpu_state.ea_seg);                               \
                 CHECK_READ(cpu_state.ea_seg, SRC_REG, SRC_REG);                 \
-                temp = readmemb(cpu_state.ea_seg->base, SRC_REG); if (cpu_state.abrt) return 1;    \
-                check_io_perm(DX);                                               \
-                outb(DX, temp);                                                 \
-                if (cpu_state.flags & D_FLAG) SRC_REG--;                                  \
-                else                SRC_REG++;                                  \
-                CNT_REG--;                                                      \
-                cycles -= 14;                                                   \
-                reads++; writes++; total_cycles += 14;                          \
+                bulk = rep_bulk_outs(SRC_REG, REP_ADDR_MASK(SRC_REG), rep_bulk_budget(CNT_REG, 14, cycles_end), 1, 14); \
+                if (bulk)                                                       \
+                {                                                               \
+                        SRC_REG += bulk;                                        \
+                        CNT_REG -= bulk;                                        \
+                        reads += bulk; writes += bulk; total_cycles += bulk * 14; \
+                }                                                               \
+                else                                                            \
+                {                                                               \
+                        temp = readmemb(cpu_state.ea_seg->base, SRC_REG); if (cpu_state.abrt) return 1; \
+                        check_io_perm(DX);                                      \
+                        outb(DX, temp);                                         \
+                        if (cpu_state.flags & D_FLAG) SRC_REG--;                \
+                        else                SRC_REG++;                          \
+                        CNT_REG--;                                              \
+                        cycles -= 14;                                           \
+                        reads++; writes++; total_cycles += 14;                  \
+                }                                                               \
         }                                                                       \
         PREFETCH_RUN(total_cycles, 1, -1, reads, 0, writes, 0, 0);              \
         if (CNT_REG > 0)                                                        \
@@ -130,21 +350,33 @@ static int opREP_OUTSB_ ## size(uint32_t fetchdat)
 static int opREP_OUTSW_ ## size(uint32_t fetchdat)                              \
 {                                                                               \
         int reads = 0, writes = 0, total_cycles = 0;                            \
+        int cycles_end = cycles - ((is386 && cpu_use_dynarec) ? 1000 : 100);    \
+        uint32_t bulk;                                                          \
                                                                                 \
         if (CNT_REG > 0)                                                        \
         {                                                                       \
                 uint16_t temp;                                                  \
                 SEG_CHECK_READ(cpu_state.ea_seg);                               \
                 CHECK_READ(cpu_state.ea_seg, SRC_REG, SRC_REG + 1);             \
-                temp = readmemw(cpu_state.ea_seg->base, SRC_REG); if (cpu_state.abrt) return 1;   \
-                check_io_perm(DX);                                               \
-                check_io_perm(DX+1);                                             \
-                outw(DX, temp);                                                 \
-                if (cpu_state.flags & D_FLAG) SRC_REG -= 2;                               \
-                else                SRC_REG += 2;                               \
-                CNT_REG--;                                                      \
-                cycles -= 14;                                                   \
-                reads++; writes++; total_cycles += 14;                          \
+                bulk = rep_bulk_outs(SRC_REG, REP_ADDR_MASK(SRC_REG), rep_bulk_budget(CNT_REG, 14, cycles_end), 2, 14); \
+                if (bulk)                                                       \
+                {                                                               \
+                        SRC_REG += bulk * 2;                                    \
+                        CNT_REG -= bulk;                                        \
+                        reads += bulk; writes += bulk; total_cycles += bulk * 14; \
+                }                                                               \
+                else                                                            \
+                {                                                               \
+                        temp = readmemw(cpu_state.ea_seg->base, SRC_REG); if (cpu_state.abrt) return 1; \
+                        check_io_perm(DX);                                      \
+                        check_io_perm(DX+1);                                    \
+                        outw(DX, temp);                                         \
+                        if (cpu_state.flags & D_FLAG) SRC_REG -= 2;             \
+                        else                SRC_REG += 2;                       \
+                        CNT_REG--;                                              \
+                        cycles -= 14;                                           \
+                        reads++; writes++; total_cycles += 14;                  \
+                }                                                               \
         }                                                                       \
         PREFETCH_RUN(total_cycles, 1, -1, reads, 0, writes, 0, 0);              \
         if (CNT_REG > 0)                                                        \
@@ -158,23 +390,35 @@ static int opREP_OUTSW_ ## size(uint32_t fetchdat)
 static int opREP_OUTSL_ ## size(uint32_t fetchdat)                              \
 {                                                                               \
         int reads = 0, writes = 0, total_cycles = 0;                            \
+        int cycles_end = cycles - ((is386 && cpu_use_dynarec) ? 1000 : 100);    \
+        uint32_t bulk;                                                          \
                                                                                 \
         if (CNT_REG > 0)                                                        \
         {                                                                       \
                 uint32_t temp;                                                  \
                 SEG_CHECK_READ(cpu_state.ea_seg);                               \
                 CHECK_READ(cpu_state.ea_seg, SRC_REG, SRC_REG + 3);             \
-                temp = readmeml(cpu_state.ea_seg->base, SRC_REG); if (cpu_state.abrt) return 1;   \
-                check_io_perm(DX);                                               \
-                check_io_perm(DX+1);                                             \
-                check_io_perm(DX+2);                                             \
-                check_io_perm(DX+3);                                             \
-                outl(DX, temp);                                                 \
-                if (cpu_state.flags & D_FLAG) SRC_REG -= 4;                               \
-                else                SRC_REG += 4;                               \
-                CNT_REG--;                                                      \
-                cycles -= 14;                                                   \
-                reads++; writes++; total_cycles += 14;                          \
+                bulk = rep_bulk_outs(SRC_REG, REP_ADDR_MASK(SRC_REG), rep_bulk_budget(CNT_REG, 14, cycles_end), 4, 14); \
+                if (bulk)                                                       \
+                {                                                               \
+                        SRC_REG += bulk * 4;                                    \
+                        CNT_REG -= bulk;                                        \
+                        reads += bulk; writes += bulk; total_cycles += bulk * 14; \
+                }                                                               \
+                else                                                            \
+                {                                                               \
+                        temp = readmeml(cpu_state.ea_seg->base, SRC_REG); if (cpu_state.abrt) return 1; \
+                        check_io_perm(DX);                                      \
+                        check_io_perm(DX+1);                                    \
+                        check_io_perm(DX+2);                                    \
+                        check_io_perm(DX+3);                                    \
+                        outl(DX, temp);                                         \
+                        if (cpu_state.flags & D_FLAG) SRC_REG -= 4;             \
+                        else                SRC_REG += 4;                       \
+                        CNT_REG--;                                              \
+                        cycles -= 14;                                           \
+                        reads++; writes++; total_cycles += 14;                  \
+                }                                                               \
         }                                                                       \
         PREFETCH_RUN(total_cycles, 1, -1, 0, reads, 0, writes, 0);              \
         if (CNT_REG > 0)                                                        \
@@ -189,6 +433,7 @@ static int opREP_OUTSL_ ## size(uint32_t fetchdat)
 static int opREP_MOVSB_ ## size(uint32_t fetchdat)                              \
 {                                                                               \
         int reads = 0, writes = 0, total_cycles = 0;                            \
+        uint32_t bulk;                                                          \
         int cycles_end = cycles - ((is386 && cpu_use_dynarec) ? 1000 : 100);    \
         uint64_t addr64r = 0x0000000000000000ULL;                               \
         uint64_t addr64w = 0x0000000000000000ULL;                               \
@@ -203,6 +448,18 @@ static int opREP_MOVSB_ ## size(uint32_t fetchdat)
         {                                                                       \
                 uint8_t temp;                                                   \
                                                                                 \
+                bulk = rep_bulk_movs(SRC_REG, DEST_REG, REP_ADDR_MASK(SRC_REG), rep_bulk_budget(CNT_REG, is486 ? 3 : 4, cycles_end), 1); \
+                if (bulk)                                                       \
+                {                                                               \
+                        DEST_REG += bulk; SRC_REG += bulk;                      \
+                        CNT_REG -= bulk;                                        \
+                        cycles -= bulk * (is486 ? 3 : 4);                       \
+                        reads += bulk; writes += bulk; total_cycles += bulk * (is486 ? 3 : 4); \
+                        if (cycles < cycles_end)                                \
+                                break;                                          \
+                        continue;                                               \
+                }                                                               \
+                                                                                \
                 CHECK_READ_REP(cpu_state.ea_seg, SRC_REG, SRC_REG);             \
                 do_mmut_rb(cpu_state.ea_seg->base, SRC_REG, &addr64r);          \
                 if (cpu_state.abrt) break;                                      \
@@ -232,6 +489,7 @@ static int opREP_MOVSB_ ## size(uint32_t fetchdat)
 static int opREP_MOVSW_ ## size(uint32_t fetchdat)                              \
 {                                                                               \
         int reads = 0, writes = 0, total_cycles = 0;                            \
+        uint32_t bulk;                                                          \
         int cycles_end = cycles - ((is386 && cpu_use_dynarec) ? 1000 : 100);    \
         uint64_t addr64r[2];                                                    \
         uint64_t addr64w[2];                                                    \
@@ -246,6 +504,18 @@ static int opREP_MOVSW_ ## size(uint32_t fetchdat)
         {                                                                       \
                 uint16_t temp;                                                  \
                                                                                 \
+                bulk = rep_bulk_movs(SRC_REG, DEST_REG, REP_ADDR_MASK(SRC_REG), rep_bulk_budget(CNT_REG, is486 ? 3 : 4, cycles_end), 2); \
+                if (bulk)                                                       \
+                {                                                               \
+                        DEST_REG += bulk * 2; SRC_REG += bulk * 2;              \
+                        CNT_REG -= bulk;                                        \
+                        cycles -= bulk * (is486 ? 3 : 4);                       \
+                        reads += bulk; writes += bulk; total_cycles += bulk * (is486 ? 3 : 4); \
+                        if (cycles < cycles_end)                                \
+                                break;                                          \
+                        continue;                                               \
+                }                                                               \
+                                                                                \
                 CHECK_READ_REP(cpu_state.ea_seg, SRC_REG, SRC_REG + 1);         \
                 do_mmut_rw(cpu_state.ea_seg->base, SRC_REG, addr64r);           \
                 if (cpu_state.abrt) break;                                      \
@@ -275,6 +545,7 @@ static int opREP_MOVSW_ ## size(uint32_t fetchdat)
 static int opREP_MOVSL_ ## size(uint32_t fetchdat)                              \
 {                                                                               \
         int reads = 0, writes = 0, total_cycles = 0;                            \
+        uint32_t bulk;                                                          \
         int cycles_end = cycles - ((is386 && cpu_use_dynarec) ? 1000 : 100);    \
         uint64_t addr64r[4];                                                    \
         uint64_t addr64w[4];                                                    \
@@ -289,6 +560,18 @@ static int opREP_MOVSL_ ## size(uint32_t fetchdat)
         {                                                                       \
                 uint32_t temp;                                                  \
                                                                                 \
+                bulk = rep_bulk_movs(SRC_REG, DEST_REG, REP_ADDR_MASK(SRC_REG), rep_bulk_budget(CNT_REG, is486 ? 3 : 4, cycles_end), 4); \
+                if (bulk)                                                       \
+                {                                                               \
+                        DEST_REG += bulk * 4; SRC_REG += bulk * 4;              \
+                        CNT_REG -= bulk;                                        \
+                        cycles -= bulk * (is486 ? 3 : 4);                       \
+                        reads += bulk; writes += bulk; total_cycles += bulk * (is486 ? 3 : 4); \
+                        if (cycles < cycles_end)                                \
+                                break;                                          \
+                        continue;                                               \
+                }                                                               \
+                                                                                \
                 CHECK_READ_REP(cpu_state.ea_seg, SRC_REG, SRC_REG + 3);         \
                 do_mmut_rl(cpu_state.ea_seg->base, SRC_REG, addr64r);           \
                 if (cpu_state.abrt) break;                                      \
@@ -320,6 +603,7 @@ static int opREP_MOVSL_ ## size(uint32_t fetchdat)
 static int opREP_STOSB_ ## size(uint32_t fetchdat)                              \
 {                                                                               \
         int writes = 0, total_cycles = 0;                                       \
+        uint32_t bulk;                                                          \
         int cycles_end = cycles - ((is386 && cpu_use_dynarec) ? 1000 : 100);    \
         if (trap)                                                               \
                 cycles_end = cycles+1; /*Force the instruction to end after only one iteration when trap flag set*/     \
@@ -327,6 +611,18 @@ static int opREP_STOSB_ ## size(uint32_t fetchdat)
                 SEG_CHECK_WRITE(&cpu_state.seg_es);                             \
         while (CNT_REG > 0)                                                     \
         {                                                                       \
+                bulk = rep_bulk_stos(DEST_REG, REP_ADDR_MASK(DEST_REG), rep_bulk_budget(CNT_REG, is486 ? 4 : 5, cycles_end), 1, AL); \
+                if (bulk)                                                       \
+                {                                                               \
+                        DEST_REG += bulk;                                       \
+                        CNT_REG -= bulk;                                        \
+                        cycles -= bulk * (is486 ? 4 : 5);                       \
+                        writes += bulk; total_cycles += bulk * (is486 ? 4 : 5); \
+                        if (cycles < cycles_end)                                \
+                                break;                                          \
+                        continue;                                               \
+                }                                                               \
+                                                                                \
                 CHECK_WRITE_REP(&cpu_state.seg_es, DEST_REG, DEST_REG);         \
                 writememb(es, DEST_REG, AL); if (cpu_state.abrt) return 1;      \
                 if (cpu_state.flags & D_FLAG) DEST_REG--;                       \
@@ -349,6 +645,7 @@ static int opREP_STOSB_ ## size(uint32_t fetchdat)
 static int opREP_STOSW_ ## size(uint32_t fetchdat)                              \
 {                                                                               \
         int writes = 0, total_cycles = 0;                                       \
+        uint32_t bulk;                                                          \
         int cycles_end = cycles - ((is386 && cpu_use_dynarec) ? 1000 : 100);    \
         if (trap)                                                               \
                 cycles_end = cycles+1; /*Force the instruction to end after only one iteration when trap flag set*/     \
@@ -356,6 +653,18 @@ static int opREP_STOSW_ ## size(uint32_t fetchdat)
                 SEG_CHECK_WRITE(&cpu_state.seg_es);                             \
         while (CNT_REG > 0)                                                     \
         {                                                                       \
+                bulk = rep_bulk_stos(DEST_REG, REP_ADDR_MASK(DEST_REG), rep_bulk_budget(CNT_REG, is486 ? 4 : 5, cycles_end), 2, AX); \
+                if (bulk)                                                       \
+                {                                                               \
+                        DEST_REG += bulk * 2;                                   \
+                        CNT_REG -= bulk;                                        \
+                        cycles -= bulk * (is486 ? 4 : 5);                       \
+                        writes += bulk; total_cycles += bulk * (is486 ? 4 : 5); \
+                        if (cycles < cycles_end)                                \
+                                break;                                          \
+                        continue;                                               \
+                }                                                               \
+                                                                                \
                 CHECK_WRITE_REP(&cpu_state.seg_es, DEST_REG, DEST_REG + 1);     \
                 writememw(es, DEST_REG, AX); if (cpu_state.abrt) return 1;      \
                 if (cpu_state.flags & D_FLAG) DEST_REG -= 2;                    \
@@ -378,6 +687,7 @@ static int opREP_STOSW_ ## size(uint32_t fetchdat)
 static int opREP_STOSL_ ## size(uint32_t fetchdat)                              \
 {                                                                               \
         int writes = 0, total_cycles = 0;                                       \
+        uint32_t bulk;                                                          \
         int cycles_end = cycles - ((is386 && cpu_use_dynarec) ? 1000 : 100);    \
         if (trap)                                                               \
                 cycles_end = cycles+1; /*Force the instruction to end after only one iteration when trap flag set*/     \
@@ -385,6 +695,18 @@ static int opREP_STOSL_ ## size(uint32_t fetchdat)
                 SEG_CHECK_WRITE(&cpu_state.seg_es);                             \
         while (CNT_REG > 0)                                                     \
         {                                                                       \
+                bulk = rep_bulk_stos(DEST_REG, REP_ADDR_MASK(DEST_REG), rep_bulk_budget(CNT_REG, is486 ? 4 : 5, cycles_end), 4, EAX); \
+                if (bulk)                                                       \
+                {                                                               \
+                        DEST_REG += bulk * 4;                                   \
+                        CNT_REG -= bulk;                                        \
+                        cycles -= bulk * (is486 ? 4 : 5);                       \
+                        writes += bulk; total_cycles += bulk * (is486 ? 4 : 5); \
+                        if (cycles < cycles_end)                                \
+                                break;                                          \
+                        continue;                                               \
+                }                                                               \
+                                                                                \
                 CHECK_WRITE_REP(&cpu_state.seg_es, DEST_REG, DEST_REG + 3);     \
                 writememl(es, DEST_REG, EAX); if (cpu_state.abrt) return 1;     \
                 if (cpu_state.flags & D_FLAG) DEST_REG -= 4;                    \
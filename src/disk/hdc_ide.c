@@ -1596,6 +1596,11 @@ ide_writeb(uint16_t addr, uint8_t val, void *priv)
 					ide->atastat = BSY_STAT;
 
 				if (ide->type == IDE_HDD) {
+					/* Have the host start reading while the command's seek and
+					   transfer time elapse. */
+					if (ide->lba || ide->cfg_spt)
+						hdd_image_read_ahead(ide->hdd_num, ide_get_sector(ide), ide->secount ? ide->secount : 256);
+
 					if ((val == WIN_READ_DMA) || (val == WIN_READ_DMA_ALT)) {
 						if (ide->secount)
 							ide_set_callback(ide, ide_get_period(ide, (int) ide->secount << 9));
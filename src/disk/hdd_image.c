@@ -27,6 +27,14 @@
 #include <time.h>
 #include <wchar.h>
 #include <errno.h>
+#ifdef _WIN32
+# include <io.h>
+# include <windows.h>
+# include <winioctl.h>
+#else
+# include <sys/mman.h>
+# include <unistd.h>
+#endif
 #define HAVE_STDARG_H
 #include <86box/86box.h>
 #include <86box/plat.h>
@@ -40,6 +48,28 @@
 #define HDD_IMAGE_HDX 2
 #define HDD_IMAGE_VHD 3
 
+/* Largest transfer done through the I/O thread, the most a single ATA command can ask for. */
+#define HDD_IO_MAX_SECTORS 256
+
+#ifdef _MSC_VER
+#define hdd_image_io_barrier()	_ReadWriteBarrier()
+#else
+#define hdd_image_io_barrier()	__sync_synchronize()
+#endif
+
+/* Copy-on-write overlay file: header, then a bitmap of the sectors present in the
+   overlay, then the sectors themselves at the same offsets as in the image. The
+   data area is left sparse. */
+#define HDD_OVERLAY_MAGIC	"86BOXCOW"
+#define HDD_OVERLAY_BITMAP	4096
+
+typedef struct
+{
+	char magic[8];
+	uint32_t sectors;
+	uint32_t data_offset;
+} hdd_overlay_header_t;
+
 typedef struct
 {
 	FILE *file; /* Used for HDD_IMAGE_RAW, HDD_IMAGE_HDI, and HDD_IMAGE_HDX. */ 
@@ -48,12 +78,32 @@ typedef struct
 	uint32_t pos, last_sector;
 	uint8_t type; /* HDD_IMAGE_RAW, HDD_IMAGE_HDI, HDD_IMAGE_HDX, or HDD_IMAGE_VHD */
 	uint8_t loaded;
+
+	/* I/O thread, used for read-ahead on the file based image types. At most one
+	   read is in flight per image; every other access to the image waits for it
+	   first. The emulation thread owns io_valid, io_sector and io_count, the I/O
+	   thread owns io_result until it clears io_busy. */
+	thread_t *io_thread;
+	event_t *io_start, *io_done;
+	volatile int io_busy, io_quit;
+	int io_valid;
+	uint32_t io_sector, io_count, io_result, io_next_sector;
+	uint8_t *io_buffer; /* HDD_IO_MAX_SECTORS sectors */
+
+	/* Memory mapped access, replaces the file I/O above when used. */
+	uint8_t *map; /* Sector data, base already applied */
+	uint64_t map_size;
+	uint32_t map_base;
+	FILE *ovl_file;
+	uint8_t *ovl_map, *ovl_bitmap, *ovl_data;
+	uint64_t ovl_size;
 } hdd_image_t;
 
 
 hdd_image_t hdd_images[HDD_NUM];
 
 static char empty_sector[512];
+static uint8_t empty_sectors[64 << 9];
 static char *empty_sector_1mb;
 
 #ifdef ENABLE_HDD_IMAGE_LOG
@@ -75,6 +125,414 @@ hdd_image_log(const char *fmt, ...)
 #define hdd_image_log(fmt, ...)
 #endif
 
+
+/* Positioned transfer of count sectors, returns the number of sectors actually transferred. */
+static uint32_t
+hdd_image_pio(hdd_image_t *img, int write, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+	uint64_t addr = ((uint64_t) sector << 9LL) + img->base;
+	uint64_t len = (uint64_t) count << 9;
+	uint64_t done = 0;
+#ifdef _WIN32
+	HANDLE h = (HANDLE) _get_osfhandle(_fileno(img->file));
+	OVERLAPPED ov;
+	DWORD ret;
+	BOOL ok;
+#else
+	int fd = fileno(img->file);
+	ssize_t ret;
+#endif
+
+	while (done < len) {
+#ifdef _WIN32
+		memset(&ov, 0, sizeof(OVERLAPPED));
+		ov.Offset = (DWORD) (addr + done);
+		ov.OffsetHigh = (DWORD) ((addr + done) >> 32);
+		if (write)
+			ok = WriteFile(h, buffer + done, (DWORD) (len - done), &ret, &ov);
+		else
+			ok = ReadFile(h, buffer + done, (DWORD) (len - done), &ret, &ov);
+		if (!ok || (ret == 0))
+			break;
+#else
+		if (write)
+			ret = pwrite(fd, buffer + done, len - done, addr + done);
+		else
+			ret = pread(fd, buffer + done, len - done, addr + done);
+		if ((ret == -1) && (errno == EINTR))
+			continue;
+		if (ret <= 0)
+			break;
+#endif
+		done += ret;
+	}
+
+	return (uint32_t) (done >> 9);
+}
+
+
+static void
+hdd_image_io_thread(void *param)
+{
+	hdd_image_t *img = (hdd_image_t *) param;
+
+	while (1) {
+		thread_wait_event(img->io_start, -1);
+
+		if (img->io_quit)
+			break;
+		if (!img->io_busy)
+			continue;
+
+		/* Short reads are the end of the image, not an error. */
+		img->io_result = hdd_image_pio(img, 0, img->io_sector, img->io_count, img->io_buffer);
+
+		hdd_image_io_barrier();
+		img->io_busy = 0;
+		thread_set_event(img->io_done);
+	}
+}
+
+
+/* Wait for the request in flight on an image, if any. */
+static void
+hdd_image_io_wait(uint8_t id)
+{
+	hdd_image_t *img = &hdd_images[id];
+
+	while (img->io_busy)
+		thread_wait_event(img->io_done, -1);
+
+	hdd_image_io_barrier();
+}
+
+
+static void
+hdd_image_io_submit(uint8_t id, uint32_t sector, uint32_t count)
+{
+	hdd_image_t *img = &hdd_images[id];
+
+	img->io_sector = sector;
+	img->io_count = count;
+	img->io_valid = 1;
+	img->io_busy = 1;
+	hdd_image_io_barrier();
+	thread_set_event(img->io_start);
+}
+
+
+static void
+hdd_image_io_init(uint8_t id)
+{
+	hdd_image_t *img = &hdd_images[id];
+
+	if ((img->type == HDD_IMAGE_VHD) || (img->file == NULL) || (img->map != NULL))
+		return;
+
+	/* All data transfers bypass stdio from here on. */
+	fflush(img->file);
+
+	img->io_buffer = (uint8_t *) malloc(HDD_IO_MAX_SECTORS << 9);
+	img->io_start = thread_create_event();
+	img->io_done = thread_create_event();
+	img->io_busy = img->io_quit = 0;
+	img->io_valid = 0;
+	img->io_next_sector = 0xffffffff;
+	img->io_thread = thread_create(hdd_image_io_thread, img);
+}
+
+
+static void
+hdd_image_io_close(uint8_t id)
+{
+	hdd_image_t *img = &hdd_images[id];
+
+	if (img->io_thread == NULL)
+		return;
+
+	hdd_image_io_wait(id);
+
+	img->io_quit = 1;
+	thread_set_event(img->io_start);
+	thread_wait(img->io_thread, -1);
+	img->io_thread = NULL;
+
+	thread_destroy_event(img->io_start);
+	thread_destroy_event(img->io_done);
+	img->io_start = img->io_done = NULL;
+
+	free(img->io_buffer);
+	img->io_buffer = NULL;
+	img->io_valid = 0;
+}
+
+
+static uint8_t *
+hdd_image_map_file(FILE *f, uint64_t size, int writable)
+{
+	uint8_t *p;
+#ifdef _WIN32
+	HANDLE h = (HANDLE) _get_osfhandle(_fileno(f)), m;
+
+	if ((size_t) size != size)
+		return NULL;
+
+	m = CreateFileMapping(h, NULL, writable ? PAGE_READWRITE : PAGE_READONLY,
+			      (DWORD) (size >> 32), (DWORD) size, NULL);
+	if (m == NULL)
+		return NULL;
+	p = (uint8_t *) MapViewOfFile(m, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, (size_t) size);
+	/* The view keeps the mapping object alive. */
+	CloseHandle(m);
+#else
+	if ((size_t) size != size)
+		return NULL;
+
+	p = (uint8_t *) mmap(NULL, (size_t) size, writable ? (PROT_READ | PROT_WRITE) : PROT_READ,
+			     MAP_SHARED, fileno(f), 0);
+	if (p == (uint8_t *) MAP_FAILED)
+		p = NULL;
+#endif
+
+	return p;
+}
+
+
+static void
+hdd_image_unmap_file(uint8_t *p, uint64_t size)
+{
+#ifdef _WIN32
+	UnmapViewOfFile(p);
+#else
+	munmap(p, (size_t) size);
+#endif
+}
+
+
+/* Extend a file without writing anything, the new part reads back as zeroes and
+   takes no room until something is written to it. */
+static int
+hdd_image_set_file_size(FILE *f, uint64_t size)
+{
+#ifdef _WIN32
+	HANDLE h = (HANDLE) _get_osfhandle(_fileno(f));
+	LARGE_INTEGER pos;
+	DWORD ret;
+
+	fflush(f);
+
+	/* NTFS would otherwise allocate and zero the whole extension; if the file
+	   system can't do sparse files, it still works, just not sparsely. */
+	DeviceIoControl(h, FSCTL_SET_SPARSE, NULL, 0, NULL, 0, &ret, NULL);
+
+	pos.QuadPart = size;
+	if (!SetFilePointerEx(h, pos, NULL, FILE_BEGIN))
+		return 0;
+	return !!SetEndOfFile(h);
+#else
+	fflush(f);
+	return !ftruncate(fileno(f), size);
+#endif
+}
+
+
+static int
+hdd_image_overlay_open(uint8_t id)
+{
+	hdd_image_t *img = &hdd_images[id];
+	hdd_overlay_header_t hdr;
+	uint32_t sectors = img->last_sector + 1;
+	uint32_t data_offset = HDD_OVERLAY_BITMAP + ((((sectors + 7) >> 3) + 4095) & ~4095);
+
+	img->ovl_size = (uint64_t) data_offset + ((uint64_t) sectors << 9);
+
+	img->ovl_file = plat_fopen(hdd[id].overlay_fn, L"rb+");
+	if (img->ovl_file == NULL) {
+		if (errno != ENOENT)
+			return 0;
+
+		/* New overlay, everything still comes from the image. */
+		img->ovl_file = plat_fopen(hdd[id].overlay_fn, L"wb+");
+		if (img->ovl_file == NULL)
+			return 0;
+
+		memset(&hdr, 0, sizeof(hdr));
+		memcpy(hdr.magic, HDD_OVERLAY_MAGIC, 8);
+		hdr.sectors = sectors;
+		hdr.data_offset = data_offset;
+		if (fwrite(&hdr, 1, sizeof(hdr), img->ovl_file) != sizeof(hdr))
+			return 0;
+	} else {
+		if (fread(&hdr, 1, sizeof(hdr), img->ovl_file) != sizeof(hdr))
+			return 0;
+		if (memcmp(hdr.magic, HDD_OVERLAY_MAGIC, 8) || (hdr.sectors != sectors) ||
+		    (hdr.data_offset != data_offset)) {
+			hdd_image_log("Hard disk image %i: Overlay does not match the image\n", id);
+			return 0;
+		}
+	}
+
+	if (!hdd_image_set_file_size(img->ovl_file, img->ovl_size))
+		return 0;
+
+	img->ovl_map = hdd_image_map_file(img->ovl_file, img->ovl_size, 1);
+	if (img->ovl_map == NULL)
+		return 0;
+
+	img->ovl_bitmap = img->ovl_map + HDD_OVERLAY_BITMAP;
+	img->ovl_data = img->ovl_map + data_offset;
+
+	return 1;
+}
+
+
+static void
+hdd_image_unmap(uint8_t id)
+{
+	hdd_image_t *img = &hdd_images[id];
+
+	if (img->ovl_map != NULL) {
+		hdd_image_unmap_file(img->ovl_map, img->ovl_size);
+		img->ovl_map = img->ovl_bitmap = img->ovl_data = NULL;
+	}
+	if (img->ovl_file != NULL) {
+		fclose(img->ovl_file);
+		img->ovl_file = NULL;
+	}
+	if (img->map != NULL) {
+		hdd_image_unmap_file(img->map - img->map_base, img->map_size);
+		img->map = NULL;
+	}
+}
+
+
+/* Map the image, and open its overlay if there is one. With an overlay, the image
+   itself is mapped read-only, so that any number of emulated machines can share it
+   (and its pages in the host's cache). */
+static void
+hdd_image_map(uint8_t id)
+{
+	hdd_image_t *img = &hdd_images[id];
+	int overlay = (hdd[id].overlay_fn[0] != 0);
+
+	if ((img->type == HDD_IMAGE_VHD) || (img->file == NULL))
+		return;
+	if (!hdd[id].mmap && !overlay)
+		return;
+
+	fflush(img->file);
+
+	img->map_base = img->base;
+	img->map_size = (uint64_t) img->base + ((uint64_t) (img->last_sector + 1) << 9);
+
+	/* A header can claim more sectors than the file holds; file I/O just reads
+	   short there, but touching a mapping past the end of the file faults. */
+	if ((fseeko64(img->file, 0, SEEK_END) == -1) || (ftello64(img->file) < (off64_t) img->map_size)) {
+		if (overlay)
+			fatal("Hard disk image %i: Image is shorter than its geometry, unable to use an overlay\n", id);
+		hdd_image_log("Hard disk image %i: Image is shorter than its geometry, using file I/O\n", id);
+		return;
+	}
+
+	img->map = hdd_image_map_file(img->file, img->map_size, !overlay);
+	if (img->map == NULL) {
+		if (overlay)
+			fatal("Hard disk image %i: Unable to map the image for its overlay\n", id);
+		hdd_image_log("Hard disk image %i: Unable to map, using file I/O\n", id);
+		return;
+	}
+	img->map += img->map_base;
+
+	if (overlay && !hdd_image_overlay_open(id))
+		fatal("Hard disk image %i: Unable to open overlay file\n", id);
+}
+
+
+/* Mapped transfers, count must already be within the image. */
+static void
+hdd_image_map_read(hdd_image_t *img, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+	uint32_t i, n;
+	int in_ovl;
+
+	if (img->ovl_map == NULL) {
+		memcpy(buffer, img->map + ((uint64_t) sector << 9), count << 9);
+		return;
+	}
+
+	/* Copy runs of sectors from whichever of the overlay or the image holds them. */
+	for (i = 0; i < count; i += n) {
+		in_ovl = img->ovl_bitmap[(sector + i) >> 3] & (1 << ((sector + i) & 7));
+		for (n = 1; (i + n) < count; n++) {
+			if (!(img->ovl_bitmap[(sector + i + n) >> 3] & (1 << ((sector + i + n) & 7))) != !in_ovl)
+				break;
+		}
+
+		memcpy(buffer + (i << 9), (in_ovl ? img->ovl_data : img->map) + ((uint64_t) (sector + i) << 9), n << 9);
+	}
+}
+
+
+static void
+hdd_image_map_write(hdd_image_t *img, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+	uint32_t i;
+
+	if (img->ovl_map == NULL) {
+		if (buffer != NULL)
+			memcpy(img->map + ((uint64_t) sector << 9), buffer, count << 9);
+		else
+			memset(img->map + ((uint64_t) sector << 9), 0, count << 9);
+		return;
+	}
+
+	if (buffer != NULL)
+		memcpy(img->ovl_data + ((uint64_t) sector << 9), buffer, count << 9);
+	else
+		memset(img->ovl_data + ((uint64_t) sector << 9), 0, count << 9);
+
+	for (i = sector; i < (sector + count); i++)
+		img->ovl_bitmap[i >> 3] |= (1 << (i & 7));
+}
+
+
+/* Clip a transfer to the end of the image. */
+static uint32_t
+hdd_image_map_clip(hdd_image_t *img, uint32_t sector, uint32_t count)
+{
+	if (sector > img->last_sector)
+		return 0;
+	if ((img->last_sector - sector + 1) < count)
+		count = img->last_sector - sector + 1;
+
+	return count;
+}
+
+
+/* Start reading sectors in the background, for a hdd_image_read() of the same range that is expected soon. */
+void
+hdd_image_read_ahead(uint8_t id, uint32_t sector, uint32_t count)
+{
+	hdd_image_t *img = &hdd_images[id];
+
+	if (img->io_thread == NULL)
+		return;
+
+	if (count > HDD_IO_MAX_SECTORS)
+		count = HDD_IO_MAX_SECTORS;
+	if ((sector > img->last_sector) || (count == 0))
+		return;
+	if ((img->last_sector - sector + 1) < count)
+		count = img->last_sector - sector + 1;
+
+	/* Already there or on its way. */
+	if (img->io_valid && (img->io_sector == sector) && (img->io_count >= count))
+		return;
+
+	hdd_image_io_wait(id);
+	hdd_image_io_submit(id, sector, count);
+}
+
 int
 image_is_hdi(const wchar_t *s)
 {
@@ -238,6 +696,10 @@ prepare_new_hard_disk(uint8_t id, uint64_t full_size)
 
 	free(empty_sector_1mb);
 
+	/* Everything after this goes straight to the file descriptor (or the
+	   mapping), so nothing may be left behind in the stdio buffer. */
+	fflush(hdd_images[id].file);
+
 	hdd_images[id].last_sector = (uint32_t) (full_size >> 9) - 1;
 
 	hdd_images[id].loaded = 1;
@@ -273,6 +735,11 @@ hdd_image_load(int id)
 
 	memset(empty_sector, 0, sizeof(empty_sector));
 
+	if (hdd_images[id].loaded) {
+		hdd_image_io_close(id);
+		hdd_image_unmap(id);
+	}
+
 	hdd_images[id].base = 0;
 
 	if (hdd_images[id].loaded) {
@@ -301,7 +768,13 @@ hdd_image_load(int id)
 		memset(hdd[id].fn, 0, sizeof(hdd[id].fn));
 		return 0;
 	}
-	hdd_images[id].file = plat_fopen(fn, L"rb+");
+	/* An image with an overlay is never written to, and may well be read-only. */
+	hdd_images[id].file = plat_fopen(fn, hdd[id].overlay_fn[0] ? L"rb" : L"rb+");
+	if ((hdd_images[id].file == NULL) && hdd[id].overlay_fn[0]) {
+		hdd_image_log("An image with an overlay must exist\n");
+		memset(hdd[id].fn, 0, sizeof(hdd[id].fn));
+		return 0;
+	}
 	if (hdd_images[id].file == NULL) {
 		/* Failed to open existing hard disk image */
 		if (errno == ENOENT) {
@@ -378,6 +851,10 @@ hdd_image_load(int id)
 			                ((uint64_t) hdd[id].tracks) << 9LL;
 
 			ret = prepare_new_hard_disk(id, full_size);
+			if (ret) {
+				hdd_image_map(id);
+				hdd_image_io_init(id);
+			}
 			return ret;
 		} else {
 			/* Failed for another reason */
@@ -493,6 +970,11 @@ hdd_image_load(int id)
 		ret = 1;
 	}   
 
+	if (ret) {
+		hdd_image_map(id);
+		hdd_image_io_init(id);
+	}
+
 	return ret;
 }
 
@@ -505,6 +987,7 @@ hdd_image_seek(uint8_t id, uint32_t sector)
 
 	hdd_images[id].pos = sector;
 	if (hdd_images[id].type != HDD_IMAGE_VHD) {
+		hdd_image_io_wait(id);
 		if (fseeko64(hdd_images[id].file, addr + hdd_images[id].base, SEEK_SET) == -1)
 			fatal("hdd_image_seek(): Error seeking\n");
 	}
@@ -514,24 +997,40 @@ hdd_image_seek(uint8_t id, uint32_t sector)
 void
 hdd_image_read(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
 {
-	if (hdd_images[id].type == HDD_IMAGE_VHD) {
-		int non_transferred_sectors = mvhd_read_sectors(hdd_images[id].vhd, sector, count, buffer);
-		hdd_images[id].pos = sector + count - non_transferred_sectors - 1;
+	hdd_image_t *img = &hdd_images[id];
+
+	if (img->type == HDD_IMAGE_VHD) {
+		int non_transferred_sectors = mvhd_read_sectors(img->vhd, sector, count, buffer);
+		img->pos = sector + count - non_transferred_sectors - 1;
+	} else if (img->map != NULL) {
+		count = hdd_image_map_clip(img, sector, count);
+		hdd_image_map_read(img, sector, count, buffer);
+		if (count > 0)
+			img->pos = sector + count - 1;
 	} else {
-		int i;
-
-		if (fseeko64(hdd_images[id].file, ((uint64_t)(sector) << 9LL) + hdd_images[id].base, SEEK_SET) == -1) {
-			fatal("Hard disk image %i: Read error during seek\n", id);
-			return;
+		uint32_t done;
+		int sequential = (sector == img->io_next_sector);
+
+		if (img->io_valid && (img->io_sector == sector) && (img->io_count >= count)) {
+			/* Served by the read-ahead. */
+			hdd_image_io_wait(id);
+			done = img->io_result;
+			if (done > count)
+				done = count;
+			memcpy(buffer, img->io_buffer, done << 9);
+		} else {
+			if (img->io_thread != NULL)
+				hdd_image_io_wait(id);
+			done = hdd_image_pio(img, 0, sector, count, buffer);
 		}
 
-		for (i = 0; i < count; i++) {
-			if (feof(hdd_images[id].file))
-				break;
+		if (done > 0)
+			img->pos = sector + done - 1;
+		img->io_next_sector = sector + count;
 
-			hdd_images[id].pos = sector + i;
-			fread(buffer + (i << 9), 1, 512, hdd_images[id].file);
-		}
+		/* Streaming through the image, fetch the next run while the guest deals with this one. */
+		if (sequential && (done == count))
+			hdd_image_read_ahead(id, sector + count, count);
 	}
 }
 
@@ -570,24 +1069,27 @@ hdd_image_read_ex(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
 void
 hdd_image_write(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
 {
-	if (hdd_images[id].type == HDD_IMAGE_VHD) {
-		int non_transferred_sectors = mvhd_write_sectors(hdd_images[id].vhd, sector, count, buffer);
-		hdd_images[id].pos = sector + count - non_transferred_sectors - 1;
+	hdd_image_t *img = &hdd_images[id];
+
+	if (img->type == HDD_IMAGE_VHD) {
+		int non_transferred_sectors = mvhd_write_sectors(img->vhd, sector, count, buffer);
+		img->pos = sector + count - non_transferred_sectors - 1;
+	} else if (img->map != NULL) {
+		count = hdd_image_map_clip(img, sector, count);
+		hdd_image_map_write(img, sector, count, buffer);
+		if (count > 0)
+			img->pos = sector + count - 1;
 	} else {
-		int i;
-
-		if (fseeko64(hdd_images[id].file, ((uint64_t)(sector) << 9LL) + hdd_images[id].base, SEEK_SET) == -1) {
-			fatal("Hard disk image %i: Write error during seek\n", id);
-			return;
+		if (img->io_thread != NULL) {
+			hdd_image_io_wait(id);
+			img->io_valid = 0;
+			img->io_next_sector = 0xffffffff;
 		}
 
-		for (i = 0; i < count; i++) {
-			if (feof(hdd_images[id].file))
-				break;
-
-			hdd_images[id].pos = sector + i;
-			fwrite(buffer + (i << 9), 512, 1, hdd_images[id].file);
-		}
+		if (hdd_image_pio(img, 1, sector, count, buffer) != count)
+			fatal("Hard disk image %i: Write error\n", id);
+		if (count > 0)
+			img->pos = sector + count - 1;
 	}
 }
 
@@ -612,25 +1114,33 @@ hdd_image_write_ex(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
 void
 hdd_image_zero(uint8_t id, uint32_t sector, uint32_t count)
 {
-	if (hdd_images[id].type == HDD_IMAGE_VHD) {
-		int non_transferred_sectors = mvhd_format_sectors(hdd_images[id].vhd, sector, count);
-		hdd_images[id].pos = sector + count - non_transferred_sectors - 1;
+	hdd_image_t *img = &hdd_images[id];
+
+	if (img->type == HDD_IMAGE_VHD) {
+		int non_transferred_sectors = mvhd_format_sectors(img->vhd, sector, count);
+		img->pos = sector + count - non_transferred_sectors - 1;
+	} else if (img->map != NULL) {
+		count = hdd_image_map_clip(img, sector, count);
+		hdd_image_map_write(img, sector, count, NULL);
+		if (count > 0)
+			img->pos = sector + count - 1;
 	} else {
-		uint32_t i = 0;
+		uint32_t i, n;
 
-		memset(empty_sector, 0, 512);
-
-		if (fseeko64(hdd_images[id].file, ((uint64_t)(sector) << 9LL) + hdd_images[id].base, SEEK_SET) == -1) {
-			fatal("Hard disk image %i: Zero error during seek\n", id);
-			return;
+		if (img->io_thread != NULL) {
+			hdd_image_io_wait(id);
+			img->io_valid = 0;
+			img->io_next_sector = 0xffffffff;
 		}
 
-		for (i = 0; i < count; i++) {
-			if (feof(hdd_images[id].file))
-				break;
+		for (i = 0; i < count; i += n) {
+			n = count - i;
+			if (n > (sizeof(empty_sectors) >> 9))
+				n = sizeof(empty_sectors) >> 9;
 
-			hdd_images[id].pos = sector + i;
-			fwrite(empty_sector, 512, 1, hdd_images[id].file);
+			if (hdd_image_pio(img, 1, sector + i, n, empty_sectors) != n)
+				fatal("Hard disk image %i: Zero error\n", id);
+			img->pos = sector + i + n - 1;
 		}
 	}
 }
@@ -674,6 +1184,8 @@ hdd_image_unload(uint8_t id, int fn_preserve)
 		return;
 
 	if (hdd_images[id].loaded) {
+		hdd_image_io_close(id);
+		hdd_image_unmap(id);
 		if (hdd_images[id].file != NULL) {
 			fclose(hdd_images[id].file);
 			hdd_images[id].file = NULL;
@@ -701,6 +1213,9 @@ hdd_image_close(uint8_t id)
 	if (!hdd_images[id].loaded)
 		return;
 
+	hdd_image_io_close(id);
+	hdd_image_unmap(id);
+
 	if (hdd_images[id].file != NULL) {
 		fclose(hdd_images[id].file);
 		hdd_images[id].file = NULL;
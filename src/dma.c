@@ -1620,16 +1620,26 @@ dma_mode(int channel)
 void
 dma_bm_read(uint32_t PhysAddress, uint8_t *DataRead, uint32_t TotalSize, int TransferSize)
 {
-    uint32_t i = 0, n, n2;
+    uint32_t i = 0, n, n2, len;
     uint8_t bytes[4] = { 0, 0, 0, 0 };
+    uint8_t *p;
 
     n = TotalSize & ~(TransferSize - 1);
     n2 = TotalSize - n;
 
-    /* Do the divisible block, if there is one. */
-    if (n) {
-	for (i = 0; i < n; i += TransferSize)
+    /* Do the divisible block, if there is one. Memory is copied a run at a
+       time, anything else still gets one access per transfer unit. */
+    while (i < n) {
+	len = n - i;
+	p = mem_phys_span(PhysAddress + i, &len);
+	if (p && (len >= TransferSize)) {
+		len &= ~(TransferSize - 1);
+		memcpy((void *) &(DataRead[i]), p, len);
+		i += len;
+	} else {
 		mem_read_phys((void *) &(DataRead[i]), PhysAddress + i, TransferSize);
+		i += TransferSize;
+	}
     }
 
     /* Do the non-divisible block, if there is one. */
@@ -1643,16 +1653,25 @@ dma_bm_read(uint32_t PhysAddress, uint8_t *DataRead, uint32_t TotalSize, int Tra
 void
 dma_bm_write(uint32_t PhysAddress, const uint8_t *DataWrite, uint32_t TotalSize, int TransferSize)
 {
-    uint32_t i = 0, n, n2;
+    uint32_t i = 0, n, n2, len;
     uint8_t bytes[4] = { 0, 0, 0, 0 };
+    uint8_t *p;
 
     n = TotalSize & ~(TransferSize - 1);
     n2 = TotalSize - n;
 
     /* Do the divisible block, if there is one. */
-    if (n) {
-	for (i = 0; i < n; i += TransferSize)
+    while (i < n) {
+	len = n - i;
+	p = mem_phys_span(PhysAddress + i, &len);
+	if (p && (len >= TransferSize)) {
+		len &= ~(TransferSize - 1);
+		memcpy(p, (void *) &(DataWrite[i]), len);
+		i += len;
+	} else {
 		mem_write_phys((void *) &(DataWrite[i]), PhysAddress + i, TransferSize);
+		i += TransferSize;
+	}
     }
 
     /* Do the non-divisible block, if there is one. */
@@ -104,6 +104,10 @@ extern int	sound_is_float,			/* (C) sound uses FP values */
 extern uint32_t	mem_size;			/* (C) memory size */
 extern int	cpu,				/* (C) cpu type */
 		cpu_use_dynarec,		/* (C) cpu uses/needs Dyna */
+		dynarec_cache_size,		/* (C) Dyna code cache size in MB */
+		mmu_tlb_size,			/* (C) soft TLB entries */
+		mmu_tlb_ways,			/* (C) soft TLB associativity */
+		cpu_decode_cache,		/* (C) interpreter EA decode cache */
 		fpu_type;			/* (C) fpu type */
 extern int	time_sync;			/* (C) enable time sync */
 extern int	network_type;			/* (C) net provider type */
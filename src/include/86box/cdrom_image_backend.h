@@ -46,6 +46,11 @@ typedef struct SMSF {
     uint8_t	fr;
 } TMSF;
 
+/* Track file read cache: LRU of fixed size blocks of the file. */
+#define CDI_CACHE_BLOCK_SIZE	65536
+#define CDI_CACHE_BLOCKS	32
+#define CDI_CACHE_READAHEAD	4	/* blocks loaded on a sequential miss */
+
 /* Track file struct. */
 typedef struct {
     int			(*read)(void *p, uint8_t *buffer, uint64_t seek, size_t count);
@@ -54,6 +59,14 @@ typedef struct {
 
     wchar_t		fn[260];
     FILE		*file;
+
+    uint8_t		*cache;
+    uint64_t		cache_block[CDI_CACHE_BLOCKS],	/* block number + 1, 0 if empty */
+			cache_next;			/* block after the last one missed */
+    uint32_t		cache_len[CDI_CACHE_BLOCKS],	/* bytes valid, short at end of file */
+			cache_used[CDI_CACHE_BLOCKS],
+			cache_clock;
+    uint64_t		cache_hits, cache_misses;
 } track_file_t;
 
 typedef struct {
@@ -67,6 +80,8 @@ typedef struct {
 typedef struct {
     int			tracks_num;
     track_t		*tracks;
+
+    int			last_track;	/* index of the track last looked up */
 } cd_img_t;
 
 
@@ -89,6 +104,7 @@ extern int	cdi_load_iso(cd_img_t *cdi, const wchar_t *filename);
 extern int	cdi_load_cue(cd_img_t *cdi, const wchar_t *cuefile);
 extern int	cdi_has_data_track(cd_img_t *cdi);
 extern int	cdi_has_audio_track(cd_img_t *cdi);
+extern void	cdi_get_cache_stats(cd_img_t *cdi, uint64_t *hits, uint64_t *misses);
 
 
 
@@ -88,12 +88,14 @@ typedef struct {
     uint8_t	bus,
 		res;			/* Reserved for bus mode */
     uint8_t	wp;			/* Disk has been mounted READ-ONLY */
-    uint8_t	pad, pad0;
+    uint8_t	mmap,			/* Access image through a memory mapping */
+		pad0;
 
     void	*priv;
 
     wchar_t	fn[1024],		/* Name of current image file */
-		prev_fn[1024];		/* Name of previous image file */
+		prev_fn[1024],		/* Name of previous image file */
+		overlay_fn[1024];	/* Copy-on-write overlay, empty if none */
 
     uint32_t	res0, pad1,
 		base,
@@ -115,6 +117,7 @@ extern void	hdd_image_init(void);
 extern int	hdd_image_load(int id);
 extern void	hdd_image_seek(uint8_t id, uint32_t sector);
 extern void	hdd_image_read(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer);
+extern void	hdd_image_read_ahead(uint8_t id, uint32_t sector, uint32_t count);
 extern int	hdd_image_read_ex(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer);
 extern void	hdd_image_write(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer);
 extern int	hdd_image_write_ex(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer);
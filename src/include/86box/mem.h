@@ -67,6 +67,19 @@
 
 #define MEM_STATE_SMM_SHIFT	16
 
+/* Soft TLB geometry, can be changed with the mmu_tlb_size and mmu_tlb_ways
+   configuration options. Both are rounded down to a power of two. */
+#define MMU_TLB_DEFAULT_SIZE	1024
+#define MMU_TLB_DEFAULT_WAYS	8
+#define MMU_TLB_MAX_SIZE	8192
+#define MMU_TLB_MAX_WAYS	16
+
+/* mmu_perm bits, same positions as in the page table entries. */
+#define MMU_PERM_WRITE		0x0002
+#define MMU_PERM_USER		0x0004
+#define MMU_PERM_LARGE		0x0080
+#define MMU_PERM_GLOBAL		0x0100
+
 /* #define's for memory granularity, currently 16k, but may
    change in the future - 4k works, less does not because of
    internal 4k pages. */
@@ -145,9 +158,6 @@ typedef struct page_t
 
     uint16_t	block, block_2;
 
-    /*Head of codeblock tree associated with this page*/
-    uint16_t head;
-
     uint64_t code_present_mask, dirty_mask;
 
     uint32_t evict_prev, evict_next;
@@ -189,14 +199,8 @@ extern uint32_t		rammask;
 extern uint8_t		*rom;
 extern uint32_t		biosmask, biosaddr;
 
-extern int		readlookup[256],
-			readlookupp[256];
 extern uintptr_t *	readlookup2;
-extern int		readlnext;
-extern int		writelookup[256],
-			writelookupp[256];
 extern uintptr_t *	writelookup2;
-extern int		writelnext;
 extern uint32_t		ram_mapped_addr[64];
 
 extern mem_mapping_t	ram_low_mapping,
@@ -218,12 +222,15 @@ extern uint32_t		get_phys_virt, get_phys_phys;
 
 extern int		shadowbios,
 			shadowbios_write;
-extern int		readlnum,
+extern int		readlnum,			/* TLB misses */
 			writelnum;
+extern uint64_t		mmu_tlb_kept;			/* entries kept by a flush */
+extern int		mmu_tlb_invlpg;
 
 extern int		memspeed[11];
 
 extern int		mmu_perm;
+extern int		mmuflush;
 
 extern int		mem_a20_state,
 			mem_a20_alt,
@@ -303,6 +310,7 @@ extern void	mem_writeb_phys(uint32_t addr, uint8_t val);
 extern void	mem_writew_phys(uint32_t addr, uint16_t val);
 extern void	mem_writel_phys(uint32_t addr, uint32_t val);
 extern void	mem_write_phys(void *src, uint32_t addr, int tranfer_size);
+extern uint8_t	*mem_phys_span(uint32_t addr, uint32_t *len);
 
 extern uint8_t	mem_read_ram(uint32_t addr, void *priv);
 extern uint16_t	mem_read_ramw(uint32_t addr, void *priv);
@@ -338,6 +346,8 @@ extern void	mem_reset_page_blocks(void);
 extern void     flushmmucache(void);
 extern void     flushmmucache_cr3(void);
 extern void	flushmmucache_nopc(void);
+extern void	flushmmucache_nonglobal(void);
+extern void	flushmmucache_user(void);
 extern void     mmu_invalidate(uint32_t addr);
 
 extern void	mem_a20_init(void);
@@ -364,7 +374,7 @@ static __inline uint32_t get_phys(uint32_t addr)
 	return addr & rammask;
     }
 
-    if (((int) (readlookup2[addr >> 12])) != -1)
+    if (readlookup2[addr >> 12] != (uintptr_t) LOOKUP_INV)
 	get_phys_phys = ((uintptr_t)readlookup2[addr >> 12] + (addr & ~0xfff)) - (uintptr_t)ram;
     else {
 	pa64 = mmutranslatereal(addr, 0);
@@ -389,7 +399,7 @@ static __inline uint32_t get_phys_noabrt(uint32_t addr)
     if (!(cr0 >> 31))
 	return addr & rammask;
 
-    if (((int) (readlookup2[addr >> 12])) != -1)
+    if (readlookup2[addr >> 12] != (uintptr_t) LOOKUP_INV)
 	return ((uintptr_t)readlookup2[addr >> 12] + addr) - (uintptr_t)ram;
 
     phys_addr = mmutranslate_noabrt(addr, 0);
@@ -69,14 +69,26 @@ typedef int (*NETWAITCB)(void *);
 typedef int (*NETSETLINKSTATE)(void *);
 
 
+/* Number of packet slots in each of the RX and TX queues, power of 2. */
+#define NET_QUEUE_LEN	64
+#define NET_QUEUE_MASK	(NET_QUEUE_LEN - 1)
+
+
 typedef struct netpkt {
     void		*priv;
     uint8_t		data[65536];	/* Maximum length + 1 to round up to the nearest power of 2. */
     int			len;
-
-    struct netpkt	*prev, *next;
 } netpkt_t;
 
+/* Fixed-size single producer, single consumer ring of packet slots. */
+typedef struct {
+    netpkt_t		*slots;
+    volatile uint32_t	head,		/* next slot to fill, producer only */
+			tail;		/* next slot to drain, consumer only */
+    uint32_t		depth_max,	/* high-water mark */
+			drops;		/* packets lost to a full queue */
+} netqueue_t;
+
 typedef struct {
     const char		*internal_name;
     const device_t	*device;
@@ -143,6 +155,12 @@ extern int	network_get_wait(void);
 extern void	network_timer_stop(void);
 
 extern void	network_queue_put(int tx, void *priv, uint8_t *data, int len);
+extern netpkt_t	*network_queue_slot(int tx);
+extern void	network_queue_commit(int tx, void *priv, int len);
+extern int	network_queue_depth(int tx);
+extern uint32_t	network_queue_drops(int tx);
+extern uint8_t	*network_tx_slot(void);
+extern void	network_tx_commit(int len);
 
 #ifdef __cplusplus
 }
@@ -33,11 +33,15 @@ typedef struct {
 
     void	(*load_func)(uint8_t new_m, int new_count);
     void	(*out_func)(int new_out, int old_out);
+
+    struct PIT	*dev;
 } ctr_t;
 
 
 typedef struct PIT {
-    int		flags, clock;
+    int		flags, clock,
+		skip;			/* Input clocks currently being skipped in one go. */
+    uint64_t	skip_ts;		/* Timestamp the skipped run started at. */
     pc_timer_t	callback_timer;
 
     ctr_t	counters[3];
@@ -39,7 +39,6 @@ extern int	gated,
 		speakval,
 		speakon;
 
-extern int	sound_pos_global;
 extern int	sound_card_current;
 
 
@@ -60,6 +59,9 @@ extern void	sound_set_cd_volume(unsigned int vol_l, unsigned int vol_r);
 
 extern void	sound_speed_changed(void);
 
+/* Position within the current sound buffer, in samples. */
+extern int	sound_get_pos_global(void);
+
 extern void	sound_init(void);
 extern void	sound_reset(void);
 
@@ -46,7 +46,10 @@ typedef struct pc_timer_t
 #else
     ts_t	ts;
 #endif
-    int		flags, pad;		/* The flags are defined above. */
+    int		flags,			/* The flags are defined above. */
+		heap_idx;		/* Position in the timer heap while enabled. */
+    uint64_t	seq;			/* Enable order, breaks ties between equal
+					   timestamps. */
     double	period;			/* This is used for large period timers to count
 					   the microseconds and split the period. */
 
@@ -56,6 +59,12 @@ typedef struct pc_timer_t
     struct	pc_timer_t *prev, *next;
 } pc_timer_t;
 
+/*Number of enabled timers above which they are kept in a heap rather than a
+  sorted list.*/
+#define TIMER_HEAP_MIN	64
+
+extern int	timer_heap_min;
+
 /*Timestamp of nearest enabled timer. CPU emulation must call timer_process()
   when TSC matches or exceeds this.*/
 extern uint32_t	timer_target;
@@ -197,18 +206,8 @@ extern int		timer_inited;
 static __inline void
 timer_remove_head_inline(void)
 {
-    pc_timer_t *timer;
-
-    if (timer_inited && timer_head) {
-	timer = timer_head;
-	timer_head = timer->next;
-	if (timer_head) {
-		timer_head->prev = NULL;
-		timer->next->prev = NULL;
-	}
-	timer->next = timer->prev = NULL;
-	timer->flags &= ~TIMER_ENABLED;
-    }
+    if (timer_inited && timer_head)
+	timer_remove_head();
 }
 
 
@@ -141,6 +141,11 @@ typedef struct svga_t
     uint16_t ksc5601_english_font_type;
 
     int vertical_linedbl;
+
+    /*Render thread for the packed pixel modes, and a counter bumped whenever the
+      state it renders from may have changed*/
+    struct svga_render_queue_t *render_queue;
+    int render_gen;
         
     /*Used to implement CRTC[0x17] bit 2 hsync divisor*/
     int hsync_divisor;
@@ -188,6 +193,7 @@ void		svga_close(svga_t *svga);
 
 uint32_t	svga_mask_addr(uint32_t addr, svga_t *svga);
 uint32_t	svga_mask_changedaddr(uint32_t addr, svga_t *svga);
+void		svga_mark_changed(svga_t *svga, uint32_t addr, uint32_t len);
 
 void		svga_doblit(int y1, int y2, int wx, int wy, svga_t *svga);
 
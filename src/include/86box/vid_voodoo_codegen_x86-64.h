@@ -21,9 +21,14 @@
 #include <xmmintrin.h>
 #endif
 
-#define BLOCK_NUM 8
-#define BLOCK_MASK (BLOCK_NUM-1)
+/*Generated blocks are shared by all render threads. They are found through a
+  hash of the pipeline state they were generated for, and once the cache is
+  full the least recently used block is replaced. A block a render thread is
+  currently drawing with is never replaced.*/
+#define BLOCK_NUM 512
 #define BLOCK_SIZE 8192
+#define BLOCK_HASH_SIZE 1024
+#define BLOCK_HASH_MASK (BLOCK_HASH_SIZE-1)
 
 #define LOD_MASK (LOD_TMIRROR_S | LOD_TMIRROR_T)
 
@@ -39,12 +44,26 @@ typedef struct voodoo_x86_data_t
         uint32_t tLOD[2];
         uint32_t trexInit1;   
 	int is_tiled;	
-} voodoo_x86_data_t;
 
-//static voodoo_x86_data_t voodoo_x86_data[2][BLOCK_NUM];
+        /*Hash chain this block is on, -1 if the block is unused*/
+        int hash;
+        int hash_next;
+        uint32_t last_used;
+} voodoo_x86_data_t;
 
-static int last_block[4] = {0, 0};
-static int next_block_to_write[4] = {0, 0};
+typedef struct voodoo_codegen_t
+{
+        voodoo_x86_data_t *blocks;
+        int hash[BLOCK_HASH_SIZE];
+        /*Block each render thread last drew with*/
+        int in_use[VOODOO_MAX_RENDER_THREADS];
+        /*Hits each render thread had without taking the lock*/
+        int hits[VOODOO_MAX_RENDER_THREADS];
+        /*Totals, updated with the lock held*/
+        int recomp, cache_hits, cache_evictions;
+        uint32_t stamp;
+        mutex_t *mutex;
+} voodoo_codegen_t;
 
 #define addbyte(val)                                            \
         do {                                                    \
@@ -3375,40 +3394,119 @@ static inline void voodoo_generate(uint8_t *code_block, voodoo_t *voodoo, voodoo
         
         addbyte(0xC3); /*RET*/
 }
-int voodoo_recomp = 0;
+
+static inline int voodoo_block_match(voodoo_x86_data_t *data, voodoo_t *voodoo, voodoo_params_t *params, voodoo_state_t *state)
+{
+        return (state->xdir == data->xdir &&
+                params->alphaMode == data->alphaMode &&
+                params->fbzMode == data->fbzMode &&
+                params->fogMode == data->fogMode &&
+                params->fbzColorPath == data->fbzColorPath &&
+                (voodoo->trexInit1[0] & (1 << 18)) == data->trexInit1 &&
+                params->textureMode[0] == data->textureMode[0] &&
+                params->textureMode[1] == data->textureMode[1] &&
+                (params->tLOD[0] & LOD_MASK) == data->tLOD[0] &&
+                (params->tLOD[1] & LOD_MASK) == data->tLOD[1] &&
+                ((params->col_tiled || params->aux_tiled) ? 1 : 0) == data->is_tiled);
+}
+
+static inline int voodoo_block_hash(voodoo_t *voodoo, voodoo_params_t *params, voodoo_state_t *state)
+{
+        uint32_t hash = params->fbzMode;
+
+        hash = (hash * 0x9e3779b1) ^ params->alphaMode;
+        hash = (hash * 0x9e3779b1) ^ params->fbzColorPath;
+        hash = (hash * 0x9e3779b1) ^ params->fogMode;
+        hash = (hash * 0x9e3779b1) ^ params->textureMode[0];
+        hash = (hash * 0x9e3779b1) ^ params->textureMode[1];
+        hash = (hash * 0x9e3779b1) ^ (params->tLOD[0] & LOD_MASK) ^ ((params->tLOD[1] & LOD_MASK) << 1);
+        hash = (hash * 0x9e3779b1) ^ (voodoo->trexInit1[0] & (1 << 18)) ^ (state->xdir & 3) ^
+                                     ((params->col_tiled || params->aux_tiled) ? 4 : 0);
+
+        return (hash ^ (hash >> 16)) & BLOCK_HASH_MASK;
+}
+
 static inline void *voodoo_get_block(voodoo_t *voodoo, voodoo_params_t *params, voodoo_state_t *state, int odd_even)
 {
-        int c;
-        int b = last_block[odd_even];
-        voodoo_x86_data_t *voodoo_x86_data = voodoo->codegen_data;
+        voodoo_codegen_t *codegen = voodoo->codegen_data;
         voodoo_x86_data_t *data;
-        
-        for (c = 0; c < 8; c++)
+        uint32_t age, oldest = 0;
+        int b, c, hash, victim = -1;
+
+        /*The block this thread drew with last can't have been replaced since,
+          so it can be checked without taking the lock. Nothing shared is
+          written here; the block is stamped when the thread moves off it*/
+        b = codegen->in_use[odd_even];
+        if (b != -1)
         {
-                data = &voodoo_x86_data[odd_even + c*4]; //&voodoo_x86_data[odd_even][b];
-                
-                if (state->xdir == data->xdir &&
-                    params->alphaMode == data->alphaMode &&
-                    params->fbzMode == data->fbzMode &&
-                    params->fogMode == data->fogMode &&
-                    params->fbzColorPath == data->fbzColorPath &&
-                    (voodoo->trexInit1[0] & (1 << 18)) == data->trexInit1 &&
-                    params->textureMode[0] == data->textureMode[0] &&
-                    params->textureMode[1] == data->textureMode[1] &&
-                    (params->tLOD[0] & LOD_MASK) == data->tLOD[0] &&
-                    (params->tLOD[1] & LOD_MASK) == data->tLOD[1] &&
-                    ((params->col_tiled || params->aux_tiled) ? 1 : 0) == data->is_tiled)
-                {
-                        last_block[odd_even] = b;
+                data = &codegen->blocks[b];
+                if (voodoo_block_match(data, voodoo, params, state))
+                {
+                        codegen->hits[odd_even]++;
                         return data->code_block;
                 }
-                
-                b = (b + 1) & 7;
         }
-voodoo_recomp++;
-        data = &voodoo_x86_data[odd_even + next_block_to_write[odd_even]*4];
-//        code_block = data->code_block;
-        
+
+        hash = voodoo_block_hash(voodoo, params, state);
+
+        thread_wait_mutex(codegen->mutex);
+
+        codegen->cache_hits += codegen->hits[odd_even];
+        codegen->hits[odd_even] = 0;
+        if (codegen->in_use[odd_even] != -1)
+                codegen->blocks[codegen->in_use[odd_even]].last_used = codegen->stamp++;
+
+        for (b = codegen->hash[hash]; b != -1; b = codegen->blocks[b].hash_next)
+        {
+                data = &codegen->blocks[b];
+                if (voodoo_block_match(data, voodoo, params, state))
+                {
+                        data->last_used = codegen->stamp++;
+                        codegen->in_use[odd_even] = b;
+                        codegen->cache_hits++;
+                        thread_release_mutex(codegen->mutex);
+                        return data->code_block;
+                }
+        }
+
+        /*Take an unused block if there is one, otherwise the least recently
+          used one that no other thread is drawing with*/
+        for (b = 0; b < BLOCK_NUM; b++)
+        {
+                for (c = 0; c < voodoo->render_threads; c++)
+                {
+                        if (codegen->in_use[c] == b)
+                                break;
+                }
+                if (c < voodoo->render_threads)
+                        continue;
+
+                data = &codegen->blocks[b];
+                if (data->hash == -1)
+                {
+                        victim = b;
+                        break;
+                }
+                age = codegen->stamp - data->last_used;
+                if (victim == -1 || age > oldest)
+                {
+                        victim = b;
+                        oldest = age;
+                }
+        }
+
+        data = &codegen->blocks[victim];
+        if (data->hash != -1)
+        {
+                int *prev = &codegen->hash[data->hash];
+
+                while (*prev != victim)
+                        prev = &codegen->blocks[*prev].hash_next;
+                *prev = data->hash_next;
+                codegen->cache_evictions++;
+        }
+
+        codegen->recomp++;
         voodoo_generate(data->code_block, voodoo, params, state, depth_op);
 
         data->xdir = state->xdir;
@@ -3421,22 +3519,39 @@ voodoo_recomp++;
         data->textureMode[1] = params->textureMode[1];
         data->tLOD[0] = params->tLOD[0] & LOD_MASK;
         data->tLOD[1] = params->tLOD[1] & LOD_MASK;
-	data->is_tiled = (params->col_tiled || params->aux_tiled) ? 1 : 0;
+        data->is_tiled = (params->col_tiled || params->aux_tiled) ? 1 : 0;
+
+        data->hash = hash;
+        data->hash_next = codegen->hash[hash];
+        codegen->hash[hash] = victim;
+        data->last_used = codegen->stamp++;
+        codegen->in_use[odd_even] = victim;
+
+        thread_release_mutex(codegen->mutex);
 
-        next_block_to_write[odd_even] = (next_block_to_write[odd_even] + 1) & 7;
-        
         return data->code_block;
 }
 
 void voodoo_codegen_init(voodoo_t *voodoo)
 {
+        voodoo_codegen_t *codegen;
         int c;
 
+        codegen = malloc(sizeof(voodoo_codegen_t));
+        memset(codegen, 0, sizeof(voodoo_codegen_t));
 #if _WIN64
-        voodoo->codegen_data = VirtualAlloc(NULL, sizeof(voodoo_x86_data_t) * BLOCK_NUM * 4, MEM_COMMIT, PAGE_EXECUTE_READWRITE);
+        codegen->blocks = VirtualAlloc(NULL, sizeof(voodoo_x86_data_t) * BLOCK_NUM, MEM_COMMIT, PAGE_EXECUTE_READWRITE);
 #else
-        voodoo->codegen_data = mmap(0, sizeof(voodoo_x86_data_t) * BLOCK_NUM*4, PROT_READ|PROT_WRITE|PROT_EXEC, MAP_ANON|MAP_PRIVATE, 0, 0);
+        codegen->blocks = mmap(0, sizeof(voodoo_x86_data_t) * BLOCK_NUM, PROT_READ|PROT_WRITE|PROT_EXEC, MAP_ANON|MAP_PRIVATE, 0, 0);
 #endif
+        for (c = 0; c < BLOCK_NUM; c++)
+                codegen->blocks[c].hash = -1;
+        for (c = 0; c < BLOCK_HASH_SIZE; c++)
+                codegen->hash[c] = -1;
+        for (c = 0; c < VOODOO_MAX_RENDER_THREADS; c++)
+                codegen->in_use[c] = -1;
+        codegen->mutex = thread_create_mutex();
+        voodoo->codegen_data = codegen;
 
         for (c = 0; c < 256; c++)
         {
@@ -3462,10 +3577,13 @@ void voodoo_codegen_init(voodoo_t *voodoo)
 
 void voodoo_codegen_close(voodoo_t *voodoo)
 {
+        voodoo_codegen_t *codegen = voodoo->codegen_data;
+
+        thread_close_mutex(codegen->mutex);
 #if _WIN64
-        VirtualFree(voodoo->codegen_data, 0, MEM_RELEASE);
+        VirtualFree(codegen->blocks, 0, MEM_RELEASE);
 #else
-        munmap(voodoo->codegen_data, sizeof(voodoo_x86_data_t) * BLOCK_NUM*4);
+        munmap(codegen->blocks, sizeof(voodoo_x86_data_t) * BLOCK_NUM);
 #endif
+        free(codegen);
 }
-
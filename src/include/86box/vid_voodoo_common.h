@@ -28,7 +28,10 @@
 
 #define TEX_DIRTY_SHIFT 10
 
-#define TEX_CACHE_MAX 64
+/*Number of decoded textures kept per TMU, selectable up to TEX_CACHE_MAX. Must be
+  a power of two*/
+#define TEX_CACHE_DEFAULT 64
+#define TEX_CACHE_MAX 512
 
 enum
 {
@@ -93,6 +96,11 @@ enum
 #define PARAM_FULL(x)    ((voodoo->params_write_idx - voodoo->params_read_idx[x]) >= PARAM_SIZE)
 #define PARAM_EMPTY(x)   (voodoo->params_read_idx[x] == voodoo->params_write_idx)
 
+/*Scanlines are interleaved between the render threads, so any number up to this
+  can be used. Each queued triangle carries a mask of the threads owning any of
+  its lines, and the others step over it without doing the setup.*/
+#define VOODOO_MAX_RENDER_THREADS 16
+
 typedef struct
 {
         uint32_t addr_type;
@@ -172,17 +180,21 @@ typedef struct voodoo_params_t
 
         int col_tiled, aux_tiled;
         int row_width, aux_row_width;
+
+        uint32_t render_mask;
 } voodoo_params_t;
 
 typedef struct texture_t
 {
         uint32_t base;
         uint32_t tLOD;
-        volatile int refcount, refcount_r[4];
+        volatile int refcount, refcount_r[VOODOO_MAX_RENDER_THREADS];
         int is16;
         uint32_t palette_checksum;
         uint32_t addr_start[4], addr_end[4];
         uint32_t *data;
+        int dirty;
+        uint64_t hash;
 } texture_t;
 
 typedef struct vert_t
@@ -200,6 +212,14 @@ typedef struct clip_t
         int y_min, y_max;
 } clip_t;
 
+struct voodoo_t;
+
+typedef struct voodoo_render_thread_t
+{
+        struct voodoo_t *voodoo;
+        int odd_even;
+} voodoo_render_thread_t;
+
 typedef struct voodoo_t
 {
         mem_mapping_t mapping;
@@ -273,21 +293,21 @@ typedef struct voodoo_t
         int ncc_dirty[2];
 
         thread_t *fifo_thread;
-        thread_t *render_thread[4];
+        thread_t *render_thread[VOODOO_MAX_RENDER_THREADS];
+        voodoo_render_thread_t render_thread_data[VOODOO_MAX_RENDER_THREADS];
         event_t *wake_fifo_thread;
         event_t *wake_main_thread;
         event_t *fifo_not_full_event;
-        event_t *render_not_full_event[4];
-        event_t *wake_render_thread[4];
+        event_t *render_not_full_event[VOODOO_MAX_RENDER_THREADS];
+        event_t *wake_render_thread[VOODOO_MAX_RENDER_THREADS];
 
         int voodoo_busy;
-        int render_voodoo_busy[4];
+        int render_voodoo_busy[VOODOO_MAX_RENDER_THREADS];
 
         int render_threads;
-        int odd_even_mask;
 
-        int pixel_count[4], texel_count[4], tri_count, frame_count;
-        int pixel_count_old[4], texel_count_old[4];
+        int pixel_count[VOODOO_MAX_RENDER_THREADS], texel_count[VOODOO_MAX_RENDER_THREADS], tri_count, frame_count;
+        int pixel_count_old[VOODOO_MAX_RENDER_THREADS], texel_count_old[VOODOO_MAX_RENDER_THREADS];
         int wr_count, rd_count, tex_count;
 
         int retrace_count;
@@ -311,7 +331,7 @@ typedef struct voodoo_t
         volatile int cmd_read, cmd_written, cmd_written_fifo;
 
         voodoo_params_t params_buffer[PARAM_SIZE];
-        volatile int params_read_idx[4], params_write_idx;
+        volatile int params_read_idx[VOODOO_MAX_RENDER_THREADS], params_write_idx;
 
         uint32_t cmdfifo_base, cmdfifo_end, cmdfifo_size;
         int cmdfifo_rp, cmdfifo_ret_addr;
@@ -479,15 +499,20 @@ typedef struct voodoo_t
         uint8_t thefilterb[256][256];
         uint16_t purpleline[256][3];
 
-        texture_t texture_cache[2][TEX_CACHE_MAX];
+        texture_t *texture_cache[2];
+        int texture_cache_size;
+        uint32_t texture_cache_mem;
         uint8_t texture_present[2][16384];
         int texture_last_removed;
 
+        int tex_decodes, tex_hash_hits, tex_frame;
+        int tex_decodes_last, tex_hash_hits_last;
+
         uint32_t palette_checksum[2];
         int palette_dirty[2];
 
         uint64_t time;
-        int render_time[4];
+        int render_time[VOODOO_MAX_RENDER_THREADS];
 
         int force_blit_count;
         int can_blit;
@@ -297,42 +297,63 @@ void voodoo_codegen_close(voodoo_t *voodoo);
 
 
 
-void voodoo_render_thread_1(void *param);
-void voodoo_render_thread_2(void *param);
-void voodoo_render_thread_3(void *param);
-void voodoo_render_thread_4(void *param);
+void voodoo_render_thread(void *param);
 void voodoo_queue_triangle(voodoo_t *voodoo, voodoo_params_t *params);
 
-extern int voodoo_recomp;
 extern int tris;
 
+/*Spread a texel out to one channel per 16-bit lane, for voodoo_bilinear().*/
+static __inline uint64_t voodoo_bilinear_unpack(uint32_t dat)
+{
+        uint64_t v = dat;
+
+        v = (v | (v << 16)) & 0x0000ffff0000ffffull;
+        return (v | (v << 8)) & 0x00ff00ff00ff00ffull;
+}
+
+/*Bilinear blend of four texels, with weights that add up to 256. With each
+  texel spread out to one channel per 16-bit lane, all four channels are
+  weighted with a single multiply, and as the weights add up to 256 no lane can
+  carry into the next. Channel n of the result ends up in bits 16n+8 to
+  16n+15.*/
+static __inline uint64_t voodoo_bilinear(const rgba_u *dat, const int *d)
+{
+        return voodoo_bilinear_unpack(dat[0].u) * d[0] + voodoo_bilinear_unpack(dat[1].u) * d[1] +
+               voodoo_bilinear_unpack(dat[2].u) * d[2] + voodoo_bilinear_unpack(dat[3].u) * d[3];
+}
+
 static __inline void voodoo_wake_render_thread(voodoo_t *voodoo)
 {
-        thread_set_event(voodoo->wake_render_thread[0]); /*Wake up render thread if moving from idle*/
-        if (voodoo->render_threads >= 2)
-                thread_set_event(voodoo->wake_render_thread[1]); /*Wake up render thread if moving from idle*/
-        if (voodoo->render_threads == 4)
+        int c;
+
+        for (c = 0; c < voodoo->render_threads; c++)
+                thread_set_event(voodoo->wake_render_thread[c]); /*Wake up render thread if moving from idle*/
+}
+
+static __inline int voodoo_render_threads_busy(voodoo_t *voodoo)
+{
+        int c;
+
+        for (c = 0; c < voodoo->render_threads; c++)
         {
-                thread_set_event(voodoo->wake_render_thread[2]); /*Wake up render thread if moving from idle*/
-                thread_set_event(voodoo->wake_render_thread[3]); /*Wake up render thread if moving from idle*/
+                if (!PARAM_EMPTY(c) || voodoo->render_voodoo_busy[c])
+                        return 1;
         }
+
+        return 0;
 }
 
 static __inline void voodoo_wait_for_render_thread_idle(voodoo_t *voodoo)
 {
-        while (!PARAM_EMPTY(0) || (voodoo->render_threads >= 2 && !PARAM_EMPTY(1)) ||
-                (voodoo->render_threads == 4 && (!PARAM_EMPTY(2) || !PARAM_EMPTY(3))) ||
-                voodoo->render_voodoo_busy[0] || (voodoo->render_threads >= 2 && voodoo->render_voodoo_busy[1]) ||
-                (voodoo->render_threads == 4 && (voodoo->render_voodoo_busy[2] || voodoo->render_voodoo_busy[3])))
+        int c;
+
+        while (voodoo_render_threads_busy(voodoo))
         {
                 voodoo_wake_render_thread(voodoo);
-                if (!PARAM_EMPTY(0) || voodoo->render_voodoo_busy[0])
-                        thread_wait_event(voodoo->render_not_full_event[0], 1);
-                if (voodoo->render_threads >= 2 && (!PARAM_EMPTY(1) || voodoo->render_voodoo_busy[1]))
-                        thread_wait_event(voodoo->render_not_full_event[1], 1);
-                if (voodoo->render_threads == 4 && (!PARAM_EMPTY(2) || voodoo->render_voodoo_busy[2]))
-                        thread_wait_event(voodoo->render_not_full_event[2], 1);
-                if (voodoo->render_threads == 4 && (!PARAM_EMPTY(3) || voodoo->render_voodoo_busy[3]))
-                        thread_wait_event(voodoo->render_not_full_event[3], 1);
+                for (c = 0; c < voodoo->render_threads; c++)
+                {
+                        if (!PARAM_EMPTY(c) || voodoo->render_voodoo_busy[c])
+                                thread_wait_event(voodoo->render_not_full_event[c], 1);
+                }
         }
 }
@@ -74,6 +74,13 @@ typedef struct {
     uint8_t	r, g, b;
 } rgb_t;
 
+/* A run of render_buffer rows [y1, y2) updated by a blit. */
+typedef struct {
+    int		y1, y2;
+} video_span_t;
+
+#define VIDEO_BLIT_SPANS	64
+
 typedef struct {
     uint8_t	chr[32];
 } dbcs_font_t;
@@ -154,9 +161,11 @@ extern void	video_setblit(void(*blit)(int,int,int,int,int,int));
 extern void	video_blend(int x, int y);
 extern void	video_blit_memtoscreen_8(int x, int y, int y1, int y2, int w, int h);
 extern void	video_blit_memtoscreen(int x, int y, int y1, int y2, int w, int h);
-extern void	video_blit_complete(void);
+extern void	video_blit_memtoscreen_dirty(int x, int y, int y1, int y2, int w, int h);
 extern void	video_wait_for_blit(void);
-extern void	video_wait_for_buffer(void);
+extern void	video_mark_dirty(int y1, int y2);
+extern int	video_blit_get_spans(const video_span_t **spans);
+extern void	video_get_frame_stats(uint64_t *shown, uint64_t *dropped);
 
 extern bitmap_t	*create_bitmap(int w, int h);
 extern void	destroy_bitmap(bitmap_t *b);
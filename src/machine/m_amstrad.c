@@ -349,7 +349,6 @@ vid_poll_1512(void *priv)
 	if (vid->dispon) {
 		if (vid->displine < vid->firstline) {
 			vid->firstline = vid->displine;
-			video_wait_for_buffer();
 		}
 		vid->lastline = vid->displine;
 		for (c = 0; c < 8; c++) {
@@ -1442,7 +1441,6 @@ lcdc_poll(amsvid_t *vid)
 	if (cga->cgadispon) {
 		if (cga->displine < cga->firstline) {
 			cga->firstline = cga->displine;
-			video_wait_for_buffer();
 		}
 		cga->lastline = cga->displine;
 
@@ -467,9 +467,6 @@ compaq_plasma_poll(void *p)
 		self->cga.cgastat |= 1;
 		self->linepos = 1;
                 if (self->dispon) {
-			if (self->displine == 0)
-                                video_wait_for_buffer();
-
 			/* Graphics */
 			if (self->cga.cgamode & 0x02)	 {
 				if (self->cga.cgamode & 0x10)
@@ -262,7 +262,6 @@ vid_poll(void *p)
 
 		if (pcjr->displine < pcjr->firstline) {
 			pcjr->firstline = pcjr->displine;
-			video_wait_for_buffer();
 		}
 		pcjr->lastline = pcjr->displine;
 		cols[0] = (pcjr->array[2] & 0xf) + 16;
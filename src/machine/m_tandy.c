@@ -674,7 +674,6 @@ vid_poll(void *priv)
 	if (vid->dispon) {
 		if (vid->displine < vid->firstline) {
 			vid->firstline = vid->displine;
-			video_wait_for_buffer();
 		}
 		vid->lastline = vid->displine;
 		cols[0] = (vid->array[2] & 0xf) + 16;
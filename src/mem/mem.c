@@ -79,13 +79,7 @@ uint32_t		biosmask, biosaddr;
 uint32_t		pccache;
 uint8_t			*pccache2;
 
-int			readlnext;
-int			readlookup[256],
-			readlookupp[256];
 uintptr_t		*readlookup2;
-int			writelnext;
-int			writelookup[256],
-			writelookupp[256];
 uintptr_t		*writelookup2;
 
 uint32_t		mem_logical_addr;
@@ -94,7 +88,8 @@ int			shadowbios = 0,
 			shadowbios_write;
 int			readlnum = 0,
 			writelnum = 0;
-int			cachesize = 256;
+uint64_t		mmu_tlb_kept = 0;
+int			mmu_tlb_invlpg = 0;
 
 uint32_t		get_phys_virt,
 			get_phys_phys;
@@ -104,7 +99,7 @@ int			mem_a20_key = 0,
 			mem_a20_state = 0;
 
 int			mmuflush = 0;
-int			mmu_perm = 4;
+int			mmu_perm = MMU_PERM_USER | MMU_PERM_WRITE;
 
 uint64_t		*byte_dirty_mask;
 uint64_t		*byte_code_present_mask;
@@ -118,6 +113,30 @@ static mem_mapping_t	*base_mapping, *last_mapping;
 static mem_mapping_t	*read_mapping[MEM_MAPPINGS_NO];
 static mem_mapping_t	*write_mapping[MEM_MAPPINGS_NO];
 static uint8_t		ff_pccache[4] = { 0xff, 0xff, 0xff, 0xff };
+
+/* Soft TLB. The translations themselves live in the page-indexed
+   readlookup2/writelookup2/page_lookup tables, which remain the fast path;
+   the TLB keeps track of which virtual pages are present in them, with the
+   permissions they were translated with, so that they can be replaced and
+   invalidated selectively. */
+#define TLB_INVALID		0xffffffff
+
+typedef struct {
+    uint32_t	page[MMU_TLB_MAX_SIZE];		/* virtual page number */
+    uint16_t	flags[MMU_TLB_MAX_SIZE];	/* MMU_PERM_* */
+    uint8_t	next[MMU_TLB_MAX_SIZE];		/* per-set replacement */
+    uint16_t	user;				/* bits an entry needs to be usable from CPL 3 */
+    int		large,				/* large page entries */
+		supervisor,			/* entries without all the user bits */
+		write;
+} mmu_tlb_t;
+
+static mmu_tlb_t	read_tlb = { .user = MMU_PERM_USER },
+			write_tlb = { .user = MMU_PERM_USER | MMU_PERM_WRITE, .write = 1 };
+static int		tlb_size = MMU_TLB_DEFAULT_SIZE,
+			tlb_ways = MMU_TLB_DEFAULT_WAYS,
+			tlb_set_mask = (MMU_TLB_DEFAULT_SIZE / MMU_TLB_DEFAULT_WAYS) - 1;
+static uint32_t		mmu_perm_page = TLB_INVALID;
 static uint8_t		*_mem_exec[MEM_MAPPINGS_NO];
 static uint32_t		_mem_state[MEM_MAPPINGS_NO];
 static uint32_t		remap_start_addr;
@@ -152,46 +171,186 @@ mem_addr_is_ram(uint32_t addr)
 }
 
 
-void
-resetreadlookup(void)
+static int
+mmu_tlb_pow2(int val, int def, int min, int max)
+{
+    int ret = min;
+
+    if (val <= 0)
+	return def;
+
+    while ((ret < max) && ((ret << 1) <= val))
+	ret <<= 1;
+
+    return ret;
+}
+
+
+static void
+mmu_tlb_init(mmu_tlb_t *tlb)
 {
     int c;
 
-    /* Initialize the page lookup table. */
-    memset(page_lookup, 0x00, (1<<20)*sizeof(page_t *));
+    for (c = 0; c < MMU_TLB_MAX_SIZE; c++) {
+	tlb->page[c] = TLB_INVALID;
+	tlb->next[c] = 0;
+    }
+    tlb->large = tlb->supervisor = 0;
+}
+
+
+static void
+mmu_tlb_drop(mmu_tlb_t *tlb, int entry)
+{
+    uint32_t page = tlb->page[entry];
+
+    if (tlb->write) {
+	page_lookup[page] = NULL;
+	writelookup2[page] = LOOKUP_INV;
+    } else
+	readlookup2[page] = LOOKUP_INV;
 
-    /* Initialize the tables for lower (<= 1024K) RAM. */
-    for (c = 0; c < 256; c++) {
-	readlookup[c] = 0xffffffff;
-	writelookup[c] = 0xffffffff;
+    if (tlb->flags[entry] & MMU_PERM_LARGE)
+	tlb->large--;
+    if ((tlb->flags[entry] & tlb->user) != tlb->user)
+	tlb->supervisor--;
+
+    tlb->page[entry] = TLB_INVALID;
+}
+
+
+static void
+mmu_tlb_insert(mmu_tlb_t *tlb, uint32_t page, uint16_t flags)
+{
+    int set = page & tlb_set_mask;
+    int base = set * tlb_ways;
+    int way;
+
+    for (way = 0; way < tlb_ways; way++) {
+	if (tlb->page[base + way] == TLB_INVALID)
+		break;
     }
 
-    /* Initialize the tables for high (> 1024K) RAM. */
-    memset(readlookup2, 0xff, (1<<20)*sizeof(uintptr_t));
-    memset(writelookup2, 0xff, (1<<20)*sizeof(uintptr_t));
+    if (way == tlb_ways) {
+	way = tlb->next[set];
+	tlb->next[set] = (way + 1) & (tlb_ways - 1);
+	mmu_tlb_drop(tlb, base + way);
+    }
 
-    readlnext = 0;
-    writelnext = 0;
-    pccache = 0xffffffff;
+    tlb->page[base + way] = page;
+    tlb->flags[base + way] = flags;
+    if (flags & MMU_PERM_LARGE)
+	tlb->large++;
+    if ((flags & tlb->user) != tlb->user)
+	tlb->supervisor++;
 }
 
 
-void
-flushmmucache(void)
+/* Drop every entry that does not have all the bits in keep set. */
+static void
+mmu_tlb_flush(mmu_tlb_t *tlb, uint16_t keep)
 {
-    int c;
+    int c, kept = 0;
 
-    for (c = 0; c < 256; c++) {
-	if (readlookup[c] != (int) 0xffffffff) {
-		readlookup2[readlookup[c]] = LOOKUP_INV;
-		readlookup[c] = 0xffffffff;
+    for (c = 0; c < tlb_size; c++) {
+	if (tlb->page[c] == TLB_INVALID)
+		continue;
+
+	if (keep && ((tlb->flags[c] & keep) == keep)) {
+		kept++;
+		continue;
 	}
-	if (writelookup[c] != (int) 0xffffffff) {
-		page_lookup[writelookup[c]] = NULL;
-		writelookup2[writelookup[c]] = LOOKUP_INV;
-		writelookup[c] = 0xffffffff;
+
+	mmu_tlb_drop(tlb, c);
+    }
+
+    mmu_tlb_kept += kept;
+}
+
+
+static void
+mmu_tlb_invalidate(mmu_tlb_t *tlb, uint32_t page)
+{
+    int base = (page & tlb_set_mask) * tlb_ways;
+    uint32_t frame_mask;
+    int c;
+
+    for (c = base; c < (base + tlb_ways); c++) {
+	if (tlb->page[c] == page)
+		mmu_tlb_drop(tlb, c);
+    }
+
+    /* The other 4K pieces of a large page can be in any set. */
+    if (tlb->large) {
+	frame_mask = (cr4 & CR4_PAE) ? ~0x1ff : ~0x3ff;
+
+	for (c = 0; c < tlb_size; c++) {
+		if ((tlb->page[c] != TLB_INVALID) && (tlb->flags[c] & MMU_PERM_LARGE) &&
+		    ((tlb->page[c] & frame_mask) == (page & frame_mask)))
+			mmu_tlb_drop(tlb, c);
 	}
     }
+}
+
+
+/* Permissions of the page being added, as recorded by the last page walk. */
+static uint16_t
+mmu_tlb_flags(uint32_t virt)
+{
+    if (!(cr0 >> 31))
+	return MMU_PERM_USER | MMU_PERM_WRITE;
+
+    /* Not from a walk of this page (eg. the second half of a misaligned
+       access), so make it the first thing to go on a flush. */
+    if ((virt >> 12) != mmu_perm_page)
+	return 0;
+
+    return mmu_perm;
+}
+
+
+static void
+mmu_set_perm(uint32_t addr, uint32_t flags)
+{
+    if (!(cr4 & CR4_PGE))
+	flags &= ~MMU_PERM_GLOBAL;
+
+    mmu_perm = flags & (MMU_PERM_USER | MMU_PERM_WRITE | MMU_PERM_LARGE | MMU_PERM_GLOBAL);
+    mmu_perm_page = addr >> 12;
+}
+
+
+void
+resetreadlookup(void)
+{
+    int c;
+
+    /* Every valid entry in the lookup tables is in the TLB, so clearing
+       those leaves the tables empty without touching the rest of them. */
+    mmu_tlb_flush(&read_tlb, 0);
+    mmu_tlb_flush(&write_tlb, 0);
+
+    /* Set up the soft TLB. */
+    tlb_size = mmu_tlb_pow2(mmu_tlb_size, MMU_TLB_DEFAULT_SIZE, 16, MMU_TLB_MAX_SIZE);
+    tlb_ways = mmu_tlb_pow2(mmu_tlb_ways, MMU_TLB_DEFAULT_WAYS, 1, MMU_TLB_MAX_WAYS);
+    if (tlb_ways > tlb_size)
+	tlb_ways = tlb_size;
+    tlb_set_mask = (tlb_size / tlb_ways) - 1;
+
+    for (c = 0; c < MMU_TLB_MAX_SIZE; c++)
+	read_tlb.next[c] = write_tlb.next[c] = 0;
+
+    mmu_perm_page = TLB_INVALID;
+    pccache = 0xffffffff;
+}
+
+
+void
+flushmmucache(void)
+{
+    mmu_tlb_flush(&read_tlb, 0);
+    mmu_tlb_flush(&write_tlb, 0);
+    mmu_perm_page = TLB_INVALID;
     mmuflush++;
 
     pccache = (uint32_t)0xffffffff;
@@ -206,38 +365,49 @@ flushmmucache(void)
 void
 flushmmucache_nopc(void)
 {
-    int c;
-
-    for (c = 0; c < 256; c++) {
-	if (readlookup[c] != (int) 0xffffffff) {
-		readlookup2[readlookup[c]] = LOOKUP_INV;
-		readlookup[c] = 0xffffffff;
-	}
-	if (writelookup[c] != (int) 0xffffffff) {
-		page_lookup[writelookup[c]] = NULL;
-		writelookup2[writelookup[c]] = LOOKUP_INV;
-		writelookup[c] = 0xffffffff;
-	}
-    }
+    mmu_tlb_flush(&read_tlb, 0);
+    mmu_tlb_flush(&write_tlb, 0);
+    mmu_perm_page = TLB_INVALID;
 }
 
 
 void
 flushmmucache_cr3(void)
 {
-    int c;
+    mmu_tlb_flush(&read_tlb, 0);
+    mmu_tlb_flush(&write_tlb, 0);
+    mmu_perm_page = TLB_INVALID;
+}
 
-    for (c = 0; c < 256; c++) {
-	if (readlookup[c] != (int) 0xffffffff) {
-		readlookup2[readlookup[c]] = LOOKUP_INV;
-		readlookup[c] = 0xffffffff;
-	}
-	if (writelookup[c] != (int) 0xffffffff) {
-		page_lookup[writelookup[c]] = NULL;
-		writelookup2[writelookup[c]] = LOOKUP_INV;
-		writelookup[c] = 0xffffffff;
-	}
-    }
+
+/* CR3 load: global pages survive if CR4.PGE is set. */
+void
+flushmmucache_nonglobal(void)
+{
+    mmu_tlb_flush(&read_tlb, MMU_PERM_GLOBAL);
+    mmu_tlb_flush(&write_tlb, MMU_PERM_GLOBAL);
+    mmu_perm_page = TLB_INVALID;
+    mmuflush++;
+
+    pccache = (uint32_t)0xffffffff;
+    pccache2 = (uint8_t *)0xffffffff;
+
+#ifdef USE_DYNAREC
+    codegen_flush();
+#endif
+}
+
+
+/* Entering CPL 3: only the entries that were translated for supervisor
+   accesses need to go, as permissions are only checked on a page walk. */
+void
+flushmmucache_user(void)
+{
+    if (read_tlb.supervisor)
+	mmu_tlb_flush(&read_tlb, read_tlb.user);
+    if (write_tlb.supervisor)
+	mmu_tlb_flush(&write_tlb, write_tlb.user);
+    mmu_perm_page = TLB_INVALID;
 }
 
 
@@ -248,8 +418,8 @@ mem_flush_write_page(uint32_t addr, uint32_t virt)
     int c;
     uint32_t a;
 
-    for (c = 0; c < 256; c++) {
-	if (writelookup[c] != (int) 0xffffffff) {
+    for (c = 0; c < tlb_size; c++) {
+	if (write_tlb.page[c] != TLB_INVALID) {
 		a = (uintptr_t)(addr & ~0xfff) - (virt & ~0xfff);
 		uintptr_t target;
 
@@ -258,11 +428,8 @@ mem_flush_write_page(uint32_t addr, uint32_t virt)
 		else
 			target = (uintptr_t)&ram[a];
 
-		if (writelookup2[writelookup[c]] == target || page_lookup[writelookup[c]] == page_target) {
-			writelookup2[writelookup[c]] = LOOKUP_INV;
-			page_lookup[writelookup[c]] = NULL;
-			writelookup[c] = 0xffffffff;
-		}
+		if (writelookup2[write_tlb.page[c]] == target || page_lookup[write_tlb.page[c]] == page_target)
+			mmu_tlb_drop(&write_tlb, c);
 	}
     }
 }
@@ -310,7 +477,7 @@ mmutranslatereal_normal(uint32_t addr, int rw)
 		return 0xffffffffffffffffULL;
 	}
 
-	mmu_perm = temp & 4;
+	mmu_set_perm(addr, (temp & 0x106) | MMU_PERM_LARGE);
 	rammap(addr2) |= 0x20;
 
 	return (temp & ~0x3fffff) + (addr & 0x3fffff);
@@ -328,7 +495,7 @@ mmutranslatereal_normal(uint32_t addr, int rw)
 	return 0xffffffffffffffffULL;
     }
 
-    mmu_perm = temp & 4;
+    mmu_set_perm(addr, (temp3 & 6) | (temp & 0x100));
     rammap(addr2) |= 0x20;
     rammap((temp2 & ~0xfff) + ((addr >> 10) & 0xffc)) |= (rw?0x60:0x20);
 
@@ -384,7 +551,7 @@ mmutranslatereal_pae(uint32_t addr, int rw)
 
 		return 0xffffffffffffffffULL;
 	}
-	mmu_perm = temp & 4;
+	mmu_set_perm(addr, (temp & 0x106) | MMU_PERM_LARGE);
 	rammap64(addr3) |= 0x20;
 
 	return ((temp & ~0x1fffffULL) + (addr & 0x1fffffULL)) & 0x000000ffffffffffULL;
@@ -403,7 +570,7 @@ mmutranslatereal_pae(uint32_t addr, int rw)
 	return 0xffffffffffffffffULL;
     }
 
-    mmu_perm = temp & 4;
+    mmu_set_perm(addr, (temp3 & 6) | (temp & 0x100));
     rammap64(addr3) |= 0x20;
     rammap64(addr4) |= (rw? 0x60 : 0x20);
 
@@ -528,7 +695,13 @@ mmutranslate_noabrt(uint32_t addr, int rw)
 void
 mmu_invalidate(uint32_t addr)
 {
-    flushmmucache_cr3();
+    mmu_tlb_invalidate(&read_tlb, addr >> 12);
+    mmu_tlb_invalidate(&write_tlb, addr >> 12);
+    mmu_perm_page = TLB_INVALID;
+    mmu_tlb_invlpg++;
+
+    pccache = (uint32_t)0xffffffff;
+    pccache2 = (uint8_t *)0xffffffff;
 }
 
 
@@ -561,14 +734,12 @@ addreadlookup(uint32_t virt, uint32_t phys)
 #else
     uint32_t a;
 #endif
+    uintptr_t lookup;
 
     if (virt == 0xffffffff) return;
 
     if (readlookup2[virt>>12] != (uintptr_t) LOOKUP_INV) return;
 
-    if (readlookup[readlnext] != (int) 0xffffffff)
-	readlookup2[readlookup[readlnext]] = LOOKUP_INV;
-
 #if (defined __amd64__ || defined _M_X64)
     a = ((uint64_t)(phys & ~0xfff) - (uint64_t)(virt & ~0xfff));
 #else
@@ -576,13 +747,18 @@ addreadlookup(uint32_t virt, uint32_t phys)
 #endif
 
     if ((phys & ~0xfff) >= (1 << 30))
-	readlookup2[virt>>12] = (uintptr_t)&ram2[a - (1 << 30)];
+	lookup = (uintptr_t)&ram2[a - (1 << 30)];
     else
-	readlookup2[virt>>12] = (uintptr_t)&ram[a];
+	lookup = (uintptr_t)&ram[a];
+
+    /* On 32-bit hosts the biased pointer can wrap around to LOOKUP_INV. Such a
+       page is simply never put in the table, and goes through the slow path. */
+    if (lookup == (uintptr_t) LOOKUP_INV) return;
 
-    readlookupp[readlnext] = mmu_perm;
-    readlookup[readlnext++] = virt >> 12;
-    readlnext &= (cachesize-1);
+    mmu_tlb_insert(&read_tlb, virt >> 12, mmu_tlb_flags(virt));
+    readlnum++;
+
+    readlookup2[virt>>12] = lookup;
 
     cycles -= 9;
 }
@@ -596,16 +772,12 @@ addwritelookup(uint32_t virt, uint32_t phys)
 #else
     uint32_t a;
 #endif
+    uintptr_t lookup;
 
     if (virt == 0xffffffff) return;
 
     if (page_lookup[virt >> 12]) return;
 
-    if (writelookup[writelnext] != -1) {
-	page_lookup[writelookup[writelnext]] = NULL;
-	writelookup2[writelookup[writelnext]] = LOOKUP_INV;
-    }
-
 #ifdef USE_NEW_DYNAREC
 #ifdef USE_DYNAREC
     if (pages[phys >> 12].block || (phys & ~0xfff) == recomp_page)
@@ -619,8 +791,11 @@ addwritelookup(uint32_t virt, uint32_t phys)
     if (pages[phys >> 12].block[0] || pages[phys >> 12].block[1] || pages[phys >> 12].block[2] || pages[phys >> 12].block[3])
 #endif
 #endif
+    {
+	mmu_tlb_insert(&write_tlb, virt >> 12, mmu_tlb_flags(virt));
+	writelnum++;
 	page_lookup[virt >> 12] = &pages[phys >> 12];
-    else {
+    } else {
 #if (defined __amd64__ || defined _M_X64)
 	a = ((uint64_t)(phys & ~0xfff) - (uint64_t)(virt & ~0xfff));
 #else
@@ -628,14 +803,17 @@ addwritelookup(uint32_t virt, uint32_t phys)
 #endif
 
 	if ((phys & ~0xfff) >= (1 << 30))
-		writelookup2[virt>>12] = (uintptr_t)&ram2[a - (1 << 30)];
+		lookup = (uintptr_t)&ram2[a - (1 << 30)];
 	else
-		writelookup2[virt>>12] = (uintptr_t)&ram[a];
-    }
+		lookup = (uintptr_t)&ram[a];
 
-    writelookupp[writelnext] = mmu_perm;
-    writelookup[writelnext++] = virt >> 12;
-    writelnext &= (cachesize - 1);
+	/* See addreadlookup(). */
+	if (lookup == (uintptr_t) LOOKUP_INV) return;
+
+	mmu_tlb_insert(&write_tlb, virt >> 12, mmu_tlb_flags(virt));
+	writelnum++;
+	writelookup2[virt>>12] = lookup;
+    }
 
     cycles -= 9;
 }
@@ -1739,6 +1917,37 @@ mem_write_phys(void *src, uint32_t addr, int transfer_size)
 }
 
 
+/* Resolve the start of a physical range for bus master transfers. If addr is
+   backed by memory, returns the host pointer and trims *len to the part of the
+   range that is contiguous in host memory from there; otherwise returns NULL
+   and trims *len to the end of the block, which has to go through the
+   mapping handlers. */
+uint8_t *
+mem_phys_span(uint32_t addr, uint32_t *len)
+{
+    uint32_t blk = addr >> MEM_GRANULARITY_BITS;
+    uint32_t n = MEM_GRANULARITY_SIZE - (addr & MEM_GRANULARITY_MASK);
+    uint8_t *p;
+
+    mem_logical_addr = 0xffffffff;
+
+    if (_mem_exec[blk] == NULL) {
+	if (n < *len)
+		*len = n;
+	return NULL;
+    }
+
+    p = &(_mem_exec[blk][addr & MEM_GRANULARITY_MASK]);
+
+    while ((n < *len) && (++blk < MEM_MAPPINGS_NO) && (_mem_exec[blk] == (p + n)))
+	n += MEM_GRANULARITY_SIZE;
+
+    if (n < *len)
+	*len = n;
+    return p;
+}
+
+
 uint8_t
 mem_read_ram(uint32_t addr, void *priv)
 {
@@ -2727,7 +2936,9 @@ mem_reset(void)
 	pages = (page_t *)malloc(m*sizeof(page_t));
     }
 
-    memset(page_lookup, 0x00, (1 << 20) * sizeof(page_t *));
+    /* Every page_lookup entry is in the write TLB, dropping those clears the
+       table without making all of it resident. */
+    mmu_tlb_flush(&write_tlb, 0);
 
     memset(pages, 0x00, pages_sz*sizeof(page_t));
 
@@ -2864,10 +3075,14 @@ mem_init(void)
     ram2 = NULL;
     pages = NULL;
 
-    /* Allocate the lookup tables. */
-    page_lookup = (page_t **)malloc((1<<20)*sizeof(page_t *));
-    readlookup2  = malloc((1<<20)*sizeof(uintptr_t));
-    writelookup2 = malloc((1<<20)*sizeof(uintptr_t));
+    /* Allocate the lookup tables. Empty entries are zero, so only the
+       parts that are actually used get backed by host memory. */
+    page_lookup = (page_t **)calloc(1<<20, sizeof(page_t *));
+    readlookup2  = calloc(1<<20, sizeof(uintptr_t));
+    writelookup2 = calloc(1<<20, sizeof(uintptr_t));
+
+    mmu_tlb_init(&read_tlb);
+    mmu_tlb_init(&write_tlb);
 }
 
 
@@ -1505,6 +1505,12 @@ pcnetAsyncTransmit(nic_t *dev)
 		
         int fLoopback = CSR_LOOP(dev);
 
+        /* Unless looping back, gather the frame straight into a slot of
+         * the transmit queue. If the queue is full, fall back to the loop
+         * buffer and let network_tx() have another go at queueing it. */
+        uint8_t *pTxSlot = fLoopback ? NULL : network_tx_slot();
+        uint8_t *pXmitBuf = pTxSlot ? pTxSlot : dev->abLoopBuf;
+
         /*
          * The typical case - a complete packet.
          */
@@ -1520,7 +1526,7 @@ pcnetAsyncTransmit(nic_t *dev)
 		 * zero length if it is not the last one in the chain. */
 		if (cb <= MAX_FRAME) {
 		    dev->xmit_pos = cb;
-		    dma_bm_read(PHYSADDR(dev, tmd.tmd0.tbadr), dev->abLoopBuf, cb, dev->transfer_size);
+		    dma_bm_read(PHYSADDR(dev, tmd.tmd0.tbadr), pXmitBuf, cb, dev->transfer_size);
 
 		    if (fLoopback) {
 			if (HOST_IS_OWNER(CSR_CRST(dev)))
@@ -1529,7 +1535,10 @@ pcnetAsyncTransmit(nic_t *dev)
 			pcnetReceiveNoSync(dev, dev->abLoopBuf, dev->xmit_pos);		    
 		    } else {
 			pcnetlog(3, "%s: pcnetAsyncTransmit: transmit loopbuf stp and enp, xmit pos = %d\n", dev->name, dev->xmit_pos);
-			network_tx(dev->abLoopBuf, dev->xmit_pos);		        
+			if (pTxSlot)
+			    network_tx_commit(dev->xmit_pos);
+			else
+			    network_tx(dev->abLoopBuf, dev->xmit_pos);
 		    }
 		} else if (cb == 4096) {
 		    /* The Windows NT4 pcnet driver sometimes marks the first
@@ -1586,7 +1595,7 @@ pcnetAsyncTransmit(nic_t *dev)
              */
             unsigned cb = 4096 - tmd.tmd1.bcnt;
 	    dev->xmit_pos = pcnetCalcPacketLen(dev, cb);
-	    dma_bm_read(PHYSADDR(dev, tmd.tmd0.tbadr), dev->abLoopBuf, cb, dev->transfer_size);
+	    dma_bm_read(PHYSADDR(dev, tmd.tmd0.tbadr), pXmitBuf, cb, dev->transfer_size);
 
             for (;;) {
                 /*
@@ -1625,7 +1634,7 @@ pcnetAsyncTransmit(nic_t *dev)
                 if (dev->xmit_pos + cb <= MAX_FRAME) { /** @todo this used to be ... + cb < MAX_FRAME. */
 		    int off = dev->xmit_pos;
 		    dev->xmit_pos = cb + off;
-		    dma_bm_read(PHYSADDR(dev, tmd.tmd0.tbadr), dev->abLoopBuf + off, cb, dev->transfer_size);
+		    dma_bm_read(PHYSADDR(dev, tmd.tmd0.tbadr), pXmitBuf + off, cb, dev->transfer_size);
 		}
 
                 /*
@@ -1640,7 +1649,10 @@ pcnetAsyncTransmit(nic_t *dev)
 			pcnetReceiveNoSync(dev, dev->abLoopBuf, dev->xmit_pos);						
 		    } else {
 			pcnetlog(3, "%s: pcnetAsyncTransmit: transmit loopbuf enp\n", dev->name);
-			network_tx(dev->abLoopBuf, dev->xmit_pos);
+			if (pTxSlot)
+			    network_tx_commit(dev->xmit_pos);
+			else
+			    network_tx(dev->abLoopBuf, dev->xmit_pos);
 		    }
 					
                     /* Write back the TMD, pass it to the host */
@@ -112,8 +112,7 @@ static mutex_t		*network_mutex;
 static uint8_t		*network_mac;
 static uint8_t		network_timer_active = 0;
 static pc_timer_t	network_rx_queue_timer;
-static netpkt_t		*first_pkt[2] = { NULL, NULL },
-			*last_pkt[2] = { NULL, NULL };
+static netqueue_t	queues[2];	/* 0 = RX, 1 = TX */
 
 
 static struct {
@@ -183,6 +182,19 @@ network_dump_packet(netpkt_t *pkt)
 #endif
 
 
+/*
+ * Each queue has exactly one producer and one consumer (the poll
+ * thread and the emulation thread, one way or the other), so the
+ * slot contents only need to be visible before the index that
+ * publishes them is.
+ */
+#ifdef _MSC_VER
+# define network_queue_barrier()	_ReadWriteBarrier()
+#else
+# define network_queue_barrier()	__sync_synchronize()
+#endif
+
+
 void
 network_wait(uint8_t wait)
 {
@@ -267,71 +279,139 @@ network_init(void)
 }
 
 
+static void
+network_queue_init(int tx)
+{
+    netqueue_t *queue = &queues[tx];
+
+    if (queue->slots == NULL)
+	queue->slots = (netpkt_t *) malloc(NET_QUEUE_LEN * sizeof(netpkt_t));
+
+    queue->head = queue->tail = 0;
+    queue->depth_max = 0;
+    queue->drops = 0;
+}
+
+
+static void
+network_queue_close(int tx)
+{
+    netqueue_t *queue = &queues[tx];
+
+    network_log("NETWORK: %s queue: max depth %u, %u packets dropped\n",
+		tx ? "TX" : "RX", queue->depth_max, queue->drops);
+
+    if (queue->slots != NULL) {
+	free(queue->slots);
+	queue->slots = NULL;
+    }
+    queue->head = queue->tail = 0;
+}
+
+
+int
+network_queue_depth(int tx)
+{
+    return(queues[tx].head - queues[tx].tail);
+}
+
+
+uint32_t
+network_queue_drops(int tx)
+{
+    return(queues[tx].drops);
+}
+
+
+/*
+ * Get the next free slot of a queue for the producer to fill in,
+ * or NULL if the queue is full. Nothing is counted here, as the
+ * caller may still have another go at queueing the packet.
+ */
+netpkt_t *
+network_queue_slot(int tx)
+{
+    netqueue_t *queue = &queues[tx];
+
+    if ((queue->slots == NULL) || ((queue->head - queue->tail) >= NET_QUEUE_LEN))
+	return(NULL);
+
+    return(&queue->slots[queue->head & NET_QUEUE_MASK]);
+}
+
+
+/* Publish the slot returned by network_queue_slot() to the consumer. */
+void
+network_queue_commit(int tx, void *priv, int len)
+{
+    netqueue_t *queue = &queues[tx];
+    netpkt_t *pkt = &queue->slots[queue->head & NET_QUEUE_MASK];
+    uint32_t depth;
+
+    pkt->priv = priv;
+    pkt->len = len;
+
+    network_queue_barrier();
+    queue->head++;
+
+    depth = queue->head - queue->tail;
+    if (depth > queue->depth_max)
+	queue->depth_max = depth;
+}
+
+
 void
 network_queue_put(int tx, void *priv, uint8_t *data, int len)
 {
-    netpkt_t *temp;
+    netpkt_t *pkt;
 
-    temp = (netpkt_t *) malloc(sizeof(netpkt_t));
-    memset(temp, 0, sizeof(netpkt_t));
-    temp->priv = priv;
-    memcpy(temp->data, data, len);
-    temp->len = len;
-    temp->prev = last_pkt[tx];
-    temp->next = NULL;
+    if ((len < 0) || (len > (int) sizeof(pkt->data)))
+	return;
 
-    if (last_pkt[tx] != NULL)
-	last_pkt[tx]->next = temp;
-    last_pkt[tx] = temp;
+    pkt = network_queue_slot(tx);
+    if (pkt == NULL) {
+	/* This is where the packet is finally given up on. */
+	if (queues[tx].slots != NULL)
+		queues[tx].drops++;
+	return;
+    }
 
-    if (first_pkt[tx] == NULL)
-	first_pkt[tx] = temp;
+    memcpy(pkt->data, data, len);
+    network_queue_commit(tx, priv, len);
 }
 
 
 static void
 network_queue_get(int tx, netpkt_t **pkt)
 {
-    if (first_pkt[tx] == NULL)
+    netqueue_t *queue = &queues[tx];
+
+    if ((queue->slots == NULL) || (queue->head == queue->tail))
 	*pkt = NULL;
-    else
-	*pkt = first_pkt[tx];
+    else {
+	network_queue_barrier();
+	*pkt = &queue->slots[queue->tail & NET_QUEUE_MASK];
+    }
 }
 
 
 static void
 network_queue_advance(int tx)
 {
-    netpkt_t *temp;
-
-    temp = first_pkt[tx];
+    netqueue_t *queue = &queues[tx];
 
-    if (temp == NULL)
+    if (queue->head == queue->tail)
 	return;
 
-    first_pkt[tx] = temp->next;
-    free(temp);
-
-    if (first_pkt[tx] == NULL)
-	last_pkt[tx] = NULL;
+    network_queue_barrier();
+    queue->tail++;
 }
 
 
 static void
 network_queue_clear(int tx)
 {
-    netpkt_t *temp = first_pkt[tx], *temp2;
-
-    if (temp == NULL)
-	return;
-
-    do {
-	temp2 = temp->next;
-	free(temp);
-	temp = temp2;
-    } while (temp != NULL);
-
-    first_pkt[tx] = last_pkt[tx] = NULL;
+    queues[tx].tail = queues[tx].head;
 }
 
 
@@ -402,8 +482,8 @@ network_attach(void *dev, uint8_t *mac, NETRXCB rx, NETWAITCB wait, NETSETLINKST
 		break;
     }
 
-    first_pkt[0] = first_pkt[1] = NULL;
-    last_pkt[0] = last_pkt[1] = NULL;
+    network_queue_init(0);
+    network_queue_init(1);
     memset(&network_rx_queue_timer, 0x00, sizeof(pc_timer_t));
     timer_add(&network_rx_queue_timer, network_rx_queue, NULL, 0);
     /* 10 mbps. */
@@ -461,6 +541,8 @@ network_close(void)
     /* Here is where we clear the queues. */
     network_queue_clear(0);
     network_queue_clear(1);
+    network_queue_close(0);
+    network_queue_close(1);
 
     network_log("NETWORK: closed.\n");
 }
@@ -553,7 +635,41 @@ network_tx(uint8_t *bufp, int len)
 }
 
 
-/* Actually transmit the packet. */
+/*
+ * Get a transmit slot for a card to build a packet in directly, to
+ * be queued with network_tx_commit(). Returns NULL if the queue is
+ * full; the card then hands the packet to network_tx(), which counts
+ * it as dropped if there is still no room.
+ */
+uint8_t *
+network_tx_slot(void)
+{
+    netpkt_t *pkt = network_queue_slot(1);
+
+    if (pkt == NULL)
+	return(NULL);
+
+    return(pkt->data);
+}
+
+
+/* Queue the packet built in the slot returned by network_tx_slot(). */
+void
+network_tx_commit(int len)
+{
+    network_busy(1);
+
+    ui_sb_update_icon(SB_NETWORK, 1);
+
+    network_queue_commit(1, NULL, len);
+
+    ui_sb_update_icon(SB_NETWORK, 0);
+
+    network_busy(0);
+}
+
+
+/* Actually transmit the queued packets. */
 void
 network_do_tx(void)
 {
@@ -562,27 +678,32 @@ network_do_tx(void)
     if (network_tx_pause)
 	return;
 
-    network_queue_get(1, &pkt);
-    if ((pkt != NULL) && (pkt->len > 0)) {
-	network_dump_packet(pkt);
-	switch(network_type) {
-		case NET_TYPE_PCAP:
-			net_pcap_in(pkt->data, pkt->len);
-			break;
-
-		case NET_TYPE_SLIRP:
-			net_slirp_in(pkt->data, pkt->len);
-			break;
+    for (;;) {
+	network_queue_get(1, &pkt);
+	if (pkt == NULL)
+		break;
+
+	if (pkt->len > 0) {
+		network_dump_packet(pkt);
+		switch(network_type) {
+			case NET_TYPE_PCAP:
+				net_pcap_in(pkt->data, pkt->len);
+				break;
+
+			case NET_TYPE_SLIRP:
+				net_slirp_in(pkt->data, pkt->len);
+				break;
+		}
 	}
+	network_queue_advance(1);
     }
-    network_queue_advance(1);
 }
 
 
 int
 network_tx_queue_check(void)
 {
-    if ((first_pkt[1] == NULL) && (last_pkt[1] == NULL))
+    if (queues[1].head == queues[1].tail)
 	return 0;
 
     return 1;
@@ -64,6 +64,8 @@ int64_t		firsttime = 1;
 #define PIT_EXT_IO		32	/* The PIT has externally specified port I/O. */
 #define PIT_CUSTOM_CLOCK	64	/* The PIT uses custom clock inputs provided by another provider. */
 
+#define PIT_SKIP_MAX		0x10000	/* Maximum number of input clocks skipped at once. */
+
 
 enum {
     PIT_8253 = 0,
@@ -91,6 +93,9 @@ pit_log(const char *fmt, ...)
 #endif
 
 
+static void	pit_sync(pit_t *dev);
+
+
 static void
 ctr_set_out(ctr_t *ctr, int out)
 {
@@ -302,6 +307,111 @@ ctr_tick(ctr_t *ctr)
 }
 
 
+/* Returns how many of the upcoming input clocks would do nothing but decrement
+   the count (or nothing at all), so they can be applied in one go without any
+   visible change to OUT or the counter state. */
+static int
+ctr_get_plain_ticks(ctr_t *ctr)
+{
+    int first, ticks = PIT_SKIP_MAX;
+
+    if (!ctr->using_timer)
+	return PIT_SKIP_MAX;
+
+    if (ctr->latch || (ctr->state == 1))
+	return 0;
+
+    switch (ctr->m & 0x07) {
+	case 0:
+		if ((ctr->state == 0) || ((ctr->state == 2) && !ctr->gate))
+			return PIT_SKIP_MAX;
+		if (ctr->state == 2)
+			ticks = ctr->count - 1;
+		break;
+	case 1:
+		if (ctr->state == 2)
+			ticks = ctr->count - 1;
+		break;
+	case 2: case 6:
+		/* State 3 reloads the count and raises OUT on the next clock,
+		   whatever the gate is. */
+		if (ctr->state == 3)
+			return 0;
+		if ((ctr->state == 0) || !ctr->gate)
+			return PIT_SKIP_MAX;
+		ticks = ctr->count - 2;
+		break;
+	case 3: case 7:
+		if ((ctr->state == 0) || !ctr->gate)
+			return PIT_SKIP_MAX;
+		first = ctr->newcount ? ((ctr->state == 2) ? 1 : 3) : 2;
+		if (ctr->count < first)
+			return 0;
+		/* Mode 3 never counts in BCD here, so we are done. */
+		ticks = 1 + ((ctr->count - first) >> 1);
+		return (ticks > PIT_SKIP_MAX) ? PIT_SKIP_MAX : ticks;
+	case 4: case 5:
+		if (!ctr->gate && (ctr->m == 4))
+			return PIT_SKIP_MAX;
+		if (ctr->state == 2)
+			ticks = ctr->count - 1;
+		else if (ctr->state != 0)
+			return 0;
+		break;
+	default:
+		return PIT_SKIP_MAX;
+    }
+
+    /* BCD counting is rare enough to always go the slow way. */
+    if (ctr->ctrl & 0x01)
+	return 0;
+
+    if (ticks < 0)
+	ticks = 0;
+
+    return (ticks > PIT_SKIP_MAX) ? PIT_SKIP_MAX : ticks;
+}
+
+
+/* Applies ticks input clocks in one go, must be no more than what
+   ctr_get_plain_ticks() returned. */
+static void
+ctr_skip_ticks(ctr_t *ctr, int ticks)
+{
+    if (!ctr->using_timer || (ticks <= 0))
+	return;
+
+    switch (ctr->m & 0x07) {
+	case 0:
+		if ((ctr->state == 0) || ((ctr->state == 2) && !ctr->gate))
+			return;
+		break;
+	case 1:
+		if (ctr->state == 0)
+			return;
+		break;
+	case 2: case 6:
+		if ((ctr->state == 0) || !ctr->gate)
+			return;
+		break;
+	case 3: case 7:
+		if ((ctr->state == 0) || !ctr->gate)
+			return;
+		ctr->count -= (ctr->newcount ? ((ctr->state == 2) ? 1 : 3) : 2) + ((ticks - 1) << 1);
+		ctr->newcount = 0;
+		return;
+	case 4: case 5:
+		if (!ctr->gate && (ctr->m == 4))
+			return;
+		break;
+	default:
+		return;
+    }
+
+    ctr->count = (ctr->count - ticks) & 0xffff;
+}
+
+
 static void
 ctr_clock(ctr_t *ctr)
 {
@@ -426,7 +536,11 @@ pit_ctr_set_out_func(ctr_t *ctr, void (*func)(int new_out, int old_out))
 void
 pit_ctr_set_gate(ctr_t *ctr, int gate)
 {
-    int old = ctr->gate;
+    int old;
+
+    pit_sync(ctr->dev);
+
+    old = ctr->gate;
 
     ctr->gate = gate;
 
@@ -494,6 +608,8 @@ pit_ctr_set_clock_common(ctr_t *ctr, int clock)
 void
 pit_ctr_set_clock(ctr_t *ctr, int clock)
 {
+    pit_sync(ctr->dev);
+
     pit_ctr_set_clock_common(ctr, clock);
 }
 
@@ -502,23 +618,92 @@ void
 pit_ctr_set_using_timer(ctr_t *ctr, int using_timer)
 {
     timer_process();
+    pit_sync(ctr->dev);
 
     ctr->using_timer = using_timer;
 }
 
 
+/* Brings the counters up to date with the current TSC if we are in the middle
+   of a skipped run of input clocks, and goes back to clocking them one by one. */
+static void
+pit_sync(pit_t *dev)
+{
+    uint64_t half = PITCONST >> 1ULL, full = half << 1ULL;
+    uint64_t elapsed, rem;
+    int i, clocks, skip;
+
+    if ((dev == NULL) || !dev->skip)
+	return;
+
+    skip = dev->skip;
+
+    elapsed = (tsc << 32ULL) - dev->skip_ts;
+    if ((int64_t) elapsed < 0)
+	elapsed = 0ULL;
+
+    clocks = (int) (elapsed / full);
+    if (clocks > skip)
+	clocks = skip;
+    rem = elapsed - (clocks * full);
+
+    for (i = 0; i < 3; i++)
+	ctr_skip_ticks(&dev->counters[i], clocks);
+    dev->skip = 0;
+
+    timer_disable(&dev->callback_timer);
+    dev->callback_timer.ts.ts64 = dev->skip_ts + (clocks * full);
+
+    if ((clocks < skip) && (rem >= half)) {
+	/* The rising edge of the current clock has already happened. */
+	dev->clock = 1;
+	for (i = 0; i < 3; i++)
+		pit_ctr_set_clock_common(&dev->counters[i], dev->clock);
+	timer_advance_u64(&dev->callback_timer, full);
+    } else
+	timer_advance_u64(&dev->callback_timer, half);
+}
+
+
 static void
 pit_timer_over(void *p)
 {
     pit_t *dev = (pit_t *) p;
-    int i;
+    uint64_t half = PITCONST >> 1ULL;
+    int i, skip, ticks;
+
+    if (dev->skip) {
+	/* End of a skipped run, the counters end up exactly where the
+	   individual falling edges would have left them. */
+	for (i = 0; i < 3; i++)
+		ctr_skip_ticks(&dev->counters[i], dev->skip);
+	dev->skip = 0;
+    } else {
+	dev->clock ^= 1;
 
-    dev->clock ^= 1;
+	for (i = 0; i < 3; i++)
+		pit_ctr_set_clock_common(&dev->counters[i], dev->clock);
+    }
 
-    for (i = 0; i < 3; i++)
-	pit_ctr_set_clock_common(&dev->counters[i], dev->clock);
+    if (!dev->clock) {
+	/* Work out how long until the next input clock that actually does
+	   something visible, and skip straight to it. */
+	skip = PIT_SKIP_MAX;
+	for (i = 0; i < 3; i++) {
+		ticks = ctr_get_plain_ticks(&dev->counters[i]);
+		if (ticks < skip)
+			skip = ticks;
+	}
 
-    timer_advance_u64(&dev->callback_timer, PITCONST >> 1ULL);
+	if (skip > 1) {
+		dev->skip = skip;
+		dev->skip_ts = dev->callback_timer.ts.ts64;
+		timer_advance_u64(&dev->callback_timer, ((uint64_t) skip) * (half << 1ULL));
+		return;
+	}
+    }
+
+    timer_advance_u64(&dev->callback_timer, half);
 }
 
 
@@ -531,6 +716,8 @@ pit_write(uint16_t addr, uint8_t val, void *priv)
 
     pit_log("[%04X:%08X] pit_write(%04X, %02X, %08X)\n", CS, cpu_state.pc, addr, val, priv);
 
+    pit_sync(dev);
+
     switch (addr & 3) {
 	case 3:		/* control */
 		t = val >> 6;
@@ -638,6 +825,8 @@ pit_read(uint16_t addr, void *priv)
     int count, t = (addr & 3);
     ctr_t *ctr;
 
+    pit_sync(dev);
+
     switch (addr & 3) {
 	case 3:		/* Control. */
 		/* This is 8254-only, 8253 returns 0x00. */
@@ -813,8 +1002,10 @@ pit_reset(pit_t *dev)
 
     dev->clock = 0;
 
-    for (i = 0; i < 3; i++)
+    for (i = 0; i < 3; i++) {
 	ctr_reset(&dev->counters[i]);
+	dev->counters[i].dev = dev;
+    }
 
     /* Disable speaker gate. */
     dev->counters[2].gate = 0;
@@ -959,6 +1150,10 @@ pit_ps2_init(void)
 void
 pit_set_clock(int clock)
 {
+    /* Any skipped run was timed with the old PIT constant. */
+    pit_sync(pit);
+    pit_sync(pit2);
+
     /* Set default CPU/crystal clock and xt_cpu_multi. */
     if (cpu_s->cpu_type >= CPU_286) {
 	int remainder = (clock % 100000000);
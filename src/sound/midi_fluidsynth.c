@@ -21,8 +21,9 @@
 #define FLUID_CHORUS_DEFAULT_DEPTH	8.0f
 #define FLUID_CHORUS_DEFAULT_TYPE	FLUID_CHORUS_MOD_SINE
 
-#define RENDER_RATE 100
-#define BUFFER_SEGMENTS 10
+/* One segment per sound buffer, midi_poll() is called once per buffer. */
+#define RENDER_RATE (48000 / SOUNDBUFLEN)
+#define BUFFER_SEGMENTS 5
 
 
 enum fluid_chorus_mod {
@@ -120,8 +121,8 @@ int fluidsynth_available(void)
 void fluidsynth_poll(void)
 {
         fluidsynth_t* data = &fsdev;
-        data->midi_pos++;
-        if (data->midi_pos == 48000/RENDER_RATE)
+        data->midi_pos += SOUNDBUFLEN;
+        if (data->midi_pos >= 48000/RENDER_RATE)
         {
                 data->midi_pos = 0;
                 thread_set_event(data->event);
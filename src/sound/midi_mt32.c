@@ -85,8 +85,9 @@ static event_t *event = NULL;
 static event_t *start_event = NULL;
 static int mt32_on = 0;
 
-#define RENDER_RATE 100
-#define BUFFER_SEGMENTS 10
+/* One segment per sound buffer, midi_poll() is called once per buffer. */
+#define RENDER_RATE (48000 / SOUNDBUFLEN)
+#define BUFFER_SEGMENTS 5
 
 static uint32_t samplerate = 44100;
 static int buf_size = 0;
@@ -106,8 +107,8 @@ void mt32_stream_int16(int16_t* stream, int len)
 
 void mt32_poll()
 {
-        midi_pos++;
-        if (midi_pos == 48000/RENDER_RATE)
+        midi_pos += SOUNDBUFLEN;
+        if (midi_pos >= 48000/RENDER_RATE)
         {
                 midi_pos = 0;
                 thread_set_event(event);
@@ -514,7 +514,7 @@ uint8_t adgold_read(uint16_t addr, void *p)
 
 void adgold_update(adgold_t *adgold)
 {
-        for (; adgold->pos < sound_pos_global; adgold->pos++)
+        for (; adgold->pos < sound_get_pos_global(); adgold->pos++)
         {
                 adgold->mma_buffer[0][adgold->pos] = adgold->mma_buffer[1][adgold->pos] = 0;
         
@@ -1187,7 +1187,7 @@ static void es1371_update(es1371_t *es1371)
         else if (r > 32767)
                 r = 32767;
 
-        for (; es1371->pos < sound_pos_global; es1371->pos++)
+        for (; es1371->pos < sound_get_pos_global(); es1371->pos++)
         {                                        
                 es1371->buffer[es1371->pos*2]     = l;
                 es1371->buffer[es1371->pos*2 + 1] = r;
@@ -37,7 +37,7 @@ typedef struct cms_t
 
 void cms_update(cms_t *cms)
 {
-        for (; cms->pos < sound_pos_global; cms->pos++)
+        for (; cms->pos < sound_get_pos_global(); cms->pos++)
         {
                 int c, d;
                 int16_t out_l = 0, out_r = 0;
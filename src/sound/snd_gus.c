@@ -894,7 +894,7 @@ void gus_poll_timer_2(void *p)
 
 static void gus_update(gus_t *gus)
 {
-        for (; gus->pos < sound_pos_global; gus->pos++)
+        for (; gus->pos < sound_get_pos_global(); gus->pos++)
         {
                 if (gus->out_l < -32768)
                         gus->buffer[0][gus->pos] = -32768;
@@ -257,14 +257,14 @@ opl2_init(opl_t *dev)
 void
 opl2_update(opl_t *dev)
 {
-    if (dev->pos >= sound_pos_global)
+    if (dev->pos >= sound_get_pos_global())
 	return;
 
     nuked_generate_stream(dev->opl,
 			  &dev->buffer[dev->pos * 2],
-			  sound_pos_global - dev->pos);
+			  sound_get_pos_global() - dev->pos);
 
-    for (; dev->pos < sound_pos_global; dev->pos++) {
+    for (; dev->pos < sound_get_pos_global(); dev->pos++) {
 	dev->buffer[dev->pos * 2] /= 2;
 	dev->buffer[(dev->pos * 2) + 1] = dev->buffer[dev->pos * 2];
     }
@@ -307,14 +307,14 @@ opl3_init(opl_t *dev)
 void
 opl3_update(opl_t *dev)
 {
-    if (dev->pos >= sound_pos_global)
+    if (dev->pos >= sound_get_pos_global())
 	return;
 
     nuked_generate_stream(dev->opl,
 			  &dev->buffer[dev->pos * 2],
-			  sound_pos_global - dev->pos);
+			  sound_get_pos_global() - dev->pos);
 
-    for (; dev->pos < sound_pos_global; dev->pos++) {
+    for (; dev->pos < sound_get_pos_global(); dev->pos++) {
 	dev->buffer[dev->pos * 2] /= 2;
 	dev->buffer[(dev->pos * 2) + 1] /= 2;
     }
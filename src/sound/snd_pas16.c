@@ -694,7 +694,7 @@ static void pas16_update(pas16_t *pas16)
 {
         if (!(pas16->audiofilt & PAS16_FILT_MUTE))
         {
-                for (; pas16->pos < sound_pos_global; pas16->pos++)
+                for (; pas16->pos < sound_get_pos_global(); pas16->pos++)
                 {
                         pas16->pcm_buffer[0][pas16->pos] = 0;
                         pas16->pcm_buffer[1][pas16->pos] = 0;
@@ -702,7 +702,7 @@ static void pas16_update(pas16_t *pas16)
         }
         else
         {
-                for (; pas16->pos < sound_pos_global; pas16->pos++)
+                for (; pas16->pos < sound_get_pos_global(); pas16->pos++)
                 {
                         pas16->pcm_buffer[0][pas16->pos] = (int16_t)pas16->pcm_dat_l;
                         pas16->pcm_buffer[1][pas16->pos] = (int16_t)pas16->pcm_dat_r;
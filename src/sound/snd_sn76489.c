@@ -24,7 +24,7 @@ static float volslog[16]=
 
 void sn76489_update(sn76489_t *sn76489)
 {
-        for (; sn76489->pos < sound_pos_global; sn76489->pos++)
+        for (; sn76489->pos < sound_get_pos_global(); sn76489->pos++)
         {
                 int c;
                 int16_t result = 0;
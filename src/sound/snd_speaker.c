@@ -59,8 +59,8 @@ speaker_update(void)
     if (amplitude > 5120.0)
 	amplitude = 5120.0;
 
-    if (speaker_pos < sound_pos_global) {
-	for (; speaker_pos < sound_pos_global; speaker_pos++) {
+    if (speaker_pos < sound_get_pos_global()) {
+	for (; speaker_pos < sound_get_pos_global(); speaker_pos++) {
 		if (speaker_gated && was_speaker_enable) {
 			if ((speaker_mode == 0) || (speaker_mode == 4))
 				val = (int32_t) amplitude;
@@ -21,11 +21,11 @@ typedef struct ssi2001_t
 
 static void ssi2001_update(ssi2001_t *ssi2001)
 {
-        if (ssi2001->pos >= sound_pos_global)
+        if (ssi2001->pos >= sound_get_pos_global())
                 return;
         
-        sid_fillbuf(&ssi2001->buffer[ssi2001->pos], sound_pos_global - ssi2001->pos, ssi2001->psid);
-        ssi2001->pos = sound_pos_global;
+        sid_fillbuf(&ssi2001->buffer[ssi2001->pos], sound_get_pos_global() - ssi2001->pos, ssi2001->psid);
+        ssi2001->pos = sound_get_pos_global();
 }
 
 static void ssi2001_get_buffer(int32_t *buffer, int len, void *p)
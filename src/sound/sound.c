@@ -23,8 +23,13 @@
 #include <string.h>
 #include <stdlib.h>
 #include <wchar.h>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+# include <emmintrin.h>
+# define SOUND_USE_SSE2
+#endif
 #define HAVE_STDARG_H
 #include <86box/86box.h>
+#include "cpu.h"
 #include <86box/device.h>
 #include <86box/timer.h>
 #include <86box/cdrom.h>
@@ -52,7 +57,6 @@ typedef struct {
 
 
 int sound_card_current = 0;
-int sound_pos_global = 0;
 int sound_gain = 0;
 
 
@@ -66,7 +70,10 @@ static float *outbuffer_ex;
 static int16_t *outbuffer_ex_int16;
 static int sound_handlers_num;
 static pc_timer_t sound_poll_timer;
-static uint64_t sound_poll_latch;
+static uint64_t sound_poll_latch;	/* One sample period. */
+static uint64_t sound_block_ts;		/* Timestamp of the start of the current buffer. */
+static uint64_t sound_pos_tsc;
+static int sound_pos_cached, sound_mixing;
 
 static int16_t cd_buffer[CDROM_NUM][CD_BUFLEN * 2];
 static float cd_out_buffer[CD_BUFLEN * 2];
@@ -387,57 +394,133 @@ sound_set_cd_audio_filter(void (*filter)(int channel, double *buffer, void *p),
 }
 
 
-void
-sound_poll(void *priv)
+/* Returns the position within the current buffer, in samples. This used to
+   be a counter bumped by a 48 kHz timer, it is now worked out from the TSC
+   when a source actually asks for it. */
+int
+sound_get_pos_global(void)
 {
-    timer_advance_u64(&sound_poll_timer, sound_poll_latch);
+    uint64_t elapsed;
 
-    midi_poll();
+    if (sound_mixing)
+	return SOUNDBUFLEN;
 
-    sound_pos_global++;
-    if (sound_pos_global == SOUNDBUFLEN) {
-	int c;
+    if (tsc == sound_pos_tsc)
+	return sound_pos_cached;
 
-	memset(outbuffer, 0, SOUNDBUFLEN * 2 * sizeof(int32_t));
+    sound_pos_tsc = tsc;
 
-	for (c = 0; c < sound_handlers_num; c++)
-		sound_handlers[c].get_buffer(outbuffer, SOUNDBUFLEN, sound_handlers[c].priv);
+    elapsed = (tsc << 32ULL) - sound_block_ts;
+    if (((int64_t) elapsed < 0) || !sound_poll_latch)
+	sound_pos_cached = 0;
+    else if (elapsed >= (sound_poll_latch * SOUNDBUFLEN))
+	sound_pos_cached = SOUNDBUFLEN;
+    else
+	sound_pos_cached = (int) (elapsed / sound_poll_latch);
+
+    return sound_pos_cached;
+}
 
-	for (c = 0; c < SOUNDBUFLEN * 2; c++) {
-		if (sound_is_float)
-			outbuffer_ex[c] = ((float) outbuffer[c]) / 32768.0;
-		else {
-			if (outbuffer[c] > 32767)
-				outbuffer[c] = 32767;
-			if (outbuffer[c] < -32768)
-				outbuffer[c] = -32768;
 
-			outbuffer_ex_int16[c] = outbuffer[c];
-		}
+static void
+sound_convert_buffer(void)
+{
+    int c = 0;
+#ifdef SOUND_USE_SSE2
+    __m128i a, b;
+    __m128 scale = _mm_set1_ps(1.0f / 32768.0f);
+
+    if (sound_is_float) {
+	for (; c <= (SOUNDBUFLEN * 2) - 4; c += 4) {
+		a = _mm_loadu_si128((__m128i *) &outbuffer[c]);
+		_mm_storeu_ps(&outbuffer_ex[c], _mm_mul_ps(_mm_cvtepi32_ps(a), scale));
 	}
+    } else {
+	/* packs clamps to -32768..32767 for us. */
+	for (; c <= (SOUNDBUFLEN * 2) - 8; c += 8) {
+		a = _mm_loadu_si128((__m128i *) &outbuffer[c]);
+		b = _mm_loadu_si128((__m128i *) &outbuffer[c + 4]);
+		_mm_storeu_si128((__m128i *) &outbuffer_ex_int16[c], _mm_packs_epi32(a, b));
+	}
+    }
+#endif
 
+    for (; c < SOUNDBUFLEN * 2; c++) {
 	if (sound_is_float)
-		givealbuffer(outbuffer_ex);
-	else
-		givealbuffer(outbuffer_ex_int16);
-
-	if (cd_thread_enable) {
-                cd_buf_update--;
-       	        if (!cd_buf_update) {
-       	                cd_buf_update = (48000 / SOUNDBUFLEN) / (CD_FREQ / CD_BUFLEN);
-               	        thread_set_event(sound_cd_event);
-                }
+		outbuffer_ex[c] = ((float) outbuffer[c]) / 32768.0;
+	else {
+		if (outbuffer[c] > 32767)
+			outbuffer[c] = 32767;
+		if (outbuffer[c] < -32768)
+			outbuffer[c] = -32768;
+
+		outbuffer_ex_int16[c] = outbuffer[c];
 	}
+    }
+}
 
-	sound_pos_global = 0;
+
+/* Called once per buffer period, mixes the whole buffer in one go. */
+void
+sound_poll(void *priv)
+{
+    int c;
+
+    sound_mixing = 1;
+
+    midi_poll();
+
+    memset(outbuffer, 0, SOUNDBUFLEN * 2 * sizeof(int32_t));
+
+    for (c = 0; c < sound_handlers_num; c++)
+	sound_handlers[c].get_buffer(outbuffer, SOUNDBUFLEN, sound_handlers[c].priv);
+
+    sound_convert_buffer();
+
+    if (sound_is_float)
+	givealbuffer(outbuffer_ex);
+    else
+	givealbuffer(outbuffer_ex_int16);
+
+    if (cd_thread_enable) {
+	cd_buf_update--;
+	if (!cd_buf_update) {
+		cd_buf_update = (48000 / SOUNDBUFLEN) / (CD_FREQ / CD_BUFLEN);
+		thread_set_event(sound_cd_event);
+	}
     }
+
+    sound_mixing = 0;
+
+    /* The next buffer starts where this one ended. */
+    sound_block_ts = sound_poll_timer.ts.ts64;
+    sound_pos_tsc = (uint64_t) -1;
+    timer_advance_u64(&sound_poll_timer, sound_poll_latch * SOUNDBUFLEN);
 }
 
 
 void
 sound_speed_changed(void)
 {
-    sound_poll_latch = (uint64_t)((double)TIMER_USEC * (1000000.0 / 48000.0));
+    uint64_t new_latch = (uint64_t)((double)TIMER_USEC * (1000000.0 / 48000.0));
+    int pos;
+
+    if (timer_is_enabled(&sound_poll_timer)) {
+	/* Keep the current position, and time the rest of the buffer with
+	   the new sample period. */
+	pos = sound_get_pos_global();
+	sound_poll_latch = new_latch;
+	sound_block_ts = (tsc << 32ULL) - (pos * sound_poll_latch);
+	sound_pos_tsc = (uint64_t) -1;
+	timer_disable(&sound_poll_timer);
+	sound_poll_timer.ts.ts64 = sound_block_ts;
+	timer_advance_u64(&sound_poll_timer, sound_poll_latch * SOUNDBUFLEN);
+    } else {
+	sound_poll_latch = new_latch;
+	sound_block_ts = (tsc << 32ULL);
+	sound_pos_tsc = (uint64_t) -1;
+	timer_set_delay_u64(&sound_poll_timer, sound_poll_latch * SOUNDBUFLEN);
+    }
 }
 
 
@@ -450,7 +533,9 @@ sound_reset(void)
     midi_in_device_init();
     inital();
 
-    timer_add(&sound_poll_timer, sound_poll, NULL, 1);
+    /* Started by sound_speed_changed(), once the sample period is known. */
+    timer_add(&sound_poll_timer, sound_poll, NULL, 0);
+    sound_mixing = 0;
 
     sound_handlers_num = 0;
     memset(sound_handlers, 0x00, 8 * sizeof(sound_handler_t));
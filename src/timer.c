@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 #include <wchar.h>
 #include <86box/86box.h>
@@ -10,28 +11,38 @@ uint64_t TIMER_USEC;
 uint32_t timer_target;
 
 /*Enabled timers are stored in a linked list, with the first timer to expire at
-  the head.*/
+  the head. Walking the list to insert is the cheapest option for the few dozen
+  timers a machine normally has, but it is O(n), so once more than
+  timer_heap_min timers are enabled the list is turned into a binary min-heap
+  instead. It goes back to being a list when fewer than half that many are
+  left. Either way timer_head points to the first timer to expire.*/
 pc_timer_t *timer_head = NULL;
 
+int timer_heap_min = TIMER_HEAP_MIN;
+
+static pc_timer_t **timer_heap = NULL;
+static int timer_count = 0, timer_heap_size = 0, timer_use_heap = 0;
+/*Every enable gets the next sequence number. Timers enabled before the last
+  timer_close() have one below timer_epoch.*/
+static uint64_t timer_seq = 0, timer_epoch = 0;
+
 /* Are we initialized? */
 int timer_inited = 0;
 
 
-void
-timer_enable(pc_timer_t *timer)
+/*Returns whether the timer is really enabled - timers in structures that
+  outlived a timer_close() may still have stale flags and links.*/
+static __inline int
+timer_is_live(pc_timer_t *timer)
 {
-    pc_timer_t *timer_node = timer_head;
-
-    if (!timer_inited || (timer == NULL))
-	return;
-
-    if (timer->flags & TIMER_ENABLED)
-	timer_disable(timer);
+    return (timer->flags & TIMER_ENABLED) && (timer->seq >= timer_epoch);
+}
 
-    if (timer->next || timer->prev)
-	fatal("timer_enable - timer->next\n");
 
-    timer->flags |= TIMER_ENABLED;
+static void
+timer_list_insert(pc_timer_t *timer)
+{
+    pc_timer_t *timer_node = timer_head;
 
     /*List currently empty - add to head*/
     if (!timer_head) {
@@ -41,8 +52,6 @@ timer_enable(pc_timer_t *timer)
 	return;
     }
 
-    timer_node = timer_head;
-
     while(1) {
 	/*Timer expires before timer_node. Add to list in front of timer_node*/
 	if (TIMER_LESS_THAN(timer, timer_node)) {
@@ -62,6 +71,7 @@ timer_enable(pc_timer_t *timer)
 	if (!timer_node->next) {
 		timer_node->next = timer;
 		timer->prev = timer_node;
+		timer->next = NULL;
 		return;
 	}
 
@@ -70,24 +80,233 @@ timer_enable(pc_timer_t *timer)
 }
 
 
+static void
+timer_list_remove(pc_timer_t *timer)
+{
+    if (timer->prev)
+	timer->prev->next = timer->next;
+    else
+	timer_head = timer->next;
+    if (timer->next)
+	timer->next->prev = timer->prev;
+    timer->prev = timer->next = NULL;
+}
+
+
+static __inline void
+timer_heap_set(int idx, pc_timer_t *timer)
+{
+    timer_heap[idx] = timer;
+    timer->heap_idx = idx;
+}
+
+
+/*Returns whether timer a expires before timer b. The list puts a newly enabled
+  timer in front of any timers with the same timestamp, so equal timestamps are
+  ordered by enable sequence, most recent first.*/
+static __inline int
+timer_heap_before(pc_timer_t *a, pc_timer_t *b)
+{
+    if (a->ts.ts64 != b->ts.ts64)
+	return TIMER_LESS_THAN(a, b);
+
+    return a->seq > b->seq;
+}
+
+
+static void
+timer_heap_sift_up(int idx)
+{
+    pc_timer_t *timer = timer_heap[idx];
+    int parent;
+
+    while (idx > 0) {
+	parent = (idx - 1) >> 1;
+	/*Timer expires before its parent, swap them.*/
+	if (!timer_heap_before(timer, timer_heap[parent]))
+		break;
+	timer_heap_set(idx, timer_heap[parent]);
+	idx = parent;
+    }
+
+    timer_heap_set(idx, timer);
+}
+
+
+static void
+timer_heap_sift_down(int idx)
+{
+    pc_timer_t *timer = timer_heap[idx];
+    int child;
+
+    while (1) {
+	child = (idx << 1) + 1;
+	if (child >= timer_count)
+		break;
+	if (((child + 1) < timer_count) &&
+	    timer_heap_before(timer_heap[child + 1], timer_heap[child]))
+		child++;
+	if (!timer_heap_before(timer_heap[child], timer))
+		break;
+	timer_heap_set(idx, timer_heap[child]);
+	idx = child;
+    }
+
+    timer_heap_set(idx, timer);
+}
+
+
+/*Takes the timer at idx out of the heap. timer_count must already have been
+  decremented, so the last timer is at timer_heap[timer_count].*/
+static void
+timer_heap_remove(int idx)
+{
+    timer_heap[idx]->heap_idx = -1;
+
+    if (idx != timer_count) {
+	timer_heap_set(idx, timer_heap[timer_count]);
+	timer_heap_sift_up(idx);
+	timer_heap_sift_down(timer_heap[idx]->heap_idx);
+    }
+    timer_heap[timer_count] = NULL;
+}
+
+
+/*The list is already in heap order, so it can be copied over as it is.*/
+static void
+timer_list_to_heap(void)
+{
+    pc_timer_t *timer = timer_head, *next;
+    int idx = 0;
+
+    if (timer_count > timer_heap_size) {
+	timer_heap_size = (timer_count + 63) & ~63;
+	timer_heap = (pc_timer_t **) realloc(timer_heap, timer_heap_size * sizeof(pc_timer_t *));
+	if (timer_heap == NULL)
+		fatal("timer_list_to_heap - out of memory\n");
+    }
+
+    while (timer != NULL) {
+	next = timer->next;
+	timer->prev = timer->next = NULL;
+	timer_heap_set(idx++, timer);
+	timer = next;
+    }
+
+    timer_use_heap = 1;
+}
+
+
+static void
+timer_heap_to_list(void)
+{
+    pc_timer_t *timer, *tail = NULL;
+    int count = timer_count;
+
+    timer_head = NULL;
+
+    while (timer_count) {
+	timer = timer_heap[0];
+	timer_count--;
+	timer_heap_remove(0);
+
+	timer->prev = tail;
+	timer->next = NULL;
+	if (tail)
+		tail->next = timer;
+	else
+		timer_head = timer;
+	tail = timer;
+    }
+
+    timer_count = count;
+    timer_use_heap = 0;
+}
+
+
+static void
+timer_update_head(void)
+{
+    if (timer_use_heap)
+	timer_head = timer_count ? timer_heap[0] : NULL;
+
+    if (timer_head)
+	timer_target = timer_head->ts.ts32.integer;
+}
+
+
+void
+timer_enable(pc_timer_t *timer)
+{
+    if (!timer_inited || (timer == NULL))
+	return;
+
+    if (timer_is_live(timer)) {
+	timer->seq = timer_seq++;
+
+	if (timer_use_heap) {
+		/*Already enabled, just move it to where its new timestamp belongs.*/
+		timer_heap_sift_up(timer->heap_idx);
+		timer_heap_sift_down(timer->heap_idx);
+	} else {
+		timer_list_remove(timer);
+		timer_list_insert(timer);
+	}
+
+	timer_update_head();
+	return;
+    }
+
+    timer->seq = timer_seq++;
+    timer->flags |= TIMER_ENABLED;
+
+    if (!timer_use_heap) {
+	timer_list_insert(timer);
+	if (++timer_count > timer_heap_min) {
+		timer_list_to_heap();
+		timer_update_head();
+	}
+	return;
+    }
+
+    if (timer_count == timer_heap_size) {
+	timer_heap_size = timer_heap_size ? (timer_heap_size << 1) : 64;
+	timer_heap = (pc_timer_t **) realloc(timer_heap, timer_heap_size * sizeof(pc_timer_t *));
+	if (timer_heap == NULL)
+		fatal("timer_enable - out of memory\n");
+    }
+
+    timer_heap_set(timer_count++, timer);
+    timer_heap_sift_up(timer->heap_idx);
+
+    timer_update_head();
+}
+
+
 void
 timer_disable(pc_timer_t *timer)
 {
     if (!timer_inited || (timer == NULL) || !(timer->flags & TIMER_ENABLED))
 	return;
 
-    if (!timer->next && !timer->prev && timer != timer_head)
-	fatal("timer_disable - !timer->next\n");
+    if (!timer_is_live(timer)) {
+	timer->flags &= ~TIMER_ENABLED;
+	timer->prev = timer->next = NULL;
+	timer->heap_idx = -1;
+	return;
+    }
 
     timer->flags &= ~TIMER_ENABLED;
+    timer_count--;
 
-    if (timer->prev)
-	timer->prev->next = timer->next;
-    else
-	timer_head = timer->next;
-    if (timer->next)
-	timer->next->prev = timer->prev;
-    timer->prev = timer->next = NULL;
+    if (timer_use_heap) {
+	timer_heap_remove(timer->heap_idx);
+	if (timer_count < (timer_heap_min >> 1))
+		timer_heap_to_list();
+    } else
+	timer_list_remove(timer);
+
+    timer_update_head();
 }
 
 
@@ -96,19 +315,21 @@ timer_remove_head(void)
 {
     pc_timer_t *timer;
 
-    if (!timer_inited)
+    if (!timer_inited || !timer_head)
 	return;
 
-    if (timer_head) {
-	timer = timer_head;
-	timer_head = timer->next;
-	if (timer_head) {
-		timer_head->prev = NULL;
-		timer->next->prev = NULL;
-	}
-	timer->next = timer->prev = NULL;
-	timer->flags &= ~TIMER_ENABLED;
+    if (timer_use_heap) {
+	timer_disable(timer_head);
+	return;
     }
+
+    timer = timer_head;
+    timer_head = timer->next;
+    if (timer_head)
+	timer_head->prev = NULL;
+    timer->next = NULL;
+    timer->flags &= ~TIMER_ENABLED;
+    timer_count--;
 }
 
 
@@ -141,16 +362,14 @@ timer_process(void)
 void
 timer_close(void)
 {
-    pc_timer_t *t = timer_head, *r;
-
-    /* Set all timers' prev and next to NULL so it is assured that
-       timers that are not in malloc'd structs don't keep pointing
-       to timers that may be in malloc'd structs. */
-    while (t != NULL) {
-	r = t;
-	r->prev = r->next = NULL;
-	t = r->next;
-    }
+    /* Just forget about the enabled timers, they may be in malloc'd
+       structs that have already been freed. Timers that are not get
+       their stale state caught by timer_is_live(). */
+    if (timer_heap != NULL)
+	memset(timer_heap, 0x00, timer_heap_size * sizeof(pc_timer_t *));
+    timer_count = 0;
+    timer_use_heap = 0;
+    timer_epoch = timer_seq;
 
     timer_head = NULL;
 
@@ -177,6 +396,7 @@ timer_add(pc_timer_t *timer, void (*callback)(void *p), void *p, int start_timer
     timer->p = p;
     timer->flags = 0;
     timer->prev = timer->next = NULL;
+    timer->heap_idx = -1;
     if (start_timer)
 	timer_set_delay_u64(timer, 0);
 }
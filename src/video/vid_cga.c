@@ -203,7 +203,6 @@ cga_poll(void *p)
 	if (cga->cgadispon) {
 		if (cga->displine < cga->firstline) {
 			cga->firstline = cga->displine;
-			video_wait_for_buffer();
 		}
 		cga->lastline = cga->displine;
 		for (c = 0; c < 8; c++) {
@@ -824,6 +824,7 @@ gd54xx_out(uint16_t addr, uint8_t val, void *p)
 					svga->vgapal[index].g = svga->dac_g;
 					svga->vgapal[index].b = val; 
 					svga->pallook[index] = makecol32(video_6to8[svga->vgapal[index].r & 0x3f], video_6to8[svga->vgapal[index].g & 0x3f], video_6to8[svga->vgapal[index].b & 0x3f]);
+					svga->render_gen++;
 				}
 				svga->dac_addr = (svga->dac_addr + 1) & 255;
 				svga->dac_pos = 0; 
@@ -3172,6 +3173,82 @@ gd54xx_transparent_comp(gd54xx_t *gd54xx, uint32_t xx, uint8_t src)
 }
 
 
+/* Fast path for the common pattern fills: no transparency, no left skip and
+   a ROP that does not depend on the destination. Each line of the 8x8 pattern
+   is expanded once and then replicated along the row. Returns 0 if the blit
+   has to go through the generic path. */
+static int
+gd54xx_pattern_copy_fast(gd54xx_t *gd54xx, svga_t *svga)
+{
+    uint8_t line[32], *dst;
+    int x, y, xx, pattern_y, pattern_pitch;
+    int pw = gd54xx->blt.pixel_width;
+    uint32_t bitmask, period, len, n, srca, srca2, dsta;
+
+    if ((gd54xx->blt.mode & CIRRUS_BLTMODE_TRANSPARENTCOMP) || gd54xx->blt.pattern_x)
+	return 0;
+
+    switch (gd54xx->blt.rop) {
+	case 0x00: case 0x0d: case 0x0e:
+		break;
+	case 0x06:	/* Destination unchanged. */
+		return 1;
+	default:
+		return 0;
+    }
+
+    pattern_pitch = pw << 3;
+    if (pw == 3)
+	pattern_pitch = 32;
+    if (gd54xx->blt.mode & CIRRUS_BLTMODE_COLOREXPAND)
+	pattern_pitch = 1;
+
+    /* The generic path writes whole pixels, so round the row up the same way. */
+    period = pw << 3;
+    len = ((gd54xx->blt.width / pw) + 1) * pw;
+
+    dsta = gd54xx->blt.dst_addr & svga->vram_mask;
+    pattern_y = gd54xx->blt.src_addr & 0x07;
+    srca = (gd54xx->blt.src_addr & ~0x07) & svga->vram_mask;
+
+    for (y = 0; y <= gd54xx->blt.height; y++) {
+	srca2 = srca + (pattern_y * pattern_pitch);
+
+	if (gd54xx->blt.rop != 0x0d)
+		memset(line, (gd54xx->blt.rop == 0x0e) ? 0xff : 0x00, period);
+	else for (x = 0; x < 8; x++) {
+		for (xx = 0; xx < pw; xx++) {
+			if (gd54xx->blt.mode & CIRRUS_BLTMODE_COLOREXPAND) {
+				if (gd54xx->blt.modeext & CIRRUS_BLTMODEEXT_SOLIDFILL)
+					bitmask = 1;
+				else
+					bitmask = svga->vram[srca2 & svga->vram_mask] & (0x80 >> x);
+				line[(x * pw) + xx] = gd54xx_color_expand(gd54xx, bitmask, xx);
+			} else
+				line[(x * pw) + xx] = svga->vram[(srca2 + (x * pw) + xx) & svga->vram_mask];
+		}
+	}
+
+	if ((dsta + len) > (svga->vram_mask + 1)) {
+		for (n = 0; n < len; n++)
+			svga->vram[(dsta + n) & svga->vram_mask] = line[n % period];
+	} else {
+		/* Seed the row with one pattern line, then keep doubling it. */
+		dst = &svga->vram[dsta];
+		memcpy(dst, line, MIN(len, period));
+		for (n = period; n < len; n <<= 1)
+			memcpy(dst + n, dst, MIN(n, len - n));
+	}
+	svga_mark_changed(svga, dsta, len);
+
+	pattern_y = (pattern_y + 1) & 7;
+	dsta = (dsta + gd54xx->blt.dst_pitch) & svga->vram_mask;
+    }
+
+    return 1;
+}
+
+
 static void
 gd54xx_pattern_copy(gd54xx_t *gd54xx)
 {
@@ -3181,6 +3258,9 @@ gd54xx_pattern_copy(gd54xx_t *gd54xx)
     uint32_t srca, srca2, dsta;
     svga_t *svga = &gd54xx->svga;
 
+    if (gd54xx_pattern_copy_fast(gd54xx, svga))
+	return;
+
     pattern_pitch = gd54xx->blt.pixel_width << 3;
 
     if (gd54xx->blt.pixel_width == 3)
@@ -3338,6 +3418,74 @@ gd54xx_mem_sys_src(gd54xx_t *gd54xx, uint32_t cpu_dat, uint32_t count)
 }
 
 
+/* Fast path for plain screen to screen copies and solid ROPs, done a row at a
+   time. Rows that wrap around VRAM, or whose source and destination overlap
+   in a way memmove() would not reproduce, are still copied byte by byte in
+   the blit direction. Returns 0 if the blit has to go through the generic
+   path. */
+static int
+gd54xx_normal_blit_fast(gd54xx_t *gd54xx, svga_t *svga)
+{
+    uint32_t src_addr = gd54xx->blt.src_addr & svga->vram_mask;
+    uint32_t dst_addr = gd54xx->blt.dst_addr & svga->vram_mask;
+    uint32_t len = gd54xx->blt.width + 1;
+    uint32_t src, dst, x;
+    uint8_t fill = 0x00;
+    int y, slow;
+
+    if (gd54xx->blt.mode & (CIRRUS_BLTMODE_COLOREXPAND | CIRRUS_BLTMODE_TRANSPARENTCOMP))
+	return 0;
+
+    switch (gd54xx->blt.rop) {
+	case 0x00: case 0x0d:
+		break;
+	case 0x0e:
+		fill = 0xff;
+		break;
+	case 0x06:	/* Destination unchanged. */
+		return 1;
+	default:
+		return 0;
+    }
+
+    for (y = 0; y <= gd54xx->blt.height; y++) {
+	/* Backwards blits start each row at its highest address. */
+	if (gd54xx->blt.dir < 0) {
+		src = (src_addr - gd54xx->blt.width) & svga->vram_mask;
+		dst = (dst_addr - gd54xx->blt.width) & svga->vram_mask;
+	} else {
+		src = src_addr;
+		dst = dst_addr;
+	}
+
+	slow = (dst + len) > (svga->vram_mask + 1);
+	if (gd54xx->blt.rop == 0x0d) {
+		slow |= (src + len) > (svga->vram_mask + 1);
+		if (gd54xx->blt.dir < 0)
+			slow |= (dst < src) && ((dst + len) > src);
+		else
+			slow |= (dst > src) && (dst < (src + len));
+	}
+
+	if (slow) {
+		for (x = 0; x < len; x++) {
+			svga->vram[(dst_addr + (x * gd54xx->blt.dir)) & svga->vram_mask] =
+				(gd54xx->blt.rop == 0x0d) ? svga->vram[(src_addr + (x * gd54xx->blt.dir)) & svga->vram_mask] : fill;
+		}
+	} else if (gd54xx->blt.rop == 0x0d)
+		memmove(&svga->vram[dst], &svga->vram[src], len);
+	else
+		memset(&svga->vram[dst], fill, len);
+	svga_mark_changed(svga, dst, len);
+
+	src_addr = (src_addr + (gd54xx->blt.src_pitch * gd54xx->blt.dir)) & svga->vram_mask;
+	dst_addr = (dst_addr + (gd54xx->blt.dst_pitch * gd54xx->blt.dir)) & svga->vram_mask;
+    }
+
+    return 1;
+}
+
+
 static void
 gd54xx_normal_blit(uint32_t count, gd54xx_t *gd54xx, svga_t *svga)
 {
@@ -3355,6 +3503,11 @@ gd54xx_normal_blit(uint32_t count, gd54xx_t *gd54xx, svga_t *svga)
     gd54xx->blt.x_count = 0;
     gd54xx->blt.y_count = 0;
 
+    if ((count == 0xffffffff) && gd54xx_normal_blit_fast(gd54xx, svga)) {
+	gd54xx_reset_blit(gd54xx);
+	return;
+    }
+
     while (count) {
 	src = 0;
 	mask = 0;
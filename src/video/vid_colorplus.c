@@ -169,7 +169,6 @@ void colorplus_poll(void *p)
                         if (colorplus->cga.displine < colorplus->cga.firstline)
                         {
                                 colorplus->cga.firstline = colorplus->cga.displine;
-                                video_wait_for_buffer();
                         }
                         colorplus->cga.lastline = colorplus->cga.displine;
 			/* Left / right border */
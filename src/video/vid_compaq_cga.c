@@ -120,7 +120,6 @@ compaq_cga_poll(void *p)
 	if (self->cga.cgadispon) {
 		if (self->cga.displine < self->cga.firstline) {
 			self->cga.firstline = self->cga.displine;
-			video_wait_for_buffer();
 			compaq_cga_log("Firstline %i\n", firstline);
 		}
 		self->cga.lastline = self->cga.displine;
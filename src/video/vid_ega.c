@@ -469,7 +469,6 @@ ega_poll(void *p)
 		ega->ma &= ega->vrammask;
 		if (ega->firstline == 2000) {
 			ega->firstline = ega->displine;
-			video_wait_for_buffer();
 		}
 
 		if (ega->vres) {
@@ -624,9 +624,6 @@ genius_poll(void *p)
 		else
 			background = genius_pal[0];
 
-		if (genius->displine == 0)
-			video_wait_for_buffer();
-
 		/* Start off with a blank line */
 		for (x = 0; x < GENIUS_XSIZE; x++)
 			buffer32->line[genius->displine][x] = background;
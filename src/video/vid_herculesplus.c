@@ -503,7 +503,6 @@ herculesplus_poll(void *priv)
 	if (dev->dispon) {
 		if (dev->displine < dev->firstline) {
 			dev->firstline = dev->displine;
-			video_wait_for_buffer();
 		}
 		dev->lastline = dev->displine;
 		if ((dev->ctrl & HERCULESPLUS_CTRL_GRAPH) && (dev->ctrl2 & HERCULESPLUS_CTRL2_GRAPH))
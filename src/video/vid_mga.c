@@ -3594,6 +3594,73 @@ blit_autoline(mystique_t *mystique, int closed)
 }
 
 
+/* Bytes per pixel for the MACCESS pixel width, 0 if it is not known. */
+static int
+blit_pixel_size(mystique_t *mystique)
+{
+    switch (mystique->maccess_running & MACCESS_PWIDTH_MASK) {
+	case MACCESS_PWIDTH_8:
+		return 1;
+	case MACCESS_PWIDTH_16:
+		return 2;
+	case MACCESS_PWIDTH_24:
+		return 3;
+	case MACCESS_PWIDTH_32:
+		return 4;
+    }
+
+    return 0;
+}
+
+
+/* Draw one BLK/RPL trapezoid span with no transparency mask. A row of the 8x8
+   pattern is expanded once and then replicated along the span. Returns 0 if
+   the span has to be drawn a pixel at a time. */
+static int
+blit_trap_fill_span(mystique_t *mystique, int16_t x_l, int16_t x_r, int yoff)
+{
+    svga_t *svga = &mystique->svga;
+    uint8_t line[32], *dst;
+    uint32_t col, addr = 0, len = 0, period, n;
+    int bpp = blit_pixel_size(mystique);
+    int l, r, x, i;
+
+    if (!bpp || (x_l > x_r))
+	return 0;
+
+    l = MAX(x_l, mystique->dwgreg.cxleft);
+    r = MIN(x_r - 1, mystique->dwgreg.cxright);
+
+    if ((l <= r) && mystique->dwgreg.ydst_lin >= mystique->dwgreg.ytop && mystique->dwgreg.ydst_lin <= mystique->dwgreg.ybot) {
+	addr = ((mystique->dwgreg.ydst_lin + l) * bpp) & mystique->vram_mask;
+	len = (r - l + 1) * bpp;
+	if ((addr + len) > (mystique->vram_mask + 1))
+		return 0;
+    }
+
+    if (len) {
+	period = bpp << 3;
+	for (x = 0; x < 8; x++) {
+		col = mystique->dwgreg.pattern[yoff][(mystique->dwgreg.xoff + l + x) & 7] ? mystique->dwgreg.fcol : mystique->dwgreg.bcol;
+		for (i = 0; i < bpp; i++)
+			line[(x * bpp) + i] = col >> (i << 3);
+	}
+
+	/* Seed the span with one pattern row, then keep doubling it. */
+	dst = &svga->vram[addr];
+	memcpy(dst, line, MIN(len, period));
+	for (n = period; n < len; n <<= 1)
+		memcpy(dst + n, dst, MIN(n, len - n));
+
+	svga_mark_changed(svga, addr, len);
+    }
+
+    mystique->pixel_count += x_r - x_l;
+
+    return 1;
+}
+
+
 static void
 blit_trap(mystique_t *mystique)
 {
@@ -3614,6 +3681,9 @@ blit_trap(mystique_t *mystique)
 			int16_t x_r = mystique->dwgreg.fxright & 0xffff;
 			int yoff = (mystique->dwgreg.yoff + mystique->dwgreg.ydst) & 7;
 
+			if ((trans_sel == 0) && blit_trap_fill_span(mystique, x_l, x_r, yoff))
+				x_l = x_r;
+
 			while (x_l != x_r) {
 				if (x_l >= mystique->dwgreg.cxleft && x_l <= mystique->dwgreg.cxright &&
 				    mystique->dwgreg.ydst_lin >= mystique->dwgreg.ytop && mystique->dwgreg.ydst_lin <= mystique->dwgreg.ybot &&
@@ -4135,12 +4205,59 @@ skip_pixel:
 }
 
 
+/* Copy one row of a plain screen to screen blit, for the case where the source
+   row ends exactly on the last pixel of the destination row. Returns 0 if the
+   row has to be copied a pixel at a time, before touching any state. */
+static int
+blit_bitblt_copy_row(mystique_t *mystique, int16_t x_start, int16_t x_end, int x_dir, uint32_t *src_addr)
+{
+    svga_t *svga = &mystique->svga;
+    uint32_t src_lo, src = 0, dst = 0, len = 0;
+    int bpp = blit_pixel_size(mystique);
+    int n, x_lo, l, r;
+
+    n = ((x_end - x_start) * x_dir) + 1;
+    if (!bpp || (n <= 0) || ((*src_addr + ((n - 1) * x_dir)) != mystique->dwgreg.ar[0]))
+	return 0;
+
+    x_lo = (x_dir > 0) ? x_start : x_end;
+    src_lo = (x_dir > 0) ? *src_addr : mystique->dwgreg.ar[0];
+
+    l = MAX(x_lo, mystique->dwgreg.cxleft);
+    r = MIN(x_lo + n - 1, mystique->dwgreg.cxright);
+
+    if ((l <= r) && mystique->dwgreg.ydst_lin >= mystique->dwgreg.ytop && mystique->dwgreg.ydst_lin <= mystique->dwgreg.ybot) {
+	dst = ((mystique->dwgreg.ydst_lin + l) * bpp) & mystique->vram_mask;
+	src = ((src_lo + (l - x_lo)) * bpp) & mystique->vram_mask;
+	len = (r - l + 1) * bpp;
+
+	if (((dst + len) > (mystique->vram_mask + 1)) || ((src + len) > (mystique->vram_mask + 1)))
+		return 0;
+
+	/* An overlapping copy in the scan direction smears, which memmove() would not reproduce. */
+	if ((x_dir > 0) ? ((dst > src) && (dst < (src + len))) : ((dst < src) && ((dst + len) > src)))
+		return 0;
+    }
+
+    if (len) {
+	memmove(&svga->vram[dst], &svga->vram[src], len);
+	svga_mark_changed(svga, dst, len);
+    }
+
+    mystique->dwgreg.ar[0] += mystique->dwgreg.ar[5];
+    mystique->dwgreg.ar[3] += mystique->dwgreg.ar[5];
+    *src_addr = mystique->dwgreg.ar[3];
+
+    return 1;
+}
+
+
 static void
 blit_bitblt(mystique_t *mystique)
 {
     svga_t *svga = &mystique->svga;
     uint32_t src_addr;
-    int y;
+    int y, copy;
     int x_dir = mystique->dwgreg.sgn.scanleft ? -1 : 1;
     int16_t x_start = mystique->dwgreg.sgn.scanleft ? mystique->dwgreg.fxright : mystique->dwgreg.fxleft;
     int16_t x_end = mystique->dwgreg.sgn.scanleft ? mystique->dwgreg.fxleft : mystique->dwgreg.fxright;
@@ -4341,14 +4458,17 @@ blit_bitblt(mystique_t *mystique)
 
 			case DWGCTRL_BLTMOD_BFCOL:
 			case DWGCTRL_BLTMOD_BU32RGB:
+				copy = ((mystique->dwgreg.dwgctrl_running & DWGCTRL_BOP_MASK) == BOP(0xc)) &&
+				       !(mystique->dwgreg.dwgctrl_running & DWGCTRL_PATTERN) && (trans_sel == 0);
 				src_addr = mystique->dwgreg.ar[3];
 
 				for (y = 0; y < mystique->dwgreg.length; y++) {
 					uint8_t const * const trans = &trans_masks[trans_sel][(mystique->dwgreg.selline & 3) * 4];
 					uint32_t old_src_addr = src_addr;
 					int16_t x = x_start;
+					int done = copy && blit_bitblt_copy_row(mystique, x_start, x_end, x_dir, &src_addr);
 
-					while (1) {
+					while (!done) {
 						if (x >= mystique->dwgreg.cxleft && x <= mystique->dwgreg.cxright &&
 						    mystique->dwgreg.ydst_lin >= mystique->dwgreg.ytop && mystique->dwgreg.ydst_lin <= mystique->dwgreg.ybot &&
 						    trans[x & 3]) {
@@ -223,7 +223,6 @@ ogc_poll(void *priv)
 			if (ogc->cga.cgadispon) {
 				if (ogc->cga.displine < ogc->cga.firstline) {
 					ogc->cga.firstline = ogc->cga.displine;
-					video_wait_for_buffer();
 				}
 				ogc->cga.lastline = ogc->cga.displine;
 				/* 80-col */
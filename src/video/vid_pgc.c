@@ -2453,9 +2453,6 @@ pgc_cga_poll(pgc_t *dev)
 	dev->linepos = 1;
 
 	if (dev->cgadispon) {
-		if (dev->displine == 0)
-			video_wait_for_buffer();
-
 		if ((dev->mapram[0x03d8] & 0x12) == 0x12)
 			pgc_cga_gfx80(dev);	
 		else if (dev->mapram[0x03d8] & 0x02)
@@ -2536,9 +2533,6 @@ pgc_poll(void *priv)
 	dev->mapram[0x3da] |= 1;
 	dev->linepos = 1;
 	if (dev->cgadispon && (uint32_t)dev->displine < dev->maxh) {
-		if (dev->displine == 0)
-			video_wait_for_buffer();
-
 		/* Don't know why pan needs to be multiplied by -2, but
 		 * the IM1024 driver uses PAN -112 for an offset of 
 		 * 224. */
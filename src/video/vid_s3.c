@@ -4335,6 +4335,166 @@ s3_visionx68_video_engine_op(uint32_t cpu_dat, s3_t *s3)
 	}
 }
 
+/* Write n pixels starting at pixel address dest, either copied left to right
+   from pixel address src or, if fill is set, all set to col. Runs that wrap
+   around VRAM, or whose source overlaps them in a way memmove() would not
+   reproduce, are done a pixel at a time like the generic path. */
+static void
+s3_accel_span(s3_t *s3, uint32_t dest, uint32_t src, int n, int fill, uint32_t col)
+{
+	svga_t *svga = &s3->svga;
+	uint16_t *vram_w = (uint16_t *)svga->vram;
+	uint32_t *vram_l = (uint32_t *)svga->vram;
+	int shift = (s3->bpp == 0) ? 0 : ((s3->bpp == 1) ? 1 : 2);
+	uint32_t mask = s3->vram_mask >> shift;
+	uint32_t dat;
+	int x;
+
+	dest &= mask;
+	src &= mask;
+
+	if (((dest + n) > (mask + 1)) ||
+	    (!fill && (((src + n) > (mask + 1)) || ((dest > src) && (dest < (src + n)))))) {
+		for (x = 0; x < n; x++) {
+			if (fill)
+				dat = col;
+			else {
+				READ(src + x, dat);
+			}
+			WRITE(dest + x, dat);
+		}
+		return;
+	}
+
+	if (!fill)
+		memmove(&svga->vram[dest << shift], &svga->vram[src << shift], n << shift);
+	else if (s3->bpp == 0)
+		memset(&svga->vram[dest], col, n);
+	else if (s3->bpp == 1) {
+		for (x = 0; x < n; x++)
+			vram_w[dest + x] = col;
+	} else {
+		for (x = 0; x < n; x++)
+			vram_l[dest + x] = col;
+	}
+
+	svga_mark_changed(svga, dest << shift, n << shift);
+}
+
+
+static uint32_t
+s3_accel_pix_mask(s3_t *s3)
+{
+	if (s3->bpp == 0)
+		return 0xff;
+	else if (s3->bpp == 1)
+		return 0xffff;
+
+	return 0xffffffff;
+}
+
+
+/* Rectangle fill with a constant source and a mix that does not read the
+   destination, done a row at a time. Returns 0 if the fill has to go through
+   the generic path. */
+static int
+s3_accel_fill_fast(s3_t *s3, uint32_t dstbase, int clip_t, int clip_l, int clip_b, int clip_r,
+		   int compare_mode, uint32_t compare)
+{
+	uint32_t src_dat, dest_dat = 0, pix_mask = s3_accel_pix_mask(s3);
+	int w = s3->accel.maj_axis_pcnt & 0xfff;
+	int x_l, l, r, y, write;
+
+	if ((s3->accel.wrt_mask & pix_mask) != pix_mask)
+		return 0;
+
+	switch ((s3->accel.frgd_mix >> 5) & 3)
+	{
+		case 0: src_dat = s3->accel.bkgd_color; break;
+		case 1: src_dat = s3->accel.frgd_color; break;
+		case 3: src_dat = 0; break;
+		default: return 0;
+	}
+
+	write = (compare_mode == 2 && src_dat != compare) ||
+		(compare_mode == 3 && src_dat == compare) ||
+		 compare_mode < 2;
+
+	switch (s3->accel.frgd_mix & 0xf)
+	{
+		case 0x1: dest_dat =  0;	break;
+		case 0x2: dest_dat = ~0;	break;
+		case 0x3: write = 0;		break;
+		case 0x4: dest_dat = ~src_dat;	break;
+		case 0x7: dest_dat =  src_dat;	break;
+		default: return 0;
+	}
+
+	/* The clip test is done on 12-bit coordinates, so only rows that do
+	   not wrap can be clipped as a single span. */
+	x_l = (s3->accel.cmd & 0x20) ? s3->accel.cx : (s3->accel.cx - w);
+	if ((x_l < 0) || ((x_l + w) > 0xfff))
+		return 0;
+
+	l = MAX(x_l, clip_l);
+	r = MIN(x_l + w, clip_r);
+
+	for (y = 0; y <= s3->accel.sy; y++) {
+		if (write && (l <= r) &&
+		    (s3->accel.cy & 0xfff) >= clip_t && (s3->accel.cy & 0xfff) <= clip_b)
+			s3_accel_span(s3, dstbase + (s3->accel.cy * s3->width) + l, 0, r - l + 1, 1, dest_dat);
+
+		if (s3->accel.cmd & 0x80) s3->accel.cy++;
+		else		     s3->accel.cy--;
+	}
+
+	s3->accel.sx = w;
+	s3->accel.sy = -1;
+	s3->accel.dest = dstbase + s3->accel.cy * s3->width;
+	s3->accel.cur_x = s3->accel.cx;
+	s3->accel.cur_y = s3->accel.cy;
+
+	return 1;
+}
+
+
+/* Left to right, top to bottom screen to screen copy, done a row at a time.
+   Returns 0 if the blit has to go through the generic path. */
+static int
+s3_accel_blit_fast(s3_t *s3, uint32_t srcbase, uint32_t dstbase, int clip_t, int clip_l, int clip_b, int clip_r)
+{
+	uint32_t pix_mask = s3_accel_pix_mask(s3);
+	int w = s3->accel.maj_axis_pcnt & 0xfff;
+	int l, r, y;
+
+	if ((s3->accel.wrt_mask & pix_mask) != pix_mask)
+		return 0;
+
+	if ((s3->accel.dx < 0) || ((s3->accel.dx + w) > 0xfff))
+		return 0;
+
+	l = MAX(s3->accel.dx, clip_l);
+	r = MIN(s3->accel.dx + w, clip_r);
+
+	for (y = 0; y <= s3->accel.sy; y++) {
+		if ((l <= r) && (s3->accel.dy & 0xfff) >= clip_t && (s3->accel.dy & 0xfff) <= clip_b)
+			s3_accel_span(s3, s3->accel.dest + l, s3->accel.src + s3->accel.cx + (l - s3->accel.dx),
+				      r - l + 1, 0, 0);
+
+		s3->accel.cy++;
+		s3->accel.dy++;
+
+		s3->accel.src  = srcbase + s3->accel.cy * s3->width;
+		s3->accel.dest = dstbase + s3->accel.dy * s3->width;
+	}
+
+	s3->accel.sx = w;
+	s3->accel.sy = -1;
+
+	return 1;
+}
+
+
 void
 s3_accel_start(int count, int cpu_input, uint32_t mix_dat, uint32_t cpu_dat, s3_t *s3)
 {
@@ -4631,6 +4791,10 @@ s3_accel_start(int count, int cpu_input, uint32_t mix_dat, uint32_t cpu_dat, s3_
 		s3->accel.pix_trans[2] = 0xff;
 		s3->accel.pix_trans[3] = 0xff;
 
+		if (!cpu_input && !s3_cpu_src(s3) && !s3_cpu_dest(s3) && (mix_dat == 0xffffffff) &&
+		    s3_accel_fill_fast(s3, dstbase, clip_t, clip_l, clip_b, clip_r, compare_mode, compare))
+			return;
+
 		if (s3->accel.b2e8_pix && count == 16) { /*Stupid undocumented 0xB2E8 on 911/924*/
 			count <<= 8;
 			s3->accel.temp_cnt = 16;
@@ -4883,6 +5047,9 @@ s3_accel_start(int count, int cpu_input, uint32_t mix_dat, uint32_t cpu_dat, s3_
 		    (s3->accel.cmd & 0xa0) == 0xa0 && (s3->accel.frgd_mix & 0xf) == 7 &&
 			(s3->accel.bkgd_mix & 0xf) == 7)
 		{
+			if (s3_accel_blit_fast(s3, srcbase, dstbase, clip_t, clip_l, clip_b, clip_r))
+				return;
+
 			while (1)
 			{
 				if (((s3->accel.dx & 0xfff) >= clip_l && (s3->accel.dx & 0xfff) <= clip_r &&
@@ -2215,6 +2215,8 @@ typedef struct s3d_state_t
         int y;
         
         rgba_t dest_rgba;
+
+        void (*tex_sample)(struct s3d_state_t *state);
 } s3d_state_t;
 
 typedef struct s3d_texture_state_t
@@ -2225,16 +2227,22 @@ typedef struct s3d_texture_state_t
         int32_t u, v;
 } s3d_texture_state_t;
 
-static void (*tex_read)(s3d_state_t *state, s3d_texture_state_t *texture_state, rgba_t *out);
-static void (*tex_sample)(s3d_state_t *state);
-static void (*dest_pixel)(s3d_state_t *state);
+typedef void (*s3d_tex_read_t)(s3d_state_t *state, s3d_texture_state_t *texture_state, rgba_t *out);
+
+/*The span loop is large enough that compilers won't inline it into each of its
+  specialisations unless made to*/
+#ifdef _MSC_VER
+#define S3D_INLINE __forceinline
+#else
+#define S3D_INLINE __inline __attribute__((always_inline))
+#endif
 
 #define MAX(a, b) ((a) > (b) ? (a) : (b))
 #define MIN(a, b) ((a) < (b) ? (a) : (b))
 
 static int _x, _y;
 
-static void tex_ARGB1555(s3d_state_t *state, s3d_texture_state_t *texture_state, rgba_t *out)
+static __inline void tex_ARGB1555(s3d_state_t *state, s3d_texture_state_t *texture_state, rgba_t *out)
 {
         int offset = ((texture_state->u & 0x7fc0000) >> texture_state->texture_shift) +
                      (((texture_state->v & 0x7fc0000) >> texture_state->texture_shift) << texture_state->level);
@@ -2246,7 +2254,7 @@ static void tex_ARGB1555(s3d_state_t *state, s3d_texture_state_t *texture_state,
         out->a = (val & 0x8000) ? 0xff : 0;
 }
 
-static void tex_ARGB1555_nowrap(s3d_state_t *state, s3d_texture_state_t *texture_state, rgba_t *out)
+static __inline void tex_ARGB1555_nowrap(s3d_state_t *state, s3d_texture_state_t *texture_state, rgba_t *out)
 {
         int offset = ((texture_state->u & 0x7fc0000) >> texture_state->texture_shift) +
                      (((texture_state->v & 0x7fc0000) >> texture_state->texture_shift) << texture_state->level);
@@ -2261,7 +2269,7 @@ static void tex_ARGB1555_nowrap(s3d_state_t *state, s3d_texture_state_t *texture
         out->a = (val & 0x8000) ? 0xff : 0;
 }
 
-static void tex_ARGB4444(s3d_state_t *state, s3d_texture_state_t *texture_state, rgba_t *out)
+static __inline void tex_ARGB4444(s3d_state_t *state, s3d_texture_state_t *texture_state, rgba_t *out)
 {
         int offset = ((texture_state->u & 0x7fc0000) >> texture_state->texture_shift) +
                      (((texture_state->v & 0x7fc0000) >> texture_state->texture_shift) << texture_state->level);
@@ -2273,7 +2281,7 @@ static void tex_ARGB4444(s3d_state_t *state, s3d_texture_state_t *texture_state,
         out->a = ((val & 0xf000) >> 8) | ((val & 0xf000) >> 12);
 }
 
-static void tex_ARGB4444_nowrap(s3d_state_t *state, s3d_texture_state_t *texture_state, rgba_t *out)
+static __inline void tex_ARGB4444_nowrap(s3d_state_t *state, s3d_texture_state_t *texture_state, rgba_t *out)
 {
         int offset = ((texture_state->u & 0x7fc0000) >> texture_state->texture_shift) +
                      (((texture_state->v & 0x7fc0000) >> texture_state->texture_shift) << texture_state->level);
@@ -2288,7 +2296,7 @@ static void tex_ARGB4444_nowrap(s3d_state_t *state, s3d_texture_state_t *texture
         out->a = ((val & 0xf000) >> 8) | ((val & 0xf000) >> 12);
 }
 
-static void tex_ARGB8888(s3d_state_t *state, s3d_texture_state_t *texture_state, rgba_t *out)
+static __inline void tex_ARGB8888(s3d_state_t *state, s3d_texture_state_t *texture_state, rgba_t *out)
 {
         int offset = ((texture_state->u & 0x7fc0000) >> texture_state->texture_shift) +
                      (((texture_state->v & 0x7fc0000) >> texture_state->texture_shift) << texture_state->level);
@@ -2299,7 +2307,7 @@ static void tex_ARGB8888(s3d_state_t *state, s3d_texture_state_t *texture_state,
         out->b =  val        & 0xff;
         out->a = (val >> 24) & 0xff;
 }
-static void tex_ARGB8888_nowrap(s3d_state_t *state, s3d_texture_state_t *texture_state, rgba_t *out)
+static __inline void tex_ARGB8888_nowrap(s3d_state_t *state, s3d_texture_state_t *texture_state, rgba_t *out)
 {
         int offset = ((texture_state->u & 0x7fc0000) >> texture_state->texture_shift) +
                      (((texture_state->v & 0x7fc0000) >> texture_state->texture_shift) << texture_state->level);
@@ -2314,7 +2322,7 @@ static void tex_ARGB8888_nowrap(s3d_state_t *state, s3d_texture_state_t *texture
         out->a = (val >> 24) & 0xff;
 }
 
-static void tex_sample_normal(s3d_state_t *state)
+static __inline void tex_sample_normal(s3d_state_t *state, s3d_tex_read_t tex_read)
 {
         s3d_texture_state_t texture_state;
         
@@ -2326,7 +2334,7 @@ static void tex_sample_normal(s3d_state_t *state)
         tex_read(state, &texture_state, &state->dest_rgba);
 }
 
-static void tex_sample_normal_filter(s3d_state_t *state)
+static __inline void tex_sample_normal_filter(s3d_state_t *state, s3d_tex_read_t tex_read)
 {
         s3d_texture_state_t texture_state;
         int tex_offset;
@@ -2367,7 +2375,7 @@ static void tex_sample_normal_filter(s3d_state_t *state)
         state->dest_rgba.a = (tex_samples[0].a * d[0] + tex_samples[1].a * d[1] + tex_samples[2].a * d[2] + tex_samples[3].a * d[3]) >> 16;
 }
 
-static void tex_sample_mipmap(s3d_state_t *state)
+static __inline void tex_sample_mipmap(s3d_state_t *state, s3d_tex_read_t tex_read)
 {
         s3d_texture_state_t texture_state;
 
@@ -2381,7 +2389,7 @@ static void tex_sample_mipmap(s3d_state_t *state)
         tex_read(state, &texture_state, &state->dest_rgba);
 }
 
-static void tex_sample_mipmap_filter(s3d_state_t *state)
+static __inline void tex_sample_mipmap_filter(s3d_state_t *state, s3d_tex_read_t tex_read)
 {
         s3d_texture_state_t texture_state;
         int tex_offset;
@@ -2424,7 +2432,7 @@ static void tex_sample_mipmap_filter(s3d_state_t *state)
         state->dest_rgba.a = (tex_samples[0].a * d[0] + tex_samples[1].a * d[1] + tex_samples[2].a * d[2] + tex_samples[3].a * d[3]) >> 16;
 }
 
-static void tex_sample_persp_normal(s3d_state_t *state)
+static __inline void tex_sample_persp_normal(s3d_state_t *state, s3d_tex_read_t tex_read)
 {
         s3d_texture_state_t texture_state;
         int32_t w = 0;
@@ -2440,7 +2448,7 @@ static void tex_sample_persp_normal(s3d_state_t *state)
         tex_read(state, &texture_state, &state->dest_rgba);
 }
 
-static void tex_sample_persp_normal_filter(s3d_state_t *state)
+static __inline void tex_sample_persp_normal_filter(s3d_state_t *state, s3d_tex_read_t tex_read)
 {
         s3d_texture_state_t texture_state;
         int32_t w = 0, u, v;
@@ -2488,7 +2496,7 @@ static void tex_sample_persp_normal_filter(s3d_state_t *state)
         state->dest_rgba.a = (tex_samples[0].a * d[0] + tex_samples[1].a * d[1] + tex_samples[2].a * d[2] + tex_samples[3].a * d[3]) >> 16;
 }
 
-static void tex_sample_persp_normal_375(s3d_state_t *state)
+static __inline void tex_sample_persp_normal_375(s3d_state_t *state, s3d_tex_read_t tex_read)
 {
         s3d_texture_state_t texture_state;
         int32_t w = 0;
@@ -2504,7 +2512,7 @@ static void tex_sample_persp_normal_375(s3d_state_t *state)
         tex_read(state, &texture_state, &state->dest_rgba);
 }
 
-static void tex_sample_persp_normal_filter_375(s3d_state_t *state)
+static __inline void tex_sample_persp_normal_filter_375(s3d_state_t *state, s3d_tex_read_t tex_read)
 {
         s3d_texture_state_t texture_state;
         int32_t w = 0, u, v;
@@ -2553,7 +2561,7 @@ static void tex_sample_persp_normal_filter_375(s3d_state_t *state)
 }
 
 
-static void tex_sample_persp_mipmap(s3d_state_t *state)
+static __inline void tex_sample_persp_mipmap(s3d_state_t *state, s3d_tex_read_t tex_read)
 {
         s3d_texture_state_t texture_state;
         int32_t w = 0;
@@ -2571,7 +2579,7 @@ static void tex_sample_persp_mipmap(s3d_state_t *state)
         tex_read(state, &texture_state, &state->dest_rgba);
 }
 
-static void tex_sample_persp_mipmap_filter(s3d_state_t *state)
+static __inline void tex_sample_persp_mipmap_filter(s3d_state_t *state, s3d_tex_read_t tex_read)
 {
         s3d_texture_state_t texture_state;
         int32_t w = 0, u, v;
@@ -2621,7 +2629,7 @@ static void tex_sample_persp_mipmap_filter(s3d_state_t *state)
         state->dest_rgba.a = (tex_samples[0].a * d[0] + tex_samples[1].a * d[1] + tex_samples[2].a * d[2] + tex_samples[3].a * d[3]) >> 16;
 }
 
-static void tex_sample_persp_mipmap_375(s3d_state_t *state)
+static __inline void tex_sample_persp_mipmap_375(s3d_state_t *state, s3d_tex_read_t tex_read)
 {
         s3d_texture_state_t texture_state;
         int32_t w = 0;
@@ -2639,7 +2647,7 @@ static void tex_sample_persp_mipmap_375(s3d_state_t *state)
         tex_read(state, &texture_state, &state->dest_rgba);
 }
 
-static void tex_sample_persp_mipmap_filter_375(s3d_state_t *state)
+static __inline void tex_sample_persp_mipmap_filter_375(s3d_state_t *state, s3d_tex_read_t tex_read)
 {
         s3d_texture_state_t texture_state;
         int32_t w = 0, u, v;
@@ -2690,6 +2698,91 @@ static void tex_sample_persp_mipmap_filter_375(s3d_state_t *state)
 }
 
 
+/*Every sampler is instantiated once per texel reader, so that the reads and the
+  format conversion are inlined into the filter instead of being called through
+  a pointer for each of up to four texels per pixel.*/
+enum
+{
+        TEX_SAMPLE_NORMAL = 0,
+        TEX_SAMPLE_NORMAL_FILTER,
+        TEX_SAMPLE_MIPMAP,
+        TEX_SAMPLE_MIPMAP_FILTER,
+        TEX_SAMPLE_PERSP_NORMAL,
+        TEX_SAMPLE_PERSP_NORMAL_FILTER,
+        TEX_SAMPLE_PERSP_NORMAL_375,
+        TEX_SAMPLE_PERSP_NORMAL_FILTER_375,
+        TEX_SAMPLE_PERSP_MIPMAP,
+        TEX_SAMPLE_PERSP_MIPMAP_FILTER,
+        TEX_SAMPLE_PERSP_MIPMAP_375,
+        TEX_SAMPLE_PERSP_MIPMAP_FILTER_375,
+        TEX_SAMPLE_MAX
+};
+
+enum
+{
+        TEX_READ_ARGB8888 = 0,
+        TEX_READ_ARGB8888_NOWRAP,
+        TEX_READ_ARGB4444,
+        TEX_READ_ARGB4444_NOWRAP,
+        TEX_READ_ARGB1555,
+        TEX_READ_ARGB1555_NOWRAP,
+        TEX_READ_MAX
+};
+
+#define TEX_SAMPLER(sample, fmt)                                                        \
+        static void tex_sample_ ## sample ## _ ## fmt(s3d_state_t *state)               \
+        {                                                                               \
+                tex_sample_ ## sample(state, tex_ ## fmt);                              \
+        }
+
+#define TEX_SAMPLERS(fmt)                                       \
+        TEX_SAMPLER(normal, fmt)                                \
+        TEX_SAMPLER(normal_filter, fmt)                         \
+        TEX_SAMPLER(mipmap, fmt)                                \
+        TEX_SAMPLER(mipmap_filter, fmt)                         \
+        TEX_SAMPLER(persp_normal, fmt)                          \
+        TEX_SAMPLER(persp_normal_filter, fmt)                   \
+        TEX_SAMPLER(persp_normal_375, fmt)                      \
+        TEX_SAMPLER(persp_normal_filter_375, fmt)               \
+        TEX_SAMPLER(persp_mipmap, fmt)                          \
+        TEX_SAMPLER(persp_mipmap_filter, fmt)                   \
+        TEX_SAMPLER(persp_mipmap_375, fmt)                      \
+        TEX_SAMPLER(persp_mipmap_filter_375, fmt)
+
+#define TEX_SAMPLER_TABLE(fmt)                                  \
+        {                                                       \
+                tex_sample_normal_ ## fmt,                      \
+                tex_sample_normal_filter_ ## fmt,               \
+                tex_sample_mipmap_ ## fmt,                      \
+                tex_sample_mipmap_filter_ ## fmt,               \
+                tex_sample_persp_normal_ ## fmt,                \
+                tex_sample_persp_normal_filter_ ## fmt,         \
+                tex_sample_persp_normal_375_ ## fmt,            \
+                tex_sample_persp_normal_filter_375_ ## fmt,     \
+                tex_sample_persp_mipmap_ ## fmt,                \
+                tex_sample_persp_mipmap_filter_ ## fmt,         \
+                tex_sample_persp_mipmap_375_ ## fmt,            \
+                tex_sample_persp_mipmap_filter_375_ ## fmt      \
+        }
+
+TEX_SAMPLERS(ARGB8888)
+TEX_SAMPLERS(ARGB8888_nowrap)
+TEX_SAMPLERS(ARGB4444)
+TEX_SAMPLERS(ARGB4444_nowrap)
+TEX_SAMPLERS(ARGB1555)
+TEX_SAMPLERS(ARGB1555_nowrap)
+
+static void (*const tex_samplers[TEX_READ_MAX][TEX_SAMPLE_MAX])(s3d_state_t *state) =
+{
+        TEX_SAMPLER_TABLE(ARGB8888),
+        TEX_SAMPLER_TABLE(ARGB8888_nowrap),
+        TEX_SAMPLER_TABLE(ARGB4444),
+        TEX_SAMPLER_TABLE(ARGB4444_nowrap),
+        TEX_SAMPLER_TABLE(ARGB1555),
+        TEX_SAMPLER_TABLE(ARGB1555_nowrap)
+};
+
+
 #define CLAMP(x) do                                     \
         {                                               \
                 if ((x) & ~0xff)                        \
@@ -2724,7 +2817,7 @@ static void tex_sample_persp_mipmap_filter_375(s3d_state_t *state)
         }                               \
         while (0)
 
-static void dest_pixel_gouraud_shaded_triangle(s3d_state_t *state)
+static S3D_INLINE void dest_pixel_gouraud_shaded_triangle(s3d_state_t *state)
 {
         state->dest_rgba.r = state->r >> 7;
         CLAMP(state->dest_rgba.r);
@@ -2739,25 +2832,25 @@ static void dest_pixel_gouraud_shaded_triangle(s3d_state_t *state)
         CLAMP(state->dest_rgba.a);
 }
 
-static void dest_pixel_unlit_texture_triangle(s3d_state_t *state)
+static S3D_INLINE void dest_pixel_unlit_texture_triangle(s3d_state_t *state)
 {
-        tex_sample(state);
+        state->tex_sample(state);
 
         if (state->cmd_set & CMD_SET_ABC_SRC)
                 state->dest_rgba.a = state->a >> 7;
 }
 
-static void dest_pixel_lit_texture_decal(s3d_state_t *state)
+static S3D_INLINE void dest_pixel_lit_texture_decal(s3d_state_t *state)
 {
-        tex_sample(state);
+        state->tex_sample(state);
 
         if (state->cmd_set & CMD_SET_ABC_SRC)
                 state->dest_rgba.a = state->a >> 7;
 }
 
-static void dest_pixel_lit_texture_reflection(s3d_state_t *state)
+static S3D_INLINE void dest_pixel_lit_texture_reflection(s3d_state_t *state)
 {
-        tex_sample(state);
+        state->tex_sample(state);
 
         state->dest_rgba.r += (state->r >> 7);
         state->dest_rgba.g += (state->g >> 7);
@@ -2768,11 +2861,11 @@ static void dest_pixel_lit_texture_reflection(s3d_state_t *state)
         CLAMP_RGBA(state->dest_rgba.r, state->dest_rgba.g, state->dest_rgba.b, state->dest_rgba.a);
 }
 
-static void dest_pixel_lit_texture_modulate(s3d_state_t *state)
+static S3D_INLINE void dest_pixel_lit_texture_modulate(s3d_state_t *state)
 {
         int r = state->r >> 7, g = state->g >> 7, b = state->b >> 7, a = state->a >> 7;
         
-        tex_sample(state);
+        state->tex_sample(state);
         
         CLAMP_RGBA(r, g, b, a);
         
@@ -2784,7 +2877,7 @@ static void dest_pixel_lit_texture_modulate(s3d_state_t *state)
                 state->dest_rgba.a = a;
 }
 
-static void tri(virge_t *virge, s3d_t *s3d_tri, s3d_state_t *state, int yc, int32_t dx1, int32_t dx2)
+static S3D_INLINE void tri(virge_t *virge, s3d_t *s3d_tri, s3d_state_t *state, int yc, int32_t dx1, int32_t dx2, void (*dest_pixel)(s3d_state_t *state))
 {
 	svga_t *svga = &virge->svga;
         uint8_t *vram = svga->vram;
@@ -3030,6 +3123,20 @@ tri_skip_line:
         }
 }
 
+/*The span loop is instantiated for each way of producing the source pixel, so
+  the colour maths is inlined into it rather than called for every pixel.*/
+#define TRI_FUNC(name)                                                                                                  \
+        static void tri_ ## name(virge_t *virge, s3d_t *s3d_tri, s3d_state_t *state, int yc, int32_t dx1, int32_t dx2)  \
+        {                                                                                                               \
+                tri(virge, s3d_tri, state, yc, dx1, dx2, dest_pixel_ ## name);                                          \
+        }
+
+TRI_FUNC(gouraud_shaded_triangle)
+TRI_FUNC(unlit_texture_triangle)
+TRI_FUNC(lit_texture_decal)
+TRI_FUNC(lit_texture_reflection)
+TRI_FUNC(lit_texture_modulate)
+
 static int tex_size[8] =
 {
         4*2,
@@ -3045,6 +3152,8 @@ static int tex_size[8] =
 static void s3_virge_triangle(virge_t *virge, s3d_t *s3d_tri)
 {
         s3d_state_t state;
+        void (*tri_func)(virge_t *virge, s3d_t *s3d_tri, s3d_state_t *state, int yc, int32_t dx1, int32_t dx2);
+        int sample = TEX_SAMPLE_NORMAL, read;
 
         uint32_t tex_base;
         int c;
@@ -3082,20 +3191,20 @@ static void s3_virge_triangle(virge_t *virge, s3d_t *s3d_tri)
         switch ((s3d_tri->cmd_set >> 27) & 0xf)
         {
                 case 0:
-                dest_pixel = dest_pixel_gouraud_shaded_triangle;
+                tri_func = tri_gouraud_shaded_triangle;
                 break;
                 case 1:
                 case 5:
                 switch ((s3d_tri->cmd_set >> 15) & 0x3)
                 {
                         case 0:
-                        dest_pixel = dest_pixel_lit_texture_reflection;
+                        tri_func = tri_lit_texture_reflection;
                         break;
                         case 1:
-                        dest_pixel = dest_pixel_lit_texture_modulate;
+                        tri_func = tri_lit_texture_modulate;
                         break;
                         case 2:
-                        dest_pixel = dest_pixel_lit_texture_decal;
+                        tri_func = tri_lit_texture_decal;
                         break;
                         default:
                         s3_virge_log("bad triangle type %x\n", (s3d_tri->cmd_set >> 27) & 0xf);
@@ -3104,7 +3213,7 @@ static void s3_virge_triangle(virge_t *virge, s3d_t *s3d_tri)
                 break;
                 case 2:
                 case 6:
-                dest_pixel = dest_pixel_unlit_texture_triangle;
+                tri_func = tri_unlit_texture_triangle;
                 break;
                 default:
                 s3_virge_log("bad triangle type %x\n", (s3d_tri->cmd_set >> 27) & 0xf);
@@ -3114,16 +3223,16 @@ static void s3_virge_triangle(virge_t *virge, s3d_t *s3d_tri)
         switch (((s3d_tri->cmd_set >> 12) & 7) | ((s3d_tri->cmd_set & (1 << 29)) ? 8 : 0))
         {
                 case 0: case 1:
-                tex_sample = tex_sample_mipmap;
+                sample = TEX_SAMPLE_MIPMAP;
                 break;
                 case 2: case 3:
-                tex_sample = virge->bilinear_enabled ? tex_sample_mipmap_filter : tex_sample_mipmap;
+                sample = virge->bilinear_enabled ? TEX_SAMPLE_MIPMAP_FILTER : TEX_SAMPLE_MIPMAP;
                 break;
                 case 4: case 5:
-                tex_sample = tex_sample_normal;
+                sample = TEX_SAMPLE_NORMAL;
                 break;
                 case 6: case 7:
-                tex_sample = virge->bilinear_enabled ? tex_sample_normal_filter : tex_sample_normal;
+                sample = virge->bilinear_enabled ? TEX_SAMPLE_NORMAL_FILTER : TEX_SAMPLE_NORMAL;
                 break;
                 case (0 | 8): case (1 | 8):
 #if defined(DEV_BRANCH) && defined(USE_S3TRIO3D2X)
@@ -3131,9 +3240,9 @@ static void s3_virge_triangle(virge_t *virge, s3d_t *s3d_tri)
 #else
 		if (virge->chip == S3_VIRGEDX)
 #endif
-                        tex_sample = tex_sample_persp_mipmap_375;
+                        sample = TEX_SAMPLE_PERSP_MIPMAP_375;
                 else
-                        tex_sample = tex_sample_persp_mipmap;
+                        sample = TEX_SAMPLE_PERSP_MIPMAP;
                 break;
                 case (2 | 8): case (3 | 8):
 #if defined(DEV_BRANCH) && defined(USE_S3TRIO3D2X)
@@ -3141,9 +3250,9 @@ static void s3_virge_triangle(virge_t *virge, s3d_t *s3d_tri)
 #else
 		if (virge->chip == S3_VIRGEDX)
 #endif
-                        tex_sample = virge->bilinear_enabled ? tex_sample_persp_mipmap_filter_375 : tex_sample_persp_mipmap_375;
+                        sample = virge->bilinear_enabled ? TEX_SAMPLE_PERSP_MIPMAP_FILTER_375 : TEX_SAMPLE_PERSP_MIPMAP_375;
                 else
-                        tex_sample = virge->bilinear_enabled ? tex_sample_persp_mipmap_filter : tex_sample_persp_mipmap;
+                        sample = virge->bilinear_enabled ? TEX_SAMPLE_PERSP_MIPMAP_FILTER : TEX_SAMPLE_PERSP_MIPMAP;
                 break;
                 case (4 | 8): case (5 | 8):
 #if defined(DEV_BRANCH) && defined(USE_S3TRIO3D2X)
@@ -3151,9 +3260,9 @@ static void s3_virge_triangle(virge_t *virge, s3d_t *s3d_tri)
 #else
 		if (virge->chip == S3_VIRGEDX)
 #endif
-                        tex_sample = tex_sample_persp_normal_375;
+                        sample = TEX_SAMPLE_PERSP_NORMAL_375;
                 else
-                        tex_sample = tex_sample_persp_normal;
+                        sample = TEX_SAMPLE_PERSP_NORMAL;
                 break;
                 case (6 | 8): case (7 | 8):
 #if defined(DEV_BRANCH) && defined(USE_S3TRIO3D2X)
@@ -3161,35 +3270,37 @@ static void s3_virge_triangle(virge_t *virge, s3d_t *s3d_tri)
 #else
 		if (virge->chip == S3_VIRGEDX)
 #endif
-                        tex_sample = virge->bilinear_enabled ? tex_sample_persp_normal_filter_375 : tex_sample_persp_normal_375;
+                        sample = virge->bilinear_enabled ? TEX_SAMPLE_PERSP_NORMAL_FILTER_375 : TEX_SAMPLE_PERSP_NORMAL_375;
                 else
-                        tex_sample = virge->bilinear_enabled ? tex_sample_persp_normal_filter : tex_sample_persp_normal;
+                        sample = virge->bilinear_enabled ? TEX_SAMPLE_PERSP_NORMAL_FILTER : TEX_SAMPLE_PERSP_NORMAL;
                 break;
         }
         
         switch ((s3d_tri->cmd_set >> 5) & 7)
         {
                 case 0:
-                tex_read = (s3d_tri->cmd_set & CMD_SET_TWE) ? tex_ARGB8888 : tex_ARGB8888_nowrap;
+                read = (s3d_tri->cmd_set & CMD_SET_TWE) ? TEX_READ_ARGB8888 : TEX_READ_ARGB8888_NOWRAP;
                 break;
                 case 1:
-                tex_read = (s3d_tri->cmd_set & CMD_SET_TWE) ? tex_ARGB4444 : tex_ARGB4444_nowrap;
+                read = (s3d_tri->cmd_set & CMD_SET_TWE) ? TEX_READ_ARGB4444 : TEX_READ_ARGB4444_NOWRAP;
                 break;
                 case 2:
-                tex_read = (s3d_tri->cmd_set & CMD_SET_TWE) ? tex_ARGB1555 : tex_ARGB1555_nowrap;
+                read = (s3d_tri->cmd_set & CMD_SET_TWE) ? TEX_READ_ARGB1555 : TEX_READ_ARGB1555_NOWRAP;
                 break;
                 default:
                 s3_virge_log("bad texture type %i\n", (s3d_tri->cmd_set >> 5) & 7);
-                tex_read = (s3d_tri->cmd_set & CMD_SET_TWE) ? tex_ARGB1555 : tex_ARGB1555_nowrap;
+                read = (s3d_tri->cmd_set & CMD_SET_TWE) ? TEX_READ_ARGB1555 : TEX_READ_ARGB1555_NOWRAP;
                 break;
         }
 
+        state.tex_sample = tex_samplers[read][sample];
+
         state.y  = s3d_tri->tys;
         state.x1 = s3d_tri->txs;
         state.x2 = s3d_tri->txend01;
-        tri(virge, s3d_tri, &state, s3d_tri->ty01, s3d_tri->TdXdY02, s3d_tri->TdXdY01);
+        tri_func(virge, s3d_tri, &state, s3d_tri->ty01, s3d_tri->TdXdY02, s3d_tri->TdXdY01);
         state.x2 = s3d_tri->txend12;
-        tri(virge, s3d_tri, &state, s3d_tri->ty12, s3d_tri->TdXdY02, s3d_tri->TdXdY12);
+        tri_func(virge, s3d_tri, &state, s3d_tri->ty12, s3d_tri->TdXdY02, s3d_tri->TdXdY12);
 
         virge->tri_count++;
 
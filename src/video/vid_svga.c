@@ -30,6 +30,7 @@
 #include <86box/device.h>
 #include <86box/machine.h>
 #include <86box/timer.h>
+#include <86box/plat.h>
 #include <86box/io.h>
 #include <86box/pit.h>
 #include <86box/mem.h>
@@ -51,6 +52,70 @@ uint8_t		svga_rotate[8][256];
 static svga_t	*svga_pri;
 
 
+/*Lines in the packed pixel modes are rendered on a separate thread. The
+  emulation thread queues a snapshot of the per-line state, and the thread
+  renders it with a private copy of svga_t that is refreshed whenever
+  render_gen changes. Anything else (text and planar modes, lines with a cursor
+  or overlay on them) waits for the queue to drain and renders in place, as does
+  the end of the frame before it gets blitted.*/
+#define SVGA_RENDER_QUEUE_SIZE	4096
+#define SVGA_RENDER_QUEUE_MASK	(SVGA_RENDER_QUEUE_SIZE - 1)
+#define SVGA_RENDER_BATCH	16
+
+typedef struct
+{
+    void (*render)(struct svga_t *svga);
+    uint32_t ma;
+    int displine, y_add, x_add, dirty;
+} svga_line_t;
+
+typedef struct svga_render_queue_t
+{
+    svga_line_t lines[SVGA_RENDER_QUEUE_SIZE];
+    volatile uint32_t head, tail;
+    volatile int quit;
+
+    svga_t shadow;
+    uint8_t *nochange;
+    int gen;
+
+    thread_t *thread;
+    event_t *wake, *idle;
+} svga_render_queue_t;
+
+/*Orders the line and frame buffer accesses against head and tail, which the
+  two threads hand over to each other.*/
+#ifdef _MSC_VER
+#define svga_render_barrier()	_ReadWriteBarrier()
+#else
+#define svga_render_barrier()	__sync_synchronize()
+#endif
+
+
+/*Moves on the render generation if any of the state the queued renderers read,
+  other than the palette, differs from the copy they are working from. Palette
+  writes bump render_gen themselves, as the table is too big to compare.*/
+static void
+svga_render_update(svga_t *svga)
+{
+    svga_t *shadow;
+
+    if (!svga->render_queue)
+	return;
+
+    shadow = &svga->render_queue->shadow;
+
+    if ((shadow->hdisp != svga->hdisp) || (shadow->scrollcache != svga->scrollcache) ||
+	(shadow->scrblank != svga->scrblank) || (shadow->overscan_color != svga->overscan_color) ||
+	(shadow->vram_display_mask != svga->vram_display_mask) ||
+	(shadow->crtc[0x17] != svga->crtc[0x17]) ||
+	(shadow->attrregs[0x10] != svga->attrregs[0x10]) ||
+	(shadow->attrregs[0x14] != svga->attrregs[0x14]) ||
+	(shadow->map8 != ((svga->map8 == svga->pallook) ? shadow->pallook : svga->map8)))
+	svga->render_gen++;
+}
+
+
 svga_t
 *svga_get_pri()
 {
@@ -133,6 +198,7 @@ svga_out(uint16_t addr, uint8_t val, void *p)
 					svga->fullchange = changeframecount;
 				svga->plane_mask = val & 0xf;
 			}
+			svga_render_update(svga);
 		}
 		svga->attrff ^= 1;
 		break;
@@ -209,6 +275,7 @@ svga_out(uint16_t addr, uint8_t val, void *p)
 					svga->pallook[index] = makecol32(svga->vgapal[index].r, svga->vgapal[index].g, svga->vgapal[index].b);
 				else
 					svga->pallook[index] = makecol32(video_6to8[svga->vgapal[index].r & 0x3f], video_6to8[svga->vgapal[index].g & 0x3f], video_6to8[svga->vgapal[index].b & 0x3f]);
+				svga->render_gen++;
 				svga->dac_pos = 0; 
 				svga->dac_addr = (svga->dac_addr + 1) & 255; 
 				break;
@@ -386,6 +453,7 @@ svga_set_ramdac_type(svga_t *svga, int type)
 						     (svga->vgapal[c].g & 0x3f) * 4,
 						     (svga->vgapal[c].b & 0x3f) * 4);
 	}
+	svga->render_gen++;
     }
 }
 
@@ -574,12 +642,180 @@ svga_recalctimings(svga_t *svga)
 	svga->dispontime = TIMER_USEC;
     if (svga->dispofftime < TIMER_USEC)
 	svga->dispofftime = TIMER_USEC;
+
+    svga_render_update(svga);
+}
+
+
+static void
+svga_render_thread(void *param)
+{
+    svga_render_queue_t *queue = (svga_render_queue_t *)param;
+    svga_t *shadow = &queue->shadow;
+    svga_line_t *line;
+
+    while (!queue->quit) {
+	thread_wait_event(queue->wake, -1);
+
+	while (queue->tail != queue->head) {
+		svga_render_barrier();
+		line = &queue->lines[queue->tail & SVGA_RENDER_QUEUE_MASK];
+
+		shadow->ma = line->ma;
+		shadow->displine = line->displine;
+		shadow->y_add = line->y_add;
+		shadow->x_add = line->x_add;
+		shadow->fullchange = line->dirty;
+		if (line->dirty)
+			line->render(shadow);
+
+		shadow->x_add = (overscan_x >> 1);
+		svga_render_overscan_left(shadow);
+		svga_render_overscan_right(shadow);
+
+		svga_render_barrier();
+		queue->tail++;
+	}
+
+	thread_set_event(queue->idle);
+    }
+}
+
+
+/*Wait for all queued lines to be rendered.*/
+static void
+svga_render_sync(svga_t *svga)
+{
+    svga_render_queue_t *queue = svga->render_queue;
+
+    if (!queue)
+	return;
+
+    if (queue->tail != queue->head) {
+	thread_set_event(queue->wake);
+	while (queue->tail != queue->head)
+		thread_wait_event(queue->idle, -1);
+    }
+
+    svga_render_barrier();
+}
+
+
+static int
+svga_render_can_queue(svga_t *svga)
+{
+    void (*render)(struct svga_t *svga) = svga->render;
+
+    if (!svga->render_queue || svga->override ||
+	svga->hwcursor_on || svga->dac_hwcursor_on || svga->overlay_on)
+	return 0;
+
+    return (render == svga_render_8bpp_lowres) || (render == svga_render_8bpp_highres) ||
+	   (render == svga_render_15bpp_lowres) || (render == svga_render_15bpp_highres) ||
+	   (render == svga_render_15bpp_mix_lowres) || (render == svga_render_15bpp_mix_highres) ||
+	   (render == svga_render_16bpp_lowres) || (render == svga_render_16bpp_highres) ||
+	   (render == svga_render_24bpp_lowres) || (render == svga_render_24bpp_highres) ||
+	   (render == svga_render_32bpp_lowres) || (render == svga_render_32bpp_highres) ||
+	   (render == svga_render_ABGR8888_highres) || (render == svga_render_RGBA8888_highres);
+}
+
+
+static void
+svga_render_queue_line(svga_t *svga)
+{
+    svga_render_queue_t *queue = svga->render_queue;
+    svga_line_t *line;
+    uint32_t page = svga->ma >> 12;
+
+    if (queue->gen != svga->render_gen) {
+	svga_render_sync(svga);
+	queue->shadow = *svga;
+	queue->shadow.changedvram = queue->nochange;
+	if (svga->map8 == svga->pallook)
+		queue->shadow.map8 = queue->shadow.pallook;
+	queue->shadow.render_queue = NULL;
+	queue->gen = svga->render_gen;
+    }
+
+    if ((queue->head - queue->tail) >= SVGA_RENDER_QUEUE_SIZE)
+	svga_render_sync(svga);
+
+    line = &queue->lines[queue->head & SVGA_RENDER_QUEUE_MASK];
+    line->render = svga->render;
+    line->ma = svga->ma;
+    line->displine = svga->displine;
+    line->y_add = svga->y_add;
+    line->x_add = svga->x_add;
+
+    /*The dirty check the renderers would do, covering the widest of them. The
+      draw range is tracked here rather than in the copy.*/
+    line->dirty = ((svga->displine + svga->y_add) >= 0) &&
+		  (svga->changedvram[page] || svga->changedvram[page + 1] ||
+		   svga->changedvram[page + 2] || svga->fullchange);
+    if (line->dirty) {
+	if (svga->firstline_draw == 2000)
+		svga->firstline_draw = svga->displine;
+	svga->lastline_draw = svga->displine;
+	video_mark_dirty(svga->displine + svga->y_add, svga->displine + svga->y_add + 1);
+    }
+
+    svga_render_barrier();
+    queue->head++;
+
+    if (!(queue->head & (SVGA_RENDER_BATCH - 1)))
+	thread_set_event(queue->wake);
+}
+
+
+static void
+svga_render_init(svga_t *svga)
+{
+    svga_render_queue_t *queue = malloc(sizeof(svga_render_queue_t));
+
+    memset(queue, 0, sizeof(svga_render_queue_t));
+    queue->nochange = calloc((svga->vram_max >> 12) + 3, 1);
+    queue->gen = svga->render_gen - 1;
+    queue->wake = thread_create_event();
+    queue->idle = thread_create_event();
+    queue->thread = thread_create(svga_render_thread, queue);
+
+    svga->render_queue = queue;
+}
+
+
+static void
+svga_render_close(svga_t *svga)
+{
+    svga_render_queue_t *queue = svga->render_queue;
+
+    if (!queue)
+	return;
+
+    svga_render_sync(svga);
+
+    queue->quit = 1;
+    thread_set_event(queue->wake);
+    thread_wait(queue->thread, -1);
+
+    thread_destroy_event(queue->wake);
+    thread_destroy_event(queue->idle);
+    free(queue->nochange);
+    free(queue);
+
+    svga->render_queue = NULL;
 }
 
 
 static void
 svga_do_render(svga_t *svga)
 {
+    if (svga_render_can_queue(svga)) {
+	svga_render_queue_line(svga);
+	return;
+    }
+
+    svga_render_sync(svga);
+
     if (!svga->override) {
 	svga->render(svga);
 
@@ -587,6 +823,12 @@ svga_do_render(svga_t *svga)
 	svga_render_overscan_left(svga);
 	svga_render_overscan_right(svga);
 	svga->x_add = (overscan_x >> 1) - svga->scrollcache;
+
+	/*Only lines the renderer actually redrew, or that have a cursor or
+	  overlay drawn over them, need to be copied out at blit time.*/
+	if (((svga->firstline_draw != 2000) && (svga->lastline_draw == svga->displine)) ||
+	    svga->overlay_on || svga->dac_hwcursor_on || svga->hwcursor_on)
+		video_mark_dirty(svga->displine + svga->y_add, svga->displine + svga->y_add + 1);
     }
 
     if (svga->overlay_on) {
@@ -664,10 +906,8 @@ svga_poll(void *p)
 		svga->hdisp_on = 1;
 
 		svga->ma &= svga->vram_display_mask;
-		if (svga->firstline == 2000) {
+		if (svga->firstline == 2000)
 			svga->firstline = svga->displine;
-			video_wait_for_buffer();
-		}
 
 		if (svga->hwcursor_on || svga->dac_hwcursor_on || svga->overlay_on) {
 			svga->changedvram[svga->ma >> 12] = svga->changedvram[(svga->ma >> 12) + 1] =
@@ -799,6 +1039,8 @@ svga_poll(void *p)
 
 		wx = x;
 
+		svga_render_sync(svga);
+
 		if (!svga->override) {
 			if (svga->vertical_linedbl) {
 				wy = (svga->lastline - svga->firstline) << 1;
@@ -869,6 +1111,9 @@ svga_poll(void *p)
 
 		svga->overlay_on = 0;
 		svga->overlay_latch = svga->overlay;
+
+		/*Pick up any state changed behind svga_out()'s back once a frame.*/
+		svga->render_gen++;
 	}
 	if (svga->sc == (svga->crtc[10] & 31)) 
 		svga->con = 1;
@@ -953,6 +1198,8 @@ svga_init(const device_t *info, svga_t *svga, void *p, int memsize,
 
     svga->map8 = svga->pallook;
 
+    svga_render_init(svga);
+
     return 0;
 }
 
@@ -960,6 +1207,8 @@ svga_init(const device_t *info, svga_t *svga, void *p, int memsize,
 void
 svga_close(svga_t *svga)
 {
+    svga_render_close(svga);
+
     free(svga->changedvram);
     free(svga->vram);
 
@@ -1305,6 +1554,28 @@ svga_read_linear(uint32_t addr, void *p)
 }
 
 
+/* Mark every 4 kB page touched by a len byte span of VRAM as changed, for
+   accelerators that write whole rows at once. */
+void
+svga_mark_changed(svga_t *svga, uint32_t addr, uint32_t len)
+{
+    uint32_t page, end;
+
+    if (!len)
+	return;
+
+    page = (addr & svga->vram_mask) >> 12;
+    end = ((addr + len - 1) & svga->vram_mask) >> 12;
+
+    for (;;) {
+	svga->changedvram[page] = changeframecount;
+	if (page == end)
+		break;
+	page = (page + 1) & (svga->vram_mask >> 12);
+    }
+}
+
+
 void
 svga_doblit(int y1, int y2, int wx, int wy, svga_t *svga)
 {
@@ -1375,6 +1646,7 @@ svga_doblit(int y1, int y2, int wx, int wy, svga_t *svga)
 		for (j = 0; j < (xsize + x_add); j++)
 			p[j] = svga->overscan_color;
 	}
+	video_mark_dirty(0, svga->y_add);
 
 	for (i  = 0; i < bottom; i++) {
 		p = &buffer32->line[(ysize + svga->y_add + i) & 0x7ff][0];
@@ -1382,9 +1654,10 @@ svga_doblit(int y1, int y2, int wx, int wy, svga_t *svga)
 		for (j = 0; j < (xsize + x_add); j++)
 			p[j] = svga->overscan_color;
 	}
+	video_mark_dirty(ysize + svga->y_add, ysize + svga->y_add + bottom);
     }
 
-    video_blit_memtoscreen(x_start, y_start, y1, y2 + y_add, xsize + x_add, ysize + y_add);
+    video_blit_memtoscreen_dirty(x_start, y_start, y1, y2 + y_add, xsize + x_add, ysize + y_add);
 
     if (svga->vertical_linedbl)
 	svga->vertical_linedbl >>= 1;
@@ -28,6 +28,183 @@
 #include <86box/vid_svga.h>
 #include <86box/vid_svga_render.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+# define SVGA_RENDER_SSE2
+# include <emmintrin.h>
+#endif
+
+
+#ifdef SVGA_RENDER_SSE2
+/* The direct colour renderers below expand a whole scanline at a time when the
+   visible span does not wrap around vram_display_mask, instead of masking the
+   address of every pixel. SSE2 is part of the x86-64 baseline, so this is
+   selected at compile time; anything else falls back to the per-pixel loops. */
+#define SVGA_32BPP_RGB		0
+#define SVGA_32BPP_BGR		1
+#define SVGA_32BPP_RGBA		2
+
+
+/* Returns a pointer to len bytes of VRAM at addr, or NULL if the span wraps. */
+static __inline uint8_t *
+svga_render_span(svga_t *svga, uint32_t addr, uint32_t len)
+{
+    addr &= svga->vram_display_mask;
+
+    if ((addr + len) > (svga->vram_display_mask + 1))
+	return NULL;
+
+    return &svga->vram[addr];
+}
+
+
+static __inline uint32_t *
+svga_render_store(uint32_t *p, __m128i px, int dbl)
+{
+    if (dbl) {
+	_mm_storeu_si128((__m128i *) p, _mm_unpacklo_epi32(px, px));
+	_mm_storeu_si128((__m128i *) (p + 4), _mm_unpackhi_epi32(px, px));
+	return p + 8;
+    }
+
+    _mm_storeu_si128((__m128i *) p, px);
+    return p + 4;
+}
+
+
+/* Scales 5 or 6-bit channels to 8 bits as (c * 255) / max, truncated, which is
+   what calc_15to32() and calc_16to32() put in video_15to32/video_16to32. The
+   division is a multiply-high by a reciprocal that is exact over the range. */
+static __inline __m128i
+svga_render_scale5(__m128i c)
+{
+    c = _mm_mullo_epi16(c, _mm_set1_epi16(255));
+    return _mm_srli_epi16(_mm_mulhi_epu16(c, _mm_set1_epi16(8457)), 2);
+}
+
+
+static __inline __m128i
+svga_render_scale6(__m128i c)
+{
+    c = _mm_mullo_epi16(c, _mm_set1_epi16(255));
+    return _mm_srli_epi16(_mm_mulhi_epu16(c, _mm_set1_epi16(8323)), 3);
+}
+
+
+static void
+svga_render_16to32_sse2(uint32_t *p, const uint8_t *src, int n, int bpp16, int dbl)
+{
+    const __m128i m5 = _mm_set1_epi16(0x1f);
+    __m128i v, r, g, b, bg;
+    uint32_t *lut = bpp16 ? video_16to32 : video_15to32;
+    uint32_t dat;
+    int x;
+
+    for (x = 0; x <= (n - 8); x += 8) {
+	v = _mm_loadu_si128((const __m128i *) &src[x << 1]);
+
+	b = svga_render_scale5(_mm_and_si128(v, m5));
+	if (bpp16) {
+		g = svga_render_scale6(_mm_and_si128(_mm_srli_epi16(v, 5), _mm_set1_epi16(0x3f)));
+		r = svga_render_scale5(_mm_and_si128(_mm_srli_epi16(v, 11), m5));
+	} else {
+		g = svga_render_scale5(_mm_and_si128(_mm_srli_epi16(v, 5), m5));
+		r = svga_render_scale5(_mm_and_si128(_mm_srli_epi16(v, 10), m5));
+	}
+	bg = _mm_or_si128(b, _mm_slli_epi16(g, 8));
+
+	p = svga_render_store(p, _mm_unpacklo_epi16(bg, r), dbl);
+	p = svga_render_store(p, _mm_unpackhi_epi16(bg, r), dbl);
+    }
+
+    for (; x < n; x++) {
+	dat = lut[*(uint16_t *) &src[x << 1]];
+	*p++ = dat;
+	if (dbl)
+		*p++ = dat;
+    }
+}
+
+
+/* Reads 16 bytes for every 4 pixels, so the span must cover n * 3 + 4 bytes. */
+static void
+svga_render_24to32_sse2(uint32_t *p, const uint8_t *src, int n, int dbl)
+{
+    const __m128i mask = _mm_set1_epi32(0x00ffffff);
+    __m128i v, lo, hi;
+    uint32_t dat;
+    int x;
+
+    for (x = 0; x <= (n - 4); x += 4) {
+	v = _mm_loadu_si128((const __m128i *) &src[x * 3]);
+
+	lo = _mm_unpacklo_epi32(v, _mm_srli_si128(v, 3));
+	hi = _mm_unpacklo_epi32(_mm_srli_si128(v, 6), _mm_srli_si128(v, 9));
+
+	p = svga_render_store(p, _mm_and_si128(_mm_unpacklo_epi64(lo, hi), mask), dbl);
+    }
+
+    for (; x < n; x++) {
+	dat = *(uint32_t *) &src[x * 3] & 0xffffff;
+	*p++ = dat;
+	if (dbl)
+		*p++ = dat;
+    }
+}
+
+
+static void
+svga_render_32to32_sse2(uint32_t *p, const uint8_t *src, int n, int fmt, int dbl)
+{
+    const __m128i mask = _mm_set1_epi32(0x00ffffff);
+    const __m128i mask_g = _mm_set1_epi32(0x0000ff00);
+    const __m128i mask_b = _mm_set1_epi32(0x000000ff);
+    __m128i v;
+    uint32_t dat;
+    int x;
+
+    for (x = 0; x <= (n - 4); x += 4) {
+	v = _mm_loadu_si128((const __m128i *) &src[x << 2]);
+
+	switch (fmt) {
+		case SVGA_32BPP_RGB:
+			v = _mm_and_si128(v, mask);
+			break;
+		case SVGA_32BPP_BGR:
+			v = _mm_or_si128(_mm_or_si128(_mm_and_si128(_mm_srli_epi32(v, 16), mask_b),
+						      _mm_and_si128(v, mask_g)),
+					 _mm_slli_epi32(_mm_and_si128(v, mask_b), 16));
+			break;
+		case SVGA_32BPP_RGBA:
+			v = _mm_srli_epi32(v, 8);
+			break;
+	}
+
+	p = svga_render_store(p, v, dbl);
+    }
+
+    for (; x < n; x++) {
+	dat = *(uint32_t *) &src[x << 2];
+
+	switch (fmt) {
+		case SVGA_32BPP_RGB:
+			dat &= 0xffffff;
+			break;
+		case SVGA_32BPP_BGR:
+			dat = ((dat & 0xff0000) >> 16) | (dat & 0x00ff00) | ((dat & 0x0000ff) << 16);
+			break;
+		case SVGA_32BPP_RGBA:
+			dat >>= 8;
+			break;
+	}
+
+	*p++ = dat;
+	if (dbl)
+		*p++ = dat;
+    }
+}
+#endif
+
+
 void
 svga_render_null(svga_t *svga)
 {
@@ -773,6 +950,19 @@ svga_render_15bpp_lowres(svga_t *svga)
 		svga->firstline_draw = svga->displine;
 	svga->lastline_draw = svga->displine;
 
+#ifdef SVGA_RENDER_SSE2
+	if (svga->crtc[0x17] & 0x80) {
+		int n = ((svga->hdisp + svga->scrollcache) & ~3) + 4;
+		uint8_t *src = svga_render_span(svga, svga->ma, n << 1);
+
+		if (src) {
+			svga_render_16to32_sse2(p, src, n, 0, 1);
+			svga->ma = (svga->ma + (n << 1)) & svga->vram_display_mask;
+			return;
+		}
+	}
+#endif
+
 	for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 4) {
 		if (svga->crtc[0x17] & 0x80) {
 			dat = *(uint32_t *)(&svga->vram[(svga->ma + (x << 1)) & svga->vram_display_mask]);
@@ -810,6 +1000,19 @@ svga_render_15bpp_highres(svga_t *svga)
 		svga->firstline_draw = svga->displine;
 	svga->lastline_draw = svga->displine;
 
+#ifdef SVGA_RENDER_SSE2
+	if (svga->crtc[0x17] & 0x80) {
+		int n = ((svga->hdisp + svga->scrollcache) & ~7) + 8;
+		uint8_t *src = svga_render_span(svga, svga->ma, n << 1);
+
+		if (src) {
+			svga_render_16to32_sse2(p, src, n, 0, 0);
+			svga->ma = (svga->ma + (n << 1)) & svga->vram_display_mask;
+			return;
+		}
+	}
+#endif
+
 	for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 8) {
 		if (svga->crtc[0x17] & 0x80) {
 			dat = *(uint32_t *)(&svga->vram[(svga->ma + (x << 1)) & svga->vram_display_mask]);
@@ -939,6 +1142,19 @@ svga_render_16bpp_lowres(svga_t *svga)
 		svga->firstline_draw = svga->displine;
 	svga->lastline_draw = svga->displine;
 
+#ifdef SVGA_RENDER_SSE2
+	if (svga->crtc[0x17] & 0x80) {
+		int n = ((svga->hdisp + svga->scrollcache) & ~3) + 4;
+		uint8_t *src = svga_render_span(svga, svga->ma, n << 1);
+
+		if (src) {
+			svga_render_16to32_sse2(p, src, n, 1, 1);
+			svga->ma = (svga->ma + (n << 1)) & svga->vram_display_mask;
+			return;
+		}
+	}
+#endif
+
 	for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 4) {
 		if (svga->crtc[0x17] & 0x80) {
 			dat = *(uint32_t *)(&svga->vram[(svga->ma + (x << 1)) & svga->vram_display_mask]);
@@ -973,6 +1189,19 @@ svga_render_16bpp_highres(svga_t *svga)
 		svga->firstline_draw = svga->displine;
 	svga->lastline_draw = svga->displine;
 
+#ifdef SVGA_RENDER_SSE2
+	if (svga->crtc[0x17] & 0x80) {
+		int n = ((svga->hdisp + svga->scrollcache) & ~7) + 8;
+		uint8_t *src = svga_render_span(svga, svga->ma, n << 1);
+
+		if (src) {
+			svga_render_16to32_sse2(p, src, n, 1, 0);
+			svga->ma = (svga->ma + (n << 1)) & svga->vram_display_mask;
+			return;
+		}
+	}
+#endif
+
 	for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 8) {
 		if (svga->crtc[0x17] & 0x80) {
 			uint32_t dat = *(uint32_t *)(&svga->vram[(svga->ma + (x << 1)) & svga->vram_display_mask]);
@@ -1013,6 +1242,19 @@ svga_render_24bpp_lowres(svga_t *svga)
 		svga->firstline_draw = svga->displine;
 	svga->lastline_draw = svga->displine;
 
+#ifdef SVGA_RENDER_SSE2
+	if (svga->crtc[0x17] & 0x80) {
+		int n = (svga->hdisp + svga->scrollcache) + 1;
+		uint8_t *src = svga_render_span(svga, svga->ma, (n * 3) + 4);
+
+		if (src) {
+			svga_render_24to32_sse2(&buffer32->line[svga->displine + svga->y_add][svga->x_add], src, n, 1);
+			svga->ma = (svga->ma + (n * 3)) & svga->vram_display_mask;
+			return;
+		}
+	}
+#endif
+
 	for (x = 0; x <= (svga->hdisp + svga->scrollcache); x++) {
 		if (svga->crtc[0x17] & 0x80)
 			fg = svga->vram[svga->ma] | (svga->vram[svga->ma + 1] << 8) | (svga->vram[svga->ma + 2] << 16);
@@ -1044,6 +1286,19 @@ svga_render_24bpp_highres(svga_t *svga)
 		svga->firstline_draw = svga->displine;
 	svga->lastline_draw = svga->displine;
 
+#ifdef SVGA_RENDER_SSE2
+	if (svga->crtc[0x17] & 0x80) {
+		int n = ((svga->hdisp + svga->scrollcache) & ~3) + 4;
+		uint8_t *src = svga_render_span(svga, svga->ma, (n * 3) + 4);
+
+		if (src) {
+			svga_render_24to32_sse2(p, src, n, 0);
+			svga->ma = (svga->ma + (n * 3)) & svga->vram_display_mask;
+			return;
+		}
+	}
+#endif
+
 	for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 4) {
 		if (svga->crtc[0x17] & 0x80) {
 			dat = *(uint32_t *)(&svga->vram[svga->ma & svga->vram_display_mask]);
@@ -1081,6 +1336,19 @@ svga_render_32bpp_lowres(svga_t *svga)
 		svga->firstline_draw = svga->displine;
 	svga->lastline_draw = svga->displine;
 
+#ifdef SVGA_RENDER_SSE2
+	if (svga->crtc[0x17] & 0x80) {
+		int n = (svga->hdisp + svga->scrollcache) + 1;
+		uint8_t *src = svga_render_span(svga, svga->ma, n << 2);
+
+		if (src) {
+			svga_render_32to32_sse2(&buffer32->line[svga->displine + svga->y_add][svga->x_add], src, n, SVGA_32BPP_RGB, 1);
+			svga->ma = (svga->ma + (n << 2)) & svga->vram_display_mask;
+			return;
+		}
+	}
+#endif
+
 	for (x = 0; x <= (svga->hdisp + svga->scrollcache); x++) {
 		if (svga->crtc[0x17] & 0x80)
 			fg = svga->vram[svga->ma] | (svga->vram[svga->ma + 1] << 8) | (svga->vram[svga->ma + 2] << 16);
@@ -1112,6 +1380,19 @@ svga_render_32bpp_highres(svga_t *svga)
 		svga->firstline_draw = svga->displine;
 	svga->lastline_draw = svga->displine;
 
+#ifdef SVGA_RENDER_SSE2
+	if (svga->crtc[0x17] & 0x80) {
+		int n = (svga->hdisp + svga->scrollcache) + 1;
+		uint8_t *src = svga_render_span(svga, svga->ma, n << 2);
+
+		if (src) {
+			svga_render_32to32_sse2(p, src, n, SVGA_32BPP_RGB, 0);
+			svga->ma = (svga->ma + 4) & svga->vram_display_mask;
+			return;
+		}
+	}
+#endif
+
 	for (x = 0; x <= (svga->hdisp + svga->scrollcache); x++) {
 		if (svga->crtc[0x17] & 0x80)
 			dat = *(uint32_t *)(&svga->vram[(svga->ma + (x << 2)) & svga->vram_display_mask]);
@@ -1142,6 +1423,19 @@ svga_render_ABGR8888_highres(svga_t *svga)
 		svga->firstline_draw = svga->displine;
 	svga->lastline_draw = svga->displine;
 
+#ifdef SVGA_RENDER_SSE2
+	if (svga->crtc[0x17] & 0x80) {
+		int n = (svga->hdisp + svga->scrollcache) + 1;
+		uint8_t *src = svga_render_span(svga, svga->ma, n << 2);
+
+		if (src) {
+			svga_render_32to32_sse2(p, src, n, SVGA_32BPP_BGR, 0);
+			svga->ma = (svga->ma + 4) & svga->vram_display_mask;
+			return;
+		}
+	}
+#endif
+
 	for (x = 0; x <= (svga->hdisp + svga->scrollcache); x++) {
 		if (svga->crtc[0x17] & 0x80)
 			dat = *(uint32_t *)(&svga->vram[(svga->ma + (x << 2)) & svga->vram_display_mask]);
@@ -1172,6 +1466,19 @@ svga_render_RGBA8888_highres(svga_t *svga)
 		svga->firstline_draw = svga->displine;
 	svga->lastline_draw = svga->displine;
 
+#ifdef SVGA_RENDER_SSE2
+	if (svga->crtc[0x17] & 0x80) {
+		int n = (svga->hdisp + svga->scrollcache) + 1;
+		uint8_t *src = svga_render_span(svga, svga->ma, n << 2);
+
+		if (src) {
+			svga_render_32to32_sse2(p, src, n, SVGA_32BPP_RGBA, 0);
+			svga->ma = (svga->ma + 4) & svga->vram_display_mask;
+			return;
+		}
+	}
+#endif
+
 	for (x = 0; x <= (svga->hdisp + svga->scrollcache); x++) {
 		if (svga->crtc[0x17] & 0x80)
 			dat = *(uint32_t *)(&svga->vram[(svga->ma + (x << 2)) & svga->vram_display_mask]);
@@ -901,6 +901,22 @@ static void voodoo_force_blit(void *p)
         }
 }
 
+/*A render thread count of 0 means one per host processor, leaving one for the
+  emulation itself*/
+static int voodoo_get_render_threads(void)
+{
+        int render_threads = device_get_config_int("render_threads");
+
+        if (!render_threads)
+                render_threads = plat_get_cpu_count() - 1;
+        if (render_threads < 1)
+                render_threads = 1;
+        if (render_threads > VOODOO_MAX_RENDER_THREADS)
+                render_threads = VOODOO_MAX_RENDER_THREADS;
+
+        return render_threads;
+}
+
 void *voodoo_card_init()
 {
         int c;
@@ -913,8 +929,7 @@ void *voodoo_card_init()
         voodoo->texture_mask = (voodoo->texture_size << 20) - 1;
         voodoo->fb_size = device_get_config_int("framebuffer_memory");
         voodoo->fb_mask = (voodoo->fb_size << 20) - 1;
-        voodoo->render_threads = device_get_config_int("render_threads");
-        voodoo->odd_even_mask = voodoo->render_threads - 1;
+        voodoo->render_threads = voodoo_get_render_threads();
 #ifndef NO_CODEGEN
         voodoo->use_recompiler = device_get_config_int("recompiler");
 #endif                        
@@ -947,17 +962,7 @@ void *voodoo_card_init()
         voodoo->tex_mem_w[0] = (uint16_t *)voodoo->tex_mem[0];
         voodoo->tex_mem_w[1] = (uint16_t *)voodoo->tex_mem[1];
         
-        for (c = 0; c < TEX_CACHE_MAX; c++) {
-                voodoo->texture_cache[0][c].data = malloc((256*256 + 256*256 + 128*128 + 64*64 + 32*32 + 16*16 + 8*8 + 4*4 + 2*2) * 4);
-                voodoo->texture_cache[0][c].base = -1; /*invalid*/
-                voodoo->texture_cache[0][c].refcount = 0;
-                if (voodoo->dual_tmus)
-                {
-                        voodoo->texture_cache[1][c].data = malloc((256*256 + 256*256 + 128*128 + 64*64 + 32*32 + 16*16 + 8*8 + 4*4 + 2*2) * 4);
-                        voodoo->texture_cache[1][c].base = -1; /*invalid*/
-                        voodoo->texture_cache[1][c].refcount = 0;
-                }
-        }
+        voodoo_texture_cache_init(voodoo, device_get_config_int("texture_cache"));
 
         timer_add(&voodoo->timer, voodoo_callback, voodoo, 1);
         
@@ -965,23 +970,15 @@ void *voodoo_card_init()
         voodoo->fbiInit0 = 0;
 
         voodoo->wake_fifo_thread = thread_create_event();
-        voodoo->wake_render_thread[0] = thread_create_event();
-        voodoo->wake_render_thread[1] = thread_create_event();
-        voodoo->wake_render_thread[2] = thread_create_event();
-        voodoo->wake_render_thread[3] = thread_create_event();
         voodoo->wake_main_thread = thread_create_event();
         voodoo->fifo_not_full_event = thread_create_event();
-        voodoo->render_not_full_event[0] = thread_create_event();
-        voodoo->render_not_full_event[1] = thread_create_event();
-        voodoo->render_not_full_event[2] = thread_create_event();
-        voodoo->render_not_full_event[3] = thread_create_event();
         voodoo->fifo_thread = thread_create(voodoo_fifo_thread, voodoo);
-        voodoo->render_thread[0] = thread_create(voodoo_render_thread_1, voodoo);
-        if (voodoo->render_threads >= 2)
-                voodoo->render_thread[1] = thread_create(voodoo_render_thread_2, voodoo);
-        if (voodoo->render_threads == 4) {
-                voodoo->render_thread[2] = thread_create(voodoo_render_thread_3, voodoo);
-                voodoo->render_thread[3] = thread_create(voodoo_render_thread_4, voodoo);
+        for (c = 0; c < voodoo->render_threads; c++) {
+                voodoo->wake_render_thread[c] = thread_create_event();
+                voodoo->render_not_full_event[c] = thread_create_event();
+                voodoo->render_thread_data[c].voodoo = voodoo;
+                voodoo->render_thread_data[c].odd_even = c;
+                voodoo->render_thread[c] = thread_create(voodoo_render_thread, &voodoo->render_thread_data[c]);
         }
         voodoo->swap_mutex = thread_create_mutex();
         timer_add(&voodoo->wake_timer, voodoo_wake_timer, (void *)voodoo, 0);
@@ -1054,8 +1051,7 @@ void *voodoo_2d3d_card_init(int type)
 
         voodoo->bilinear_enabled = device_get_config_int("bilinear");
         voodoo->scrfilter = device_get_config_int("dacfilter");
-        voodoo->render_threads = device_get_config_int("render_threads");
-        voodoo->odd_even_mask = voodoo->render_threads - 1;
+        voodoo->render_threads = voodoo_get_render_threads();
 #ifndef NO_CODEGEN
         voodoo->use_recompiler = device_get_config_int("recompiler");
 #endif
@@ -1065,40 +1061,22 @@ void *voodoo_2d3d_card_init(int type)
 	/*generate filter lookup tables*/
 	voodoo_generate_filter_v2(voodoo);
 
-        for (c = 0; c < TEX_CACHE_MAX; c++) {
-                voodoo->texture_cache[0][c].data = malloc((256*256 + 256*256 + 128*128 + 64*64 + 32*32 + 16*16 + 8*8 + 4*4 + 2*2) * 4);
-                voodoo->texture_cache[0][c].base = -1; /*invalid*/
-                voodoo->texture_cache[0][c].refcount = 0;
-                if (voodoo->dual_tmus)
-                {
-                        voodoo->texture_cache[1][c].data = malloc((256*256 + 256*256 + 128*128 + 64*64 + 32*32 + 16*16 + 8*8 + 4*4 + 2*2) * 4);
-                        voodoo->texture_cache[1][c].base = -1; /*invalid*/
-                        voodoo->texture_cache[1][c].refcount = 0;
-                }
-        }
+        voodoo_texture_cache_init(voodoo, device_get_config_int("texture_cache"));
 
         timer_add(&voodoo->timer, voodoo_callback, voodoo, 1);
 
         voodoo->fbiInit0 = 0;
 
         voodoo->wake_fifo_thread = thread_create_event();
-        voodoo->wake_render_thread[0] = thread_create_event();
-        voodoo->wake_render_thread[1] = thread_create_event();
-        voodoo->wake_render_thread[2] = thread_create_event();
-        voodoo->wake_render_thread[3] = thread_create_event();
         voodoo->wake_main_thread = thread_create_event();
         voodoo->fifo_not_full_event = thread_create_event();
-        voodoo->render_not_full_event[0] = thread_create_event();
-        voodoo->render_not_full_event[1] = thread_create_event();
-        voodoo->render_not_full_event[2] = thread_create_event();
-        voodoo->render_not_full_event[3] = thread_create_event();
         voodoo->fifo_thread = thread_create(voodoo_fifo_thread, voodoo);
-        voodoo->render_thread[0] = thread_create(voodoo_render_thread_1, voodoo);
-        if (voodoo->render_threads >= 2)
-                voodoo->render_thread[1] = thread_create(voodoo_render_thread_2, voodoo);
-        if (voodoo->render_threads == 4) {
-                voodoo->render_thread[2] = thread_create(voodoo_render_thread_3, voodoo);
-                voodoo->render_thread[3] = thread_create(voodoo_render_thread_4, voodoo);
+        for (c = 0; c < voodoo->render_threads; c++) {
+                voodoo->wake_render_thread[c] = thread_create_event();
+                voodoo->render_not_full_event[c] = thread_create_event();
+                voodoo->render_thread_data[c].voodoo = voodoo;
+                voodoo->render_thread_data[c].odd_even = c;
+                voodoo->render_thread[c] = thread_create(voodoo_render_thread, &voodoo->render_thread_data[c]);
         }
         voodoo->swap_mutex = thread_create_mutex();
         timer_add(&voodoo->wake_timer, voodoo_wake_timer, (void *)voodoo, 0);
@@ -1242,27 +1220,17 @@ void voodoo_card_close(voodoo_t *voodoo)
 
 
         thread_kill(voodoo->fifo_thread);
-        thread_kill(voodoo->render_thread[0]);
-        if (voodoo->render_threads >= 2)
-                thread_kill(voodoo->render_thread[1]);
-        if (voodoo->render_threads == 4) {
-                thread_kill(voodoo->render_thread[2]);
-                thread_kill(voodoo->render_thread[3]);
-        }
+        for (c = 0; c < voodoo->render_threads; c++)
+                thread_kill(voodoo->render_thread[c]);
         thread_destroy_event(voodoo->fifo_not_full_event);
         thread_destroy_event(voodoo->wake_main_thread);
         thread_destroy_event(voodoo->wake_fifo_thread);
-        thread_destroy_event(voodoo->wake_render_thread[0]);
-        thread_destroy_event(voodoo->wake_render_thread[1]);
-        thread_destroy_event(voodoo->render_not_full_event[0]);
-        thread_destroy_event(voodoo->render_not_full_event[1]);
-
-        for (c = 0; c < TEX_CACHE_MAX; c++)
-        {
-                if (voodoo->dual_tmus)
-                        free(voodoo->texture_cache[1][c].data);
-                free(voodoo->texture_cache[0][c].data);
+        for (c = 0; c < voodoo->render_threads; c++) {
+                thread_destroy_event(voodoo->wake_render_thread[c]);
+                thread_destroy_event(voodoo->render_not_full_event[c]);
         }
+
+        voodoo_texture_cache_close(voodoo);
 #ifndef NO_CODEGEN
         voodoo_codegen_close(voodoo);
 #endif
@@ -1374,6 +1342,10 @@ static const device_config_t voodoo_config[] =
                 .type = CONFIG_SELECTION,
                 .selection =
                 {
+                        {
+                                .description = "Auto",
+                                .value = 0
+                        },
                         {
                                 .description = "1",
                                 .value = 1
@@ -1382,16 +1354,60 @@ static const device_config_t voodoo_config[] =
                                 .description = "2",
                                 .value = 2
                         },
+                        {
+                                .description = "3",
+                                .value = 3
+                        },
                         {
                                 .description = "4",
                                 .value = 4
                         },
+                        {
+                                .description = "6",
+                                .value = 6
+                        },
+                        {
+                                .description = "8",
+                                .value = 8
+                        },
+                        {
+                                .description = "16",
+                                .value = 16
+                        },
                         {
                                 .description = ""
                         }
                 },
                 .default_int = 2
         },
+        {
+                .name = "texture_cache",
+                .description = "Texture cache size",
+                .type = CONFIG_SELECTION,
+                .selection =
+                {
+                        {
+                                .description = "64 textures",
+                                .value = 64
+                        },
+                        {
+                                .description = "128 textures",
+                                .value = 128
+                        },
+                        {
+                                .description = "256 textures",
+                                .value = 256
+                        },
+                        {
+                                .description = "512 textures",
+                                .value = 512
+                        },
+                        {
+                                .description = ""
+                        }
+                },
+                .default_int = 64
+        },
         {
                 .name = "sli",
                 .description = "SLI",
@@ -684,6 +684,7 @@ static void banshee_ext_outl(uint16_t addr, uint32_t val, void *p)
                 break;
                 case DAC_dacData:
                 svga->pallook[banshee->dacAddr] = val & 0xffffff;
+                svga->render_gen++;
                 svga->fullchange = changeframecount;
                 break;
 
@@ -842,10 +843,12 @@ static uint32_t banshee_status(banshee_t *banshee)
         int swap_count = voodoo->swap_count;
         int written = voodoo->cmd_written + voodoo->cmd_written_fifo;
         int busy = (written - voodoo->cmd_read) || (voodoo->cmdfifo_depth_rd != voodoo->cmdfifo_depth_wr) ||
-                voodoo->render_voodoo_busy[0] || voodoo->render_voodoo_busy[1] ||
-                voodoo->render_voodoo_busy[2] || voodoo->render_voodoo_busy[3] ||
                 voodoo->voodoo_busy;
         uint32_t ret;
+        int c;
+
+        for (c = 0; c < voodoo->render_threads; c++)
+                busy |= voodoo->render_voodoo_busy[c];
 
         ret = 0;
         if (fifo_entries < 0x20)
@@ -2624,6 +2627,10 @@ static const device_config_t banshee_sgram_config[] =
                 .type = CONFIG_SELECTION,
                 .selection =
                 {
+                        {
+                                .description = "Auto",
+                                .value = 0
+                        },
                         {
                                 .description = "1",
                                 .value = 1
@@ -2632,16 +2639,60 @@ static const device_config_t banshee_sgram_config[] =
                                 .description = "2",
                                 .value = 2
                         },
+                        {
+                                .description = "3",
+                                .value = 3
+                        },
                         {
                                 .description = "4",
                                 .value = 4
                         },
+                        {
+                                .description = "6",
+                                .value = 6
+                        },
+                        {
+                                .description = "8",
+                                .value = 8
+                        },
+                        {
+                                .description = "16",
+                                .value = 16
+                        },
                         {
                                 .description = ""
                         }
                 },
                 .default_int = 2
         },
+        {
+                .name = "texture_cache",
+                .description = "Texture cache size",
+                .type = CONFIG_SELECTION,
+                .selection =
+                {
+                        {
+                                .description = "64 textures",
+                                .value = 64
+                        },
+                        {
+                                .description = "128 textures",
+                                .value = 128
+                        },
+                        {
+                                .description = "256 textures",
+                                .value = 256
+                        },
+                        {
+                                .description = "512 textures",
+                                .value = 512
+                        },
+                        {
+                                .description = ""
+                        }
+                },
+                .default_int = 64
+        },
 #ifndef NO_CODEGEN
         {
                 .name = "recompiler",
@@ -2675,6 +2726,10 @@ static const device_config_t banshee_sdram_config[] =
                 .type = CONFIG_SELECTION,
                 .selection =
                 {
+                        {
+                                .description = "Auto",
+                                .value = 0
+                        },
                         {
                                 .description = "1",
                                 .value = 1
@@ -2683,16 +2738,60 @@ static const device_config_t banshee_sdram_config[] =
                                 .description = "2",
                                 .value = 2
                         },
+                        {
+                                .description = "3",
+                                .value = 3
+                        },
                         {
                                 .description = "4",
                                 .value = 4
                         },
+                        {
+                                .description = "6",
+                                .value = 6
+                        },
+                        {
+                                .description = "8",
+                                .value = 8
+                        },
+                        {
+                                .description = "16",
+                                .value = 16
+                        },
                         {
                                 .description = ""
                         }
                 },
                 .default_int = 2
         },
+        {
+                .name = "texture_cache",
+                .description = "Texture cache size",
+                .type = CONFIG_SELECTION,
+                .selection =
+                {
+                        {
+                                .description = "64 textures",
+                                .value = 64
+                        },
+                        {
+                                .description = "128 textures",
+                                .value = 128
+                        },
+                        {
+                                .description = "256 textures",
+                                .value = 256
+                        },
+                        {
+                                .description = "512 textures",
+                                .value = 512
+                        },
+                        {
+                                .description = ""
+                        }
+                },
+                .default_int = 64
+        },
 #ifndef NO_CODEGEN
         {
                 .name = "recompiler",
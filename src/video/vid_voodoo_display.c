@@ -538,7 +538,6 @@ void voodoo_callback(void *p)
                                 if (voodoo->line < voodoo->dirty_line_low)
                                 {
                                         voodoo->dirty_line_low = voodoo->line;
-                                        video_wait_for_buffer();
                                 }
                                 if (voodoo->line > voodoo->dirty_line_high)
                                         voodoo->dirty_line_high = voodoo->line;
@@ -574,6 +573,8 @@ void voodoo_callback(void *p)
 				/* Draw right overscan. */
 				for (x = 0; x < 8; x++)
 					buffer32->line[voodoo->line + 8][voodoo->h_disp + x + 8] = 0x00000000;
+
+                                video_mark_dirty(voodoo->line + 8, voodoo->line + 9);
                         }
                 }
         }
@@ -654,6 +655,8 @@ skip_draw:
                         }
                         thread_release_mutex(voodoo->force_blit_mutex);
 
+                        if (force_blit)
+                                video_mark_dirty(0, voodoo->v_disp + 16);
                         if (voodoo->dirty_line_high > voodoo->dirty_line_low || force_blit)
                                 svga_doblit(0, voodoo->v_disp, voodoo->h_disp, voodoo->v_disp-1, voodoo->svga);
                         if (voodoo->clutData_dirty)
@@ -258,6 +258,7 @@ static inline void tex_read(voodoo_state_t *state, voodoo_texture_state_t *textu
 static inline void tex_read_4(voodoo_state_t *state, voodoo_texture_state_t *texture_state, int s, int t, int *d, int tmu, int x)
 {
         rgba_u dat[4];
+        uint64_t sum;
 
         if (((s | (s + 1)) & ~texture_state->w_mask) || ((t | (t + 1)) & ~texture_state->h_mask))
         {
@@ -302,10 +303,12 @@ static inline void tex_read_4(voodoo_state_t *state, voodoo_texture_state_t *tex
                 dat[3].u = state->tex[tmu][state->lod][s + 1 + ((t + 1) << texture_state->tex_shift)];
         }
 
-        state->tex_r[tmu] = (dat[0].rgba.r * d[0] + dat[1].rgba.r * d[1] + dat[2].rgba.r * d[2] + dat[3].rgba.r * d[3]) >> 8;
-        state->tex_g[tmu] = (dat[0].rgba.g * d[0] + dat[1].rgba.g * d[1] + dat[2].rgba.g * d[2] + dat[3].rgba.g * d[3]) >> 8;
-        state->tex_b[tmu] = (dat[0].rgba.b * d[0] + dat[1].rgba.b * d[1] + dat[2].rgba.b * d[2] + dat[3].rgba.b * d[3]) >> 8;
-        state->tex_a[tmu] = (dat[0].rgba.a * d[0] + dat[1].rgba.a * d[1] + dat[2].rgba.a * d[2] + dat[3].rgba.a * d[3]) >> 8;
+        sum = voodoo_bilinear(dat, d);
+
+        state->tex_b[tmu] = (sum >>  8) & 0xff;
+        state->tex_g[tmu] = (sum >> 24) & 0xff;
+        state->tex_r[tmu] = (sum >> 40) & 0xff;
+        state->tex_a[tmu] = (sum >> 56) & 0xff;
 }
 
 static inline void voodoo_get_texture(voodoo_t *voodoo, voodoo_params_t *params, voodoo_state_t *state, int tmu, int x)
@@ -688,10 +691,18 @@ static inline void voodoo_tmu_fetch_and_blend(voodoo_t *voodoo, voodoo_params_t
 #include <86box/vid_voodoo_codegen_x86.h>
 #elif (defined __amd64__ || defined _M_X64)
 #include <86box/vid_voodoo_codegen_x86-64.h>
-#else
-int voodoo_recomp = 0;
 #endif
 
+/*Render thread that draws the given screen line. Lines are dealt out in turn,
+  or in pairs when SLI is enabled as each board only draws every other line.*/
+static __inline int voodoo_line_thread(voodoo_t *voodoo, int real_y)
+{
+        if (SLI_ENABLED)
+                real_y >>= 1;
+
+        return (unsigned int)real_y % (unsigned int)voodoo->render_threads;
+}
+
 static void voodoo_half_triangle(voodoo_t *voodoo, voodoo_params_t *params, voodoo_state_t *state, int ystart, int yend, int odd_even)
 {
 /*        int rgb_sel                 = params->fbzColorPath & 3;
@@ -856,16 +867,8 @@ static void voodoo_half_triangle(voodoo_t *voodoo, voodoo_params_t *params, vood
                 else
                         real_y >>= 4;
 
-                if (SLI_ENABLED)
-                {
-                        if (((real_y >> 1) & voodoo->odd_even_mask) != odd_even)
-                                goto next_line;
-                }
-                else
-                {
-                        if ((real_y & voodoo->odd_even_mask) != odd_even)
-                                goto next_line;
-                }
+                if (voodoo_line_thread(voodoo, real_y) != odd_even)
+                        goto next_line;
 
                 start_x = x;
 
@@ -1587,9 +1590,11 @@ void voodoo_triangle(voodoo_t *voodoo, voodoo_params_t *params, int odd_even)
 }
 
 
-static void render_thread(void *param, int odd_even)
+void voodoo_render_thread(void *param)
 {
-        voodoo_t *voodoo = (voodoo_t *)param;
+        voodoo_render_thread_t *thread = (voodoo_render_thread_t *)param;
+        voodoo_t *voodoo = thread->voodoo;
+        int odd_even = thread->odd_even;
 
         while (1)
         {
@@ -1604,7 +1609,14 @@ static void render_thread(void *param, int odd_even)
                         uint64_t end_time;
                         voodoo_params_t *params = &voodoo->params_buffer[voodoo->params_read_idx[odd_even] & PARAM_MASK];
 
-                        voodoo_triangle(voodoo, params, odd_even);
+                        if (params->render_mask & (1 << odd_even))
+                                voodoo_triangle(voodoo, params, odd_even);
+                        else
+                        {
+                                /*None of this triangle's lines are ours*/
+                                voodoo->texture_cache[0][params->tex_entry[0]].refcount_r[odd_even]++;
+                                voodoo->texture_cache[1][params->tex_entry[1]].refcount_r[odd_even]++;
+                        }
 
                         voodoo->params_read_idx[odd_even]++;
 
@@ -1619,46 +1631,44 @@ static void render_thread(void *param, int odd_even)
         }
 }
 
-void voodoo_render_thread_1(void *param)
+/*Work out which render threads own any of the lines the triangle covers. This
+  walks the same lines as voodoo_triangle(), without the clip rectangle, so the
+  mask can only ever be too wide.*/
+static uint32_t voodoo_triangle_threads(voodoo_t *voodoo, voodoo_params_t *params)
 {
-        render_thread(param, 0);
-}
-void voodoo_render_thread_2(void *param)
-{
-        render_thread(param, 1);
-}
-void voodoo_render_thread_3(void *param)
-{
-        render_thread(param, 2);
-}
-void voodoo_render_thread_4(void *param)
-{
-        render_thread(param, 3);
+        int32_t vertexAy = (int16_t)(params->vertexAy & 0xffff);
+        int32_t vertexCy = (int16_t)(params->vertexCy & 0xffff);
+        int ystart = (vertexAy + 7) >> 4;
+        int yend = (vertexCy + 7) >> 4;
+        uint32_t mask = 0;
+        int y;
+
+        if ((yend - ystart) >= (voodoo->render_threads * (SLI_ENABLED ? 2 : 1)))
+                return (1 << voodoo->render_threads) - 1;
+
+        for (y = ystart; y < yend; y++)
+        {
+                int real_y = (params->fbzMode & (1 << 17)) ? ((voodoo->v_disp-1) - y) : y;
+
+                mask |= 1 << voodoo_line_thread(voodoo, real_y);
+        }
+
+        return mask;
 }
 
 void voodoo_queue_triangle(voodoo_t *voodoo, voodoo_params_t *params)
 {
         voodoo_params_t *params_new = &voodoo->params_buffer[voodoo->params_write_idx & PARAM_MASK];
+        int c;
 
-        while (PARAM_FULL(0) || (voodoo->render_threads >= 2 && PARAM_FULL(1)) ||
-                (voodoo->render_threads == 4 && (PARAM_FULL(2) || PARAM_FULL(3))))
+        for (c = 0; c < voodoo->render_threads; c++)
         {
-                thread_reset_event(voodoo->render_not_full_event[0]);
-                if (voodoo->render_threads >= 2)
-                        thread_reset_event(voodoo->render_not_full_event[1]);
-                if (voodoo->render_threads == 4)
+                while (PARAM_FULL(c))
                 {
-                        thread_reset_event(voodoo->render_not_full_event[2]);
-                        thread_reset_event(voodoo->render_not_full_event[3]);
+                        thread_reset_event(voodoo->render_not_full_event[c]);
+                        if (PARAM_FULL(c))
+                                thread_wait_event(voodoo->render_not_full_event[c], -1); /*Wait for room in ringbuffer*/
                 }
-                if (PARAM_FULL(0))
-                        thread_wait_event(voodoo->render_not_full_event[0], -1); /*Wait for room in ringbuffer*/
-                if (voodoo->render_threads >= 2 && PARAM_FULL(1))
-                        thread_wait_event(voodoo->render_not_full_event[1], -1); /*Wait for room in ringbuffer*/
-                if (voodoo->render_threads == 4 && PARAM_FULL(2))
-                        thread_wait_event(voodoo->render_not_full_event[2], -1); /*Wait for room in ringbuffer*/
-                if (voodoo->render_threads == 4 && PARAM_FULL(3))
-                        thread_wait_event(voodoo->render_not_full_event[3], -1); /*Wait for room in ringbuffer*/
         }
 
         voodoo_use_texture(voodoo, params, 0);
@@ -1666,10 +1676,16 @@ void voodoo_queue_triangle(voodoo_t *voodoo, voodoo_params_t *params)
                 voodoo_use_texture(voodoo, params, 1);
 
         memcpy(params_new, params, sizeof(voodoo_params_t));
+        params_new->render_mask = voodoo_triangle_threads(voodoo, params_new);
 
         voodoo->params_write_idx++;
 
-        if (PARAM_ENTRIES(0) < 4 || (voodoo->render_threads >= 2 && PARAM_ENTRIES(1) < 4) ||
-                        (voodoo->render_threads == 4 && (PARAM_ENTRIES(2) < 4 || PARAM_ENTRIES(3) < 4)))
-                voodoo_wake_render_thread(voodoo);
+        for (c = 0; c < voodoo->render_threads; c++)
+        {
+                if (PARAM_ENTRIES(c) < 4)
+                {
+                        voodoo_wake_render_thread(voodoo);
+                        break;
+                }
+        }
 }
@@ -56,6 +56,19 @@ voodoo_texture_log(const char *fmt, ...)
 #define voodoo_texture_log(fmt, ...)
 #endif
 
+/*Returns non-zero if any render thread still has a queued triangle using tex*/
+static __inline int voodoo_texture_in_use(voodoo_t *voodoo, texture_t *tex)
+{
+        int c;
+
+        for (c = 0; c < voodoo->render_threads; c++)
+        {
+                if (tex->refcount != tex->refcount_r[c])
+                        return 1;
+        }
+
+        return 0;
+}
 
 void voodoo_recalc_tex(voodoo_t *voodoo, int tmu)
 {
@@ -158,13 +171,110 @@ void voodoo_recalc_tex(voodoo_t *voodoo, int tmu)
 
 #define makergba(r, g, b, a)  ((b) | ((g) << 8) | ((r) << 16) | ((a) << 24))
 
+#define TEX_DATA_SIZE ((256*256 + 256*256 + 128*128 + 64*64 + 32*32 + 16*16 + 8*8 + 4*4 + 2*2) * 4)
+
+void voodoo_texture_cache_init(voodoo_t *voodoo, int size)
+{
+        int tmu, c;
+
+        if (size < TEX_CACHE_DEFAULT || size > TEX_CACHE_MAX || (size & (size - 1)))
+                size = TEX_CACHE_DEFAULT;
+        voodoo->texture_cache_size = size;
+        voodoo->texture_cache_mem = 0;
+
+        /*The render threads touch the TMU 1 entries even on single TMU boards,
+          so both sets are always allocated*/
+        for (tmu = 0; tmu < 2; tmu++)
+        {
+                voodoo->texture_cache[tmu] = malloc(size * sizeof(texture_t));
+                memset(voodoo->texture_cache[tmu], 0, size * sizeof(texture_t));
+
+                /*Decoded data is allocated when an entry is first used, so
+                  a large cache only costs memory if something fills it*/
+                for (c = 0; c < size; c++)
+                        voodoo->texture_cache[tmu][c].base = -1; /*invalid*/
+        }
+}
+
+void voodoo_texture_cache_close(voodoo_t *voodoo)
+{
+        int tmu, c;
+
+        for (tmu = 0; tmu < 2; tmu++)
+        {
+                if (!voodoo->texture_cache[tmu])
+                        continue;
+
+                for (c = 0; c < voodoo->texture_cache_size; c++)
+                        free(voodoo->texture_cache[tmu][c].data);
+                free(voodoo->texture_cache[tmu]);
+                voodoo->texture_cache[tmu] = NULL;
+        }
+}
+
+/*Hash of the texture memory a cache entry was decoded from. This is taken a
+  word at a time, so may cover a few bytes either side of the texture.*/
+static uint64_t voodoo_texture_hash(voodoo_t *voodoo, int tmu, texture_t *tex)
+{
+        uint64_t hash = 0xcbf29ce484222325ull;
+        int d;
+
+        for (d = 0; d < 4; d++)
+        {
+                uint32_t addr = tex->addr_start[d] & ~3;
+                uint32_t addr_end = tex->addr_end[d];
+                uint32_t len;
+
+                if (!addr_end)
+                        continue;
+
+                len = addr_end - addr;
+                if (len > voodoo->texture_mask)
+                        len = voodoo->texture_mask;
+                for (addr_end = addr + len; addr <= addr_end; addr += 4)
+                {
+                        hash ^= *(uint32_t *)&voodoo->tex_mem[tmu][addr & voodoo->texture_mask];
+                        hash *= 0x100000001b3ull;
+                }
+        }
+
+        return hash;
+}
+
+static void voodoo_texture_mark_present(voodoo_t *voodoo, int tmu, texture_t *tex)
+{
+        int d;
+
+        for (d = 0; d < 4; d++)
+        {
+                uint32_t addr = tex->addr_start[d];
+                uint32_t addr_end = tex->addr_end[d];
+
+                if (addr_end != 0)
+                {
+                        for (; addr <= addr_end; addr += (1 << TEX_DIRTY_SHIFT))
+                                voodoo->texture_present[tmu][(addr & voodoo->texture_mask) >> TEX_DIRTY_SHIFT] = 1;
+                }
+        }
+}
+
 void voodoo_use_texture(voodoo_t *voodoo, voodoo_params_t *params, int tmu)
 {
-        int c, d;
+        int c;
         int lod;
         int lod_min, lod_max;
-        uint32_t addr = 0, addr_end;
+        uint32_t addr = 0;
         uint32_t palette_checksum;
+        texture_t *tex;
+
+        if (voodoo->tex_frame != voodoo->frame_count)
+        {
+                voodoo_texture_log("Texture cache: %i decodes, %i hash hits, %u KB decoded\n", voodoo->tex_decodes, voodoo->tex_hash_hits, voodoo->texture_cache_mem >> 10);
+                voodoo->tex_decodes_last = voodoo->tex_decodes;
+                voodoo->tex_hash_hits_last = voodoo->tex_hash_hits;
+                voodoo->tex_decodes = voodoo->tex_hash_hits = 0;
+                voodoo->tex_frame = voodoo->frame_count;
+        }
 
         lod_min = (params->tLOD[tmu] >> 2) & 15;
         lod_max = (params->tLOD[tmu] >> 8) & 15;
@@ -193,14 +303,30 @@ void voodoo_use_texture(voodoo_t *voodoo, voodoo_params_t *params, int tmu)
                 addr = params->texBaseAddr[tmu];
 
         /*Try to find texture in cache*/
-        for (c = 0; c < TEX_CACHE_MAX; c++)
+        for (c = 0; c < voodoo->texture_cache_size; c++)
         {
-                if (voodoo->texture_cache[tmu][c].base == addr &&
-                    voodoo->texture_cache[tmu][c].tLOD == (params->tLOD[tmu] & 0xf00fff) &&
-                    voodoo->texture_cache[tmu][c].palette_checksum == palette_checksum)
+                tex = &voodoo->texture_cache[tmu][c];
+
+                if (tex->base == addr &&
+                    tex->tLOD == (params->tLOD[tmu] & 0xf00fff) &&
+                    tex->palette_checksum == palette_checksum)
                 {
+                        if (tex->dirty)
+                        {
+                                /*Texture memory under this entry has been written
+                                  since it was decoded. If the contents didn't
+                                  change then the decoded copy is still good.*/
+                                tex->dirty = 0;
+                                if (voodoo_texture_hash(voodoo, tmu, tex) != tex->hash)
+                                {
+                                        tex->base = -1;
+                                        break;
+                                }
+                                voodoo_texture_mark_present(voodoo, tmu, tex);
+                                voodoo->tex_hash_hits++;
+                        }
                         params->tex_entry[tmu] = c;
-                        voodoo->texture_cache[tmu][c].refcount++;
+                        tex->refcount++;
                         return;
                 }
         }
@@ -208,21 +334,26 @@ void voodoo_use_texture(voodoo_t *voodoo, voodoo_params_t *params, int tmu)
         /*Texture not found, search for unused texture*/
         do
         {
-                for (c = 0; c < TEX_CACHE_MAX; c++)
+                for (c = 0; c < voodoo->texture_cache_size; c++)
                 {
                         voodoo->texture_last_removed++;
-                        voodoo->texture_last_removed &= (TEX_CACHE_MAX-1);
-                        if (voodoo->texture_cache[tmu][voodoo->texture_last_removed].refcount == voodoo->texture_cache[tmu][voodoo->texture_last_removed].refcount_r[0] &&
-                            (voodoo->render_threads == 1 || voodoo->texture_cache[tmu][voodoo->texture_last_removed].refcount == voodoo->texture_cache[tmu][voodoo->texture_last_removed].refcount_r[1]))
+                        voodoo->texture_last_removed &= (voodoo->texture_cache_size-1);
+                        if (!voodoo_texture_in_use(voodoo, &voodoo->texture_cache[tmu][voodoo->texture_last_removed]))
                                 break;
                 }
-                if (c == TEX_CACHE_MAX)
+                if (c == voodoo->texture_cache_size)
                         voodoo_wait_for_render_thread_idle(voodoo);
-        } while (c == TEX_CACHE_MAX);
-        if (c == TEX_CACHE_MAX)
-                fatal("Texture cache full!\n");
+        } while (c == voodoo->texture_cache_size);
 
         c = voodoo->texture_last_removed;
+        tex = &voodoo->texture_cache[tmu][c];
+        if (!tex->data)
+        {
+                tex->data = malloc(TEX_DATA_SIZE);
+                voodoo->texture_cache_mem += TEX_DATA_SIZE;
+        }
+        tex->dirty = 0;
+        voodoo->tex_decodes++;
 
 
         if ((voodoo->params.tLOD[tmu] & LOD_SPLIT) && (voodoo->params.tLOD[tmu] & LOD_ODD) && (voodoo->params.tLOD[tmu] & LOD_TMULTIBASEADDR))
@@ -499,18 +630,8 @@ void voodoo_use_texture(voodoo_t *voodoo, voodoo_params_t *params, int tmu)
         else
                 voodoo->texture_cache[tmu][c].addr_start[3] = voodoo->texture_cache[tmu][c].addr_end[3] = 0;
 
-
-        for (d = 0; d < 4; d++)
-        {
-                addr = voodoo->texture_cache[tmu][c].addr_start[d];
-                addr_end = voodoo->texture_cache[tmu][c].addr_end[d];
-
-                if (addr_end != 0)
-                {
-                        for (; addr <= addr_end; addr += (1 << TEX_DIRTY_SHIFT))
-                                voodoo->texture_present[tmu][(addr & voodoo->texture_mask) >> TEX_DIRTY_SHIFT] = 1;
-                }
-        }
+        tex->hash = voodoo_texture_hash(voodoo, tmu, tex);
+        voodoo_texture_mark_present(voodoo, tmu, tex);
 
         params->tex_entry[tmu] = c;
         voodoo->texture_cache[tmu][c].refcount++;
@@ -523,9 +644,9 @@ void flush_texture_cache(voodoo_t *voodoo, uint32_t dirty_addr, int tmu)
 
         memset(voodoo->texture_present[tmu], 0, sizeof(voodoo->texture_present[0]));
 //        voodoo_texture_log("Evict %08x %i\n", dirty_addr, sizeof(voodoo->texture_present));
-        for (c = 0; c < TEX_CACHE_MAX; c++)
+        for (c = 0; c < voodoo->texture_cache_size; c++)
         {
-                if (voodoo->texture_cache[tmu][c].base != -1)
+                if (voodoo->texture_cache[tmu][c].base != -1 && !voodoo->texture_cache[tmu][c].dirty)
                 {
                         int d;
 
@@ -545,11 +666,12 @@ void flush_texture_cache(voodoo_t *voodoo, uint32_t dirty_addr, int tmu)
                                         {
 //                                voodoo_texture_log("  Evict texture %i %08x\n", c, voodoo->texture_cache[tmu][c].base);
 
-                                                if (voodoo->texture_cache[tmu][c].refcount != voodoo->texture_cache[tmu][c].refcount_r[0] ||
-                                                    (voodoo->render_threads == 2 && voodoo->texture_cache[tmu][c].refcount != voodoo->texture_cache[tmu][c].refcount_r[1]))
+                                                if (voodoo_texture_in_use(voodoo, &voodoo->texture_cache[tmu][c]))
                                                         wait_for_idle = 1;
 
-                                                voodoo->texture_cache[tmu][c].base = -1;
+                                                /*Keep the decoded copy, it is checked against
+                                                  the new contents on next use*/
+                                                voodoo->texture_cache[tmu][c].dirty = 1;
                                         }
                                         else
                                         {
@@ -243,21 +243,54 @@ const uint32_t shade[5][256] =
 };
 
 
+/* The emulated display and the blit thread hand frames over through a set of
+   buffers, so the emulation thread never waits on the presenter: it always has
+   a buffer of its own to copy the next frame into. A finished frame that the
+   presenter has not picked up yet is replaced by the next one, and counted as
+   dropped. */
+#define VIDEO_BUFFERS	3
+#define VIDEO_LINES	2112
+
+
+typedef struct {
+    bitmap_t	*bmp;
+    int		x, y, w, h;
+
+    int		nspans;
+    video_span_t spans[VIDEO_BLIT_SPANS];
+
+    /* Lines of buffer32 that changed since this buffer was last written. */
+    uint32_t	stale[VIDEO_LINES >> 5];
+    /* Rows of the buffer not yet presented, including those of any frames
+       dropped in favour of this one. */
+    uint32_t	unshown[VIDEO_LINES >> 5];
+} video_frame_t;
+
+
 static struct {
-    int		x, y, y1, y2, w, h;
+    video_frame_t frames[VIDEO_BUFFERS];
+    int		write, ready, present, shown;
     int		busy;
-    int		buffer_in_use;
+
+    uint64_t	frames_shown, frames_dropped;
 
     thread_t	*blit_thread;
     event_t	*wake_blit_thread;
     event_t	*blit_complete;
-    event_t	*buffer_not_in_use;
+    mutex_t	*mutex;
 }		blit_data;
 
 
 static void (*blit_func)(int x, int y, int y1, int y2, int w, int h);
 
 
+/* Lines of buffer32 written since the last blit, one bit per line. Renderers
+   that report what they draw through video_mark_dirty() and blit with
+   video_blit_memtoscreen_dirty() only get those lines copied and passed on;
+   for everything else, the whole y1-y2 range is. */
+static uint32_t	dirty_lines[VIDEO_LINES >> 5];
+
+
 #ifdef ENABLE_VIDEO_LOG
 int sdl_do_log = ENABLE_VIDEO_LOG;
 
@@ -278,21 +311,90 @@ video_log(const char *fmt, ...)
 #endif
 
 
+static int
+video_add_span(video_span_t *spans, int nspans, int yy)
+{
+    if (nspans && (spans[nspans - 1].y2 == yy)) {
+	spans[nspans - 1].y2++;
+	return nspans;
+    }
+
+    /* Out of spans, grow the last one over the gap instead. */
+    if (nspans == VIDEO_BLIT_SPANS) {
+	spans[nspans - 1].y2 = yy + 1;
+	return nspans;
+    }
+
+    spans[nspans].y1 = yy;
+    spans[nspans].y2 = yy + 1;
+
+    return nspans + 1;
+}
+
+
+/* Takes the most recent finished frame for presentation, if there is one. */
+static video_frame_t *
+video_take_frame(void)
+{
+    video_frame_t *frame = NULL;
+
+    thread_wait_mutex(blit_data.mutex);
+    if (blit_data.ready != -1) {
+	blit_data.present = blit_data.shown = blit_data.ready;
+	blit_data.ready = -1;
+	frame = &blit_data.frames[blit_data.present];
+    } else
+	blit_data.busy = 0;
+    thread_release_mutex(blit_data.mutex);
+
+    return frame;
+}
+
+
+/* Releases the buffer being presented, which may then be reused for a later
+   frame. The blit callback is done with render_buffer once it returns. */
+static void
+video_blit_complete(void)
+{
+    thread_wait_mutex(blit_data.mutex);
+    blit_data.present = -1;
+    thread_release_mutex(blit_data.mutex);
+}
+
+
 static
 void blit_thread(void *param)
 {
+    video_frame_t *frame;
+    int yy;
+
     while (1) {
 	thread_wait_event(blit_data.wake_blit_thread, -1);
 	thread_reset_event(blit_data.wake_blit_thread);
+
+	while ((frame = video_take_frame()) != NULL) {
     MTR_BEGIN("video", "blit_thread");
+		frame->nspans = 0;
+		for (yy = 0; yy < VIDEO_LINES; yy++) {
+			if (frame->unshown[yy >> 5] & (1U << (yy & 31)))
+				frame->nspans = video_add_span(frame->spans, frame->nspans, yy);
+		}
+		memset(frame->unshown, 0x00, sizeof(frame->unshown));
 
-	if (blit_func)
-		blit_func(blit_data.x, blit_data.y,
-			  blit_data.y1, blit_data.y2,
-			  blit_data.w, blit_data.h);
+		blit_data.frames_shown++;
+		render_buffer = frame->bmp;
 
-	blit_data.busy = 0;
+		if (blit_func && frame->nspans)
+			blit_func(frame->x, frame->y,
+				  frame->spans[0].y1, frame->spans[frame->nspans - 1].y2,
+				  frame->w, frame->h);
+		else if (blit_func)
+			blit_func(frame->x, frame->y, 0, 0, frame->w, frame->h);
+
+		video_blit_complete();
     MTR_END("video", "blit_thread");
+	}
+
 	thread_set_event(blit_data.blit_complete);
     }
 }
@@ -306,29 +408,49 @@ video_setblit(void(*blit)(int,int,int,int,int,int))
 
 
 void
-video_blit_complete(void)
+video_mark_dirty(int y1, int y2)
 {
-    blit_data.buffer_in_use = 0;
+    int y;
+
+    if (y1 < 0)
+	y1 = 0;
+    if (y2 > VIDEO_LINES)
+	y2 = VIDEO_LINES;
 
-    thread_set_event(blit_data.buffer_not_in_use);
+    for (y = y1; y < y2; y++)
+	dirty_lines[y >> 5] |= (1U << (y & 31));
+}
+
+
+/* Returns the render_buffer row spans updated for the blit in progress. These
+   cover every frame dropped since the last blit, and stay valid until the blit
+   callback returns. */
+int
+video_blit_get_spans(const video_span_t **spans)
+{
+    video_frame_t *frame = &blit_data.frames[blit_data.shown];
+
+    *spans = frame->spans;
+
+    return frame->nspans;
 }
 
 
 void
-video_wait_for_blit(void)
+video_get_frame_stats(uint64_t *shown, uint64_t *dropped)
 {
-    while (blit_data.busy)
-	thread_wait_event(blit_data.blit_complete, -1);
-    thread_reset_event(blit_data.blit_complete);
+    *shown = blit_data.frames_shown;
+    *dropped = blit_data.frames_dropped;
 }
 
 
+/* Waits for every finished frame to have been presented. */
 void
-video_wait_for_buffer(void)
+video_wait_for_blit(void)
 {
-    while (blit_data.buffer_in_use)
-	thread_wait_event(blit_data.buffer_not_in_use, -1);
-    thread_reset_event(blit_data.buffer_not_in_use);
+    while (blit_data.busy)
+	thread_wait_event(blit_data.blit_complete, -1);
+    thread_reset_event(blit_data.blit_complete);
 }
 
 
@@ -383,7 +505,7 @@ video_take_screenshot(const wchar_t *fn, int startx, int starty, int y1, int y2,
     for (y = 0; y < h; ++y) {
 	b_rgb[y] = (png_byte *) malloc(png_get_rowbytes(png_ptr, info_ptr));
     	for (x = 0; x < w; ++x) {
-		temp = render_buffer->dat[(y * w) + x];
+		temp = blit_data.frames[blit_data.write].bmp->dat[(y * w) + x];
 
 		b_rgb[y][(x) * 3 + 0] = (temp >> 16) & 0xff;
 		b_rgb[y][(x) * 3 + 1] = (temp >> 8) & 0xff;
@@ -445,26 +567,45 @@ video_transform_copy(uint32_t *dst, uint32_t *src, int len)
 }
 
 
-void
-video_blit_memtoscreen(int x, int y, int y1, int y2, int w, int h)
+static void
+video_blit_lines(int x, int y, int y1, int y2, int w, int h, int dirty)
 {
-    int yy;
-    MTR_BEGIN("video", "video_blit_memtoscreen");
+    video_frame_t *frame = &blit_data.frames[blit_data.write];
+    bitmap_t *b = frame->bmp;
+    uint32_t bit;
+    int i, yy, line;
+    MTR_BEGIN("video", "video_blit_lines");
 
     if (y2 > 0) {
 	for (yy = y1; yy < y2; yy++) {
-		if (((y + yy) >= 0) && ((y + yy) < buffer32->h)) {
-			if (video_grayscale || invert_display)
-				video_transform_copy(&(render_buffer->dat)[yy * w], &(buffer32->line[y + yy][x]), w);
-			else
-				memcpy(&(render_buffer->dat)[yy * w], &(buffer32->line[y + yy][x]), w << 2);
+		line = y + yy;
+		if ((line < 0) || (line >= buffer32->h) || (yy < 0) || (yy >= VIDEO_LINES))
+			continue;
+
+		/* Lines changed in earlier frames that went to the other buffers
+		   have to be brought up to date as well. */
+		bit = 1U << (line & 31);
+		if (dirty && !((dirty_lines[line >> 5] | frame->stale[line >> 5]) & bit))
+			continue;
+
+		if (video_grayscale || invert_display)
+			video_transform_copy(&(b->dat)[yy * w], &(buffer32->line[line][x]), w);
+		else
+			memcpy(&(b->dat)[yy * w], &(buffer32->line[line][x]), w << 2);
+
+		frame->stale[line >> 5] &= ~bit;
+		for (i = 0; i < VIDEO_BUFFERS; i++) {
+			if (i != blit_data.write)
+				blit_data.frames[i].stale[line >> 5] |= bit;
 		}
+		frame->unshown[yy >> 5] |= (1U << (yy & 31));
 	}
     }
 
+    memset(dirty_lines, 0x00, sizeof(dirty_lines));
+
     if (screenshots) {
-	if (render_buffer != NULL)
-		video_screenshot(x, y, y1, y2, w, h);
+	video_screenshot(x, y, y1, y2, w, h);
 	screenshots--;
 	video_log("screenshot taken, %i left\n", screenshots);
     }
@@ -472,19 +613,46 @@ video_blit_memtoscreen(int x, int y, int y1, int y2, int w, int h)
     if ((w <= 0) || (h <= 0))
 	return;
 
-    video_wait_for_blit();
-
+    frame->x = x;
+    frame->y = y;
+    frame->w = w;
+    frame->h = h;
+
+    /* Publish the frame. If the previous one was never picked up, it is
+       dropped and this one takes its place, along with its unshown rows. The
+       buffer to write next is one the presenter is not using. */
+    thread_wait_mutex(blit_data.mutex);
+    if (blit_data.ready != -1) {
+	for (i = 0; i < (VIDEO_LINES >> 5); i++)
+		frame->unshown[i] |= blit_data.frames[blit_data.ready].unshown[i];
+	blit_data.frames_dropped++;
+    }
+    blit_data.ready = blit_data.write;
+    for (i = 0; i < VIDEO_BUFFERS; i++) {
+	if ((i != blit_data.ready) && (i != blit_data.present))
+		break;
+    }
+    blit_data.write = i;
     blit_data.busy = 1;
-    blit_data.buffer_in_use = 1;
-    blit_data.x = x;
-    blit_data.y = y;
-    blit_data.y1 = y1;
-    blit_data.y2 = y2;
-    blit_data.w = w;
-    blit_data.h = h;
+    thread_release_mutex(blit_data.mutex);
 
     thread_set_event(blit_data.wake_blit_thread);
-    MTR_END("video", "video_blit_memtoscreen");
+    MTR_END("video", "video_blit_lines");
+}
+
+void
+video_blit_memtoscreen(int x, int y, int y1, int y2, int w, int h)
+{
+    video_blit_lines(x, y, y1, y2, w, h, 0);
+}
+
+
+/* As video_blit_memtoscreen(), but only copies the lines of y1-y2 that were
+   marked with video_mark_dirty() since the last blit. */
+void
+video_blit_memtoscreen_dirty(int x, int y, int y1, int y2, int w, int h)
+{
+    video_blit_lines(x, y, y1, y2, w, h, 1);
 }
 
 
@@ -830,7 +998,13 @@ video_init(void)
 
     /* Account for overscan. */
     buffer32 = create_bitmap(2048 + 64, 2048 + 64);
-    render_buffer = create_bitmap(2048 + 64, 2048 + 64);
+    for (c = 0; c < VIDEO_BUFFERS; c++) {
+	blit_data.frames[c].bmp = create_bitmap(2048 + 64, 2048 + 64);
+	memset(blit_data.frames[c].stale, 0xff, sizeof(blit_data.frames[c].stale));
+	memset(blit_data.frames[c].unshown, 0x00, sizeof(blit_data.frames[c].unshown));
+	blit_data.frames[c].nspans = 0;
+    }
+    render_buffer = blit_data.frames[0].bmp;
 
     for (c = 0; c < 64; c++) {
 	cgapal[c + 64].r = (((c & 4) ? 2 : 0) | ((c & 0x10) ? 1 : 0)) * 21;
@@ -875,9 +1049,13 @@ video_init(void)
     for (c = 0; c < 65536; c++)
 	video_16to32[c] = calc_16to32(c);
 
+    blit_data.write = 0;
+    blit_data.ready = blit_data.present = -1;
+    blit_data.shown = 0;
+    blit_data.frames_shown = blit_data.frames_dropped = 0;
+    blit_data.mutex = thread_create_mutex();
     blit_data.wake_blit_thread = thread_create_event();
     blit_data.blit_complete = thread_create_event();
-    blit_data.buffer_not_in_use = thread_create_event();
     blit_data.blit_thread = thread_create(blit_thread, NULL);
 }
 
@@ -885,10 +1063,12 @@ video_init(void)
 void
 video_close(void)
 {
+    int c;
+
     thread_kill(blit_data.blit_thread);
-    thread_destroy_event(blit_data.buffer_not_in_use);
     thread_destroy_event(blit_data.blit_complete);
     thread_destroy_event(blit_data.wake_blit_thread);
+    thread_close_mutex(blit_data.mutex);
 
     free(video_16to32);
     free(video_15to32);
@@ -896,7 +1076,9 @@ video_close(void)
     free(video_8togs);
     free(video_6to8);
 
-    destroy_bitmap(render_buffer);
+    for (c = 0; c < VIDEO_BUFFERS; c++)
+	destroy_bitmap(blit_data.frames[c].bmp);
+    render_buffer = NULL;
     destroy_bitmap(buffer32);
 
     if (fontdatksc5601) {
@@ -42,6 +42,7 @@
 static rfbScreenInfoPtr	rfb = NULL;
 static int	clients;
 static int	updatingSize;
+static int	fullUpdate;
 static int	allowedX,
 		allowedY;
 static int	ptr_x, ptr_y, ptr_but;
@@ -169,20 +170,42 @@ vnc_display(rfbClientPtr cl)
 static void
 vnc_blit(int x, int y, int y1, int y2, int w, int h)
 {
+    const video_span_t *spans;
     uint32_t *p;
-    int yy;
+    int i, nspans, yy;
 
-    for (yy=y1; yy<y2; yy++) {
-	p = (uint32_t *)&(((uint32_t *)rfb->frameBuffer)[yy*VNC_MAX_X]);
+    /* Only the rows that changed are copied and sent to the clients. */
+    nspans = video_blit_get_spans(&spans);
 
-	if ((y+yy) >= 0 && (y+yy) < VNC_MAX_Y)
-		memcpy(p, &(render_buffer->dat[yy * w]), w*4);
+    for (i=0; i<nspans; i++) {
+	for (yy=spans[i].y1; yy<spans[i].y2; yy++) {
+		p = (uint32_t *)&(((uint32_t *)rfb->frameBuffer)[yy*VNC_MAX_X]);
+
+		if ((y+yy) >= 0 && (y+yy) < VNC_MAX_Y)
+			memcpy(p, &(render_buffer->dat[yy * w]), w*4);
+	}
+    }
+
+    /* Updates made while a resize is pending are not sent, so resend the
+       whole screen once it is done. */
+    if (updatingSize) {
+	fullUpdate = 1;
+	return;
     }
- 
-    video_blit_complete();
 
-    if (! updatingSize)
+    if (fullUpdate) {
 	rfbMarkRectAsModified(rfb, 0,0, allowedX,allowedY);
+	fullUpdate = 0;
+	return;
+    }
+
+    for (i=0; i<nspans; i++) {
+	if ((spans[i].y1 < 0) || (spans[i].y1 >= allowedY))
+		continue;
+
+	rfbMarkRectAsModified(rfb, 0,spans[i].y1, allowedX,
+			      (spans[i].y2 < allowedY) ? spans[i].y2 : allowedY);
+    }
 }
 
 
@@ -280,6 +303,7 @@ vnc_resize(int x, int y)
  
 	rfb->width = x;
 	rfb->height = y;
+	fullUpdate = 1;
  
 	iterator = rfbGetClientIterator(rfb);
 	while ((cl = rfbClientIteratorNext(iterator)) != NULL) {
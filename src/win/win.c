@@ -746,6 +746,18 @@ plat_delay_ms(uint32_t count)
 }
 
 
+/* Return the number of logical processors on the host. */
+int
+plat_get_cpu_count(void)
+{
+    SYSTEM_INFO si;
+
+    GetSystemInfo(&si);
+
+    return((si.dwNumberOfProcessors > 0) ? (int)si.dwNumberOfProcessors : 1);
+}
+
+
 /* Return the VIDAPI number for the given name. */
 int
 plat_vidapi(char *name)
@@ -231,22 +231,24 @@ sdl_stretch(int *w, int *h, int *x, int *y)
 static void
 sdl_blit(int x, int y, int y1, int y2, int w, int h)
 {
+    const video_span_t *spans;
     SDL_Rect r_src;
-    int ret;
+    int i, nspans, ret;
 
-    if (!sdl_enabled || (y1 == y2) || (h <= 0) || (render_buffer == NULL) || (sdl_render == NULL) || (sdl_tex == NULL)) {
-	video_blit_complete();
+    if (!sdl_enabled || (y1 == y2) || (h <= 0) || (render_buffer == NULL) || (sdl_render == NULL) || (sdl_tex == NULL))
 	return;
-    }
 
     SDL_LockMutex(sdl_mutex);
 
-    r_src.x = 0;
-    r_src.y = y1;
-    r_src.w = w;
-    r_src.h = y2 - y1;
-    SDL_UpdateTexture(sdl_tex, &r_src, &(render_buffer->dat)[y1 * w], w * 4);
-    video_blit_complete();
+    /* Only upload the rows that changed. */
+    nspans = video_blit_get_spans(&spans);
+    for (i = 0; i < nspans; i++) {
+	r_src.x = 0;
+	r_src.y = spans[i].y1;
+	r_src.w = w;
+	r_src.h = spans[i].y2 - spans[i].y1;
+	SDL_UpdateTexture(sdl_tex, &r_src, &(render_buffer->dat)[spans[i].y1 * w], w * 4);
+    }
 
     SDL_RenderClear(sdl_render);
 